@@ -51,6 +51,12 @@ typedef ck_spinlock_t nx_spinlock_t;
  */
 #define atomic_add_uint32(var, val) ck_pr_add_32(var, val)
 
+/**
+ *    Function like macro for atomically subtracting from the uint32 variable pointed to by var.
+ *    @param var A pointer to a uint32 variable.
+ */
+#define atomic_sub_uint32(var, val) ck_pr_sub_32(var, val)
+
 /**
  *    Function like macro for atomically decrementing the uint32 variable pointed to by var.
  *    @param var A pointer to a uint32 variable.
@@ -77,6 +83,19 @@ typedef ck_spinlock_t nx_spinlock_t;
  */
 #define atomic_store_uint32(var, val) ck_pr_store_32(var, val)
 
+/**
+ *    Function like macro for atomically loading the value of the uint64 pointed to by var and return the result.
+ *    @param var A pointer to a uint64 variable to atomically load/read the value from.
+ */
+#define atomic_load_uint64(var) ck_pr_load_64(var)
+
+/**
+ *    Function like macro for atomically storing the value val to the uint64 variable var.
+ *    @param var A pointer to uint64 variable to atomically store to.
+ *    @param val The value to store in the variable var.
+ */
+#define atomic_store_uint64(var, val) ck_pr_store_64(var, val)
+
 /**
  *    Function like macro for atomically storing the value val to the the variable
  *    var.
@@ -85,6 +104,39 @@ typedef ck_spinlock_t nx_spinlock_t;
  */
 #define atomic_store_int32(var, val) ck_pr_store_int(var, val)
 
+/**
+ *    Function like macro for atomically swapping the int32 pointed to by var to set,
+ *    if it still equals compare. Returns true if the swap happened.
+ *    @param var A pointer to a int32 variable.
+ *    @param compare The value var must hold for the swap to happen.
+ *    @param set The value to store in var.
+ */
+#define atomic_cas_int32(var, compare, set) ck_pr_cas_int(var, compare, set)
+
+/**
+ *    Function like macro for atomically swapping the uint64 pointed to by var to set,
+ *    if it still equals compare. Returns true if the swap happened.
+ *    @param var A pointer to a uint64 variable.
+ *    @param compare The value var must hold for the swap to happen.
+ *    @param set The value to store in var.
+ */
+#define atomic_cas_uint64(var, compare, set) ck_pr_cas_64(var, compare, set)
+
+/**
+ *    Function like macro for atomically loading the uint8 pointed to by var.
+ *    @param var A pointer to a uint8 variable.
+ */
+#define atomic_load_uint8(var) ck_pr_load_8(var)
+
+/**
+ *    Function like macro for atomically swapping the uint8 pointed to by var to set,
+ *    if it still equals compare. Returns true if the swap happened.
+ *    @param var A pointer to a uint8 variable.
+ *    @param compare The value var must hold for the swap to happen.
+ *    @param set The value to store in var.
+ */
+#define atomic_cas_uint8(var, compare, set) ck_pr_cas_8(var, compare, set)
+
 /**
  *    Function like macro for atomically loading a pointer.
  *    @param var A pointer to uint32 variable to atomically load/read from.
@@ -99,6 +151,23 @@ typedef ck_spinlock_t nx_spinlock_t;
  */
 #define atomic_store_ptr(var, ptr) ck_pr_store_ptr(var, ptr)
 
+/**
+ *    Function like macro for ordering stores, stores before the fence are visible
+ *    to other processors before any stores after it.
+ */
+#define atomic_fence_store() ck_pr_fence_store()
+
+/**
+ *    Function like macro for ordering loads, loads after the fence can't be
+ *    satisfied before loads that come before it.
+ */
+#define atomic_fence_load() ck_pr_fence_load()
+
+/**
+ *    Function like macro for telling the processor we are in a spin wait loop.
+ */
+#define atomic_stall() ck_pr_stall()
+
 #define NX_LIST_HEAD(name,type)
 #define NX_LIST_ENTRY(x) CK_LIST_ENTRY(x) list_entry
 #define NX_SLIST_ENTRY(x) CK_SLIST_ENTRY(x) list_entry
@@ -0,0 +1,338 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+#include "coverage.h"
+#include "concurrent/concurrent.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define COVERAGE_X86
+#include <immintrin.h>
+#endif
+
+/* Byte to bucket lookup for the scalar kernel and the slow paths. */
+static const uint8_t bucket_lookup[256] = {
+
+    [0] = 0,
+    [1] = 1,
+    [2] = 2,
+    [3] = 3,
+    [4 ... 7] = 8,
+    [8 ... 15] = 16,
+    [16 ... 31] = 32,
+    [32 ... 127] = 64,
+    [128 ... 255] = 128
+
+};
+
+/* Clear the bits byte hit from virgin. Another child may be clearing bits in
+   the same byte so we swap it instead of storing to it. */
+static int32_t merge_byte(uint8_t byte, uint8_t *virgin, uint32_t *new_edges)
+{
+    uint8_t old = atomic_load_uint8(virgin);
+
+    while((old & byte) != 0)
+    {
+        if(atomic_cas_uint8(virgin, old, (uint8_t)(old & ~byte)) == true)
+        {
+            /* Nothing ever hit this edge before. */
+            if(old == 0xFF)
+            {
+                (*new_edges)++;
+                return (COVERAGE_NEW_EDGES);
+            }
+
+            return (COVERAGE_NEW_HITS);
+        }
+
+        old = atomic_load_uint8(virgin);
+    }
+
+    return (COVERAGE_NONE);
+}
+
+/* Merge len bytes of trace into virgin one byte at a time. */
+static int32_t merge_bytes(const uint8_t *trace, uint8_t *virgin, uint32_t len, uint32_t *new_edges)
+{
+    uint32_t i;
+    int32_t ret = COVERAGE_NONE;
+
+    for(i = 0; i < len; i++)
+    {
+        if(trace[i] == 0)
+            continue;
+
+        int32_t rtrn = merge_byte(trace[i], &virgin[i], new_edges);
+        if(rtrn > ret)
+            ret = rtrn;
+    }
+
+    return (ret);
+}
+
+static void classify_scalar(uint8_t *trace)
+{
+    uint32_t i;
+    uint32_t j;
+
+    /* Most of the map is zero, skip it a word at a time. */
+    for(i = 0; i < COVERAGE_MAP_SIZE; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+
+        memcpy(&word, &trace[i], sizeof(uint64_t));
+        if(word == 0)
+            continue;
+
+        for(j = i; j < i + sizeof(uint64_t); j++)
+            trace[j] = bucket_lookup[trace[j]];
+    }
+
+    return;
+}
+
+static int32_t new_bits_scalar(const uint8_t *trace, uint8_t *virgin, uint32_t *new_edges)
+{
+    uint32_t i;
+    int32_t ret = COVERAGE_NONE;
+
+    for(i = 0; i < COVERAGE_MAP_SIZE; i += sizeof(uint64_t))
+    {
+        uint64_t t;
+        uint64_t v;
+
+        memcpy(&t, &trace[i], sizeof(uint64_t));
+        memcpy(&v, &virgin[i], sizeof(uint64_t));
+        if((t & v) == 0)
+            continue;
+
+        int32_t rtrn = merge_bytes(&trace[i], &virgin[i], sizeof(uint64_t), new_edges);
+        if(rtrn > ret)
+            ret = rtrn;
+    }
+
+    return (ret);
+}
+
+#ifdef COVERAGE_X86
+
+/* Unsigned x >= c for each byte, SSE2 has no unsigned compare so we use max. */
+#define sse2_ge(x, c) _mm_cmpeq_epi8(_mm_max_epu8(x, c), x)
+
+static void classify_sse2(uint8_t *trace)
+{
+    uint32_t i;
+    const __m128i zero = _mm_setzero_si128();
+
+    for(i = 0; i < COVERAGE_MAP_SIZE; i += sizeof(__m128i))
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)&trace[i]);
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(x, zero)) == 0xFFFF)
+            continue;
+
+        __m128i ge4 = sse2_ge(x, _mm_set1_epi8(4));
+        __m128i ge8 = sse2_ge(x, _mm_set1_epi8(8));
+        __m128i ge16 = sse2_ge(x, _mm_set1_epi8(16));
+        __m128i ge32 = sse2_ge(x, _mm_set1_epi8(32));
+        __m128i ge128 = sse2_ge(x, _mm_set1_epi8((char)128));
+
+        /* Counts under four are their own bucket, each bucket
+           above that covers the counts between two thresholds. */
+        __m128i r = _mm_andnot_si128(ge4, x);
+        r = _mm_or_si128(r, _mm_and_si128(_mm_andnot_si128(ge8, ge4), _mm_set1_epi8(8)));
+        r = _mm_or_si128(r, _mm_and_si128(_mm_andnot_si128(ge16, ge8), _mm_set1_epi8(16)));
+        r = _mm_or_si128(r, _mm_and_si128(_mm_andnot_si128(ge32, ge16), _mm_set1_epi8(32)));
+        r = _mm_or_si128(r, _mm_and_si128(_mm_andnot_si128(ge128, ge32), _mm_set1_epi8(64)));
+        r = _mm_or_si128(r, _mm_and_si128(ge128, _mm_set1_epi8((char)128)));
+
+        _mm_storeu_si128((__m128i *)&trace[i], r);
+    }
+
+    return;
+}
+
+static int32_t new_bits_sse2(const uint8_t *trace, uint8_t *virgin, uint32_t *new_edges)
+{
+    uint32_t i;
+    int32_t ret = COVERAGE_NONE;
+    const __m128i zero = _mm_setzero_si128();
+
+    for(i = 0; i < COVERAGE_MAP_SIZE; i += sizeof(__m128i))
+    {
+        __m128i t = _mm_loadu_si128((const __m128i *)&trace[i]);
+        __m128i v = _mm_loadu_si128((const __m128i *)&virgin[i]);
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(t, v), zero)) == 0xFFFF)
+            continue;
+
+        int32_t rtrn = merge_bytes(&trace[i], &virgin[i], sizeof(__m128i), new_edges);
+        if(rtrn > ret)
+            ret = rtrn;
+    }
+
+    return (ret);
+}
+
+#define avx2_ge(x, c) _mm256_cmpeq_epi8(_mm256_max_epu8(x, c), x)
+
+__attribute__((target("avx2"))) static void classify_avx2(uint8_t *trace)
+{
+    uint32_t i;
+
+    for(i = 0; i < COVERAGE_MAP_SIZE; i += sizeof(__m256i))
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)&trace[i]);
+        if(_mm256_testz_si256(x, x) != 0)
+            continue;
+
+        __m256i ge4 = avx2_ge(x, _mm256_set1_epi8(4));
+        __m256i ge8 = avx2_ge(x, _mm256_set1_epi8(8));
+        __m256i ge16 = avx2_ge(x, _mm256_set1_epi8(16));
+        __m256i ge32 = avx2_ge(x, _mm256_set1_epi8(32));
+        __m256i ge128 = avx2_ge(x, _mm256_set1_epi8((char)128));
+
+        __m256i r = _mm256_andnot_si256(ge4, x);
+        r = _mm256_or_si256(r, _mm256_and_si256(_mm256_andnot_si256(ge8, ge4), _mm256_set1_epi8(8)));
+        r = _mm256_or_si256(r, _mm256_and_si256(_mm256_andnot_si256(ge16, ge8), _mm256_set1_epi8(16)));
+        r = _mm256_or_si256(r, _mm256_and_si256(_mm256_andnot_si256(ge32, ge16), _mm256_set1_epi8(32)));
+        r = _mm256_or_si256(r, _mm256_and_si256(_mm256_andnot_si256(ge128, ge32), _mm256_set1_epi8(64)));
+        r = _mm256_or_si256(r, _mm256_and_si256(ge128, _mm256_set1_epi8((char)128)));
+
+        _mm256_storeu_si256((__m256i *)&trace[i], r);
+    }
+
+    return;
+}
+
+__attribute__((target("avx2"))) static int32_t new_bits_avx2(const uint8_t *trace,
+                                                             uint8_t *virgin,
+                                                             uint32_t *new_edges)
+{
+    uint32_t i;
+    int32_t ret = COVERAGE_NONE;
+
+    for(i = 0; i < COVERAGE_MAP_SIZE; i += sizeof(__m256i))
+    {
+        __m256i t = _mm256_loadu_si256((const __m256i *)&trace[i]);
+        __m256i v = _mm256_loadu_si256((const __m256i *)&virgin[i]);
+        if(_mm256_testz_si256(t, v) != 0)
+            continue;
+
+        int32_t rtrn = merge_bytes(&trace[i], &virgin[i], sizeof(__m256i), new_edges);
+        if(rtrn > ret)
+            ret = rtrn;
+    }
+
+    return (ret);
+}
+
+#endif
+
+/* Scalar until setup picks something faster. */
+static void (*classify_kernel)(uint8_t *trace) = &classify_scalar;
+
+static int32_t (*new_bits_kernel)(const uint8_t *trace, uint8_t *virgin, uint32_t *new_edges) = &new_bits_scalar;
+
+int32_t coverage_use_kernel(enum coverage_kernel kernel)
+{
+    switch(kernel)
+    {
+        case COVERAGE_SCALAR:
+            classify_kernel = &classify_scalar;
+            new_bits_kernel = &new_bits_scalar;
+            return (0);
+
+#ifdef COVERAGE_X86
+
+        case COVERAGE_SSE2:
+            if(__builtin_cpu_supports("sse2") == 0)
+                return (-1);
+
+            classify_kernel = &classify_sse2;
+            new_bits_kernel = &new_bits_sse2;
+            return (0);
+
+        case COVERAGE_AVX2:
+            if(__builtin_cpu_supports("avx2") == 0)
+                return (-1);
+
+            classify_kernel = &classify_avx2;
+            new_bits_kernel = &new_bits_avx2;
+            return (0);
+
+#endif
+
+        default:
+            return (-1);
+    }
+}
+
+void setup_coverage_module(void)
+{
+    /* Try the widest kernel first, scalar always works. */
+    if(coverage_use_kernel(COVERAGE_AVX2) == 0)
+        return;
+
+    if(coverage_use_kernel(COVERAGE_SSE2) == 0)
+        return;
+
+    (void)coverage_use_kernel(COVERAGE_SCALAR);
+
+    return;
+}
+
+uint8_t *coverage_create_map(uint8_t fill,
+                             struct memory_allocator *allocator,
+                             struct output_writter *output)
+{
+    uint8_t *map = allocator->shared(COVERAGE_MAP_SIZE);
+    if(map == NULL)
+    {
+        output->write(ERROR, "Can't allocate coverage map\n");
+        return (NULL);
+    }
+
+    memset(map, fill, COVERAGE_MAP_SIZE);
+
+    return (map);
+}
+
+void coverage_free_map(uint8_t **map, struct memory_allocator *allocator)
+{
+    allocator->free_shared((void **)map, COVERAGE_MAP_SIZE);
+
+    return;
+}
+
+void coverage_reset(uint8_t *trace)
+{
+    memset(trace, 0, COVERAGE_MAP_SIZE);
+
+    return;
+}
+
+void coverage_classify(uint8_t *trace)
+{
+    classify_kernel(trace);
+
+    return;
+}
+
+int32_t coverage_has_new_bits(const uint8_t *trace, uint8_t *virgin, uint32_t *new_edges)
+{
+    (*new_edges) = 0;
+
+    return (new_bits_kernel(trace, virgin, new_edges));
+}
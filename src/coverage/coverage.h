@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include "io/io.h"
+#include "memory/memory.h"
+
+#include <stdint.h>
+
+/* Number of edges we track, one byte of hit count per edge like AFL. */
+#define COVERAGE_MAP_SIZE (1 << 16)
+
+/* Environment variable an instrumented target finds the trace map's path in. */
+#define COVERAGE_TRACE_ENV "NEXTGEN_COVERAGE"
+
+/* What coverage_has_new_bits() found. */
+enum coverage_result { COVERAGE_NONE, COVERAGE_NEW_HITS, COVERAGE_NEW_EDGES };
+
+/* The implementations of the map comparisons, the fastest
+   one the processor supports is picked at setup. */
+enum coverage_kernel { COVERAGE_SCALAR, COVERAGE_SSE2, COVERAGE_AVX2 };
+
+/**
+ * Create a map of COVERAGE_MAP_SIZE bytes in shared memory. Trace maps are
+ * created with zero and the virgin map with 0xFF, every bit not hit yet.
+ * @param fill The byte to fill the map with.
+ * @param allocator A memory allocator object.
+ * @param output An output writter object.
+ * @return The map on success and NULL on failure.
+ */
+extern uint8_t *coverage_create_map(uint8_t fill,
+                                    struct memory_allocator *allocator,
+                                    struct output_writter *output);
+
+extern void coverage_free_map(uint8_t **map, struct memory_allocator *allocator);
+
+/* Clear the trace map before an execution. */
+extern void coverage_reset(uint8_t *trace);
+
+/**
+ * Round the hit counts in trace down to AFL's buckets, 1, 2, 3, 4-7, 8-15,
+ * 16-31, 32-127 and 128+, so a loop running one more time isn't new.
+ */
+extern void coverage_classify(uint8_t *trace);
+
+/**
+ * Compare a classified trace against the virgin map and clear the bits it hit
+ * from virgin. Safe to call from several processes sharing one virgin map.
+ * @param trace The classified trace map of the last execution.
+ * @param virgin The virgin map.
+ * @param new_edges Where the number of edges hit for the first time is placed.
+ * @return COVERAGE_NEW_EDGES if an edge was hit for the first time, COVERAGE_NEW_HITS
+ * if only an edge's bucket was new and COVERAGE_NONE if nothing was new.
+ */
+extern int32_t coverage_has_new_bits(const uint8_t *trace, uint8_t *virgin, uint32_t *new_edges);
+
+/**
+ * Use kernel for the map comparisons.
+ * @return Zero on success and negative one if this processor can't run kernel.
+ */
+extern int32_t coverage_use_kernel(enum coverage_kernel kernel);
+
+/* Pick the fastest kernel this processor supports. */
+extern void setup_coverage_module(void);
+
+#endif
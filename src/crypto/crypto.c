@@ -82,6 +82,21 @@ static int32_t default_rand_range(uint32_t range, uint32_t *number)
     return (0);
 }
 
+static int32_t default_rand_bytes(char **buf, uint32_t length)
+{
+    int32_t rtrn = RAND_bytes((unsigned char *)*buf, (int32_t)length);
+    if(rtrn != 1)
+    {
+        printf("Can't get random bytes\n");
+        return (-1);
+    }
+
+    /* Callers allocate one byte more than length for the terminator. */
+    (*buf)[length] = '\0';
+
+    return (0);
+}
+
 static int32_t default_seed_prng(void)
 {
      return (0);
@@ -100,6 +115,7 @@ struct random_generator *get_default_random_generator(struct memory_allocator *a
     }
 
     random->range = &default_rand_range;
+    random->bytes = &default_rand_bytes;
     random->seed = &default_seed_prng;
 
     return (random);
@@ -0,0 +1,358 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+#ifdef LINUX
+
+/* We need to define _GNU_SOURCE to use
+ asprintf on Linux. We also need to place
+ _GNU_SOURCE at the top of the file before
+ any other includes for it to work properly. */
+#define _GNU_SOURCE
+
+#endif
+
+#include "cache.h"
+#include "disas.h"
+#include "utils/utils.h"
+#include "utils/autoclose.h"
+#include "utils/autofree.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Constants from xxHash, we want something fast enough to run over a 100 MiB
+   target on every start, it only has to notice the target changed. */
+#define HASH_PRIME1 0x9E3779B185EBCA87ULL
+#define HASH_PRIME2 0xC2B2AE3D27D4EB4FULL
+
+static uint64_t rotate_left(uint64_t x, uint32_t n)
+{
+    return ((x << n) | (x >> (64 - n)));
+}
+
+static uint64_t hash_buffer(const char *buf, uint64_t size)
+{
+    uint64_t i;
+    uint64_t word = 0;
+    uint64_t hash = size * HASH_PRIME1;
+
+    for(i = 0; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        memcpy(&word, &buf[i], sizeof(uint64_t));
+        hash = rotate_left(hash ^ (word * HASH_PRIME2), 31) * HASH_PRIME1;
+    }
+
+    /* Fold in the tail that doesn't fill a word. */
+    word = 0;
+    memcpy(&word, &buf[i], (size_t)(size - i));
+    hash = rotate_left(hash ^ (word * HASH_PRIME2), 31) * HASH_PRIME1;
+
+    /* Let every input bit reach every output bit. */
+    hash ^= hash >> 33;
+    hash *= HASH_PRIME2;
+    hash ^= hash >> 29;
+
+    return (hash);
+}
+
+int32_t get_analysis_key(const char *buf,
+                         uint64_t size,
+                         struct analysis_key *key,
+                         struct output_writter *output)
+{
+    memset(key, 0, sizeof(struct analysis_key));
+
+    key->hash = hash_buffer(buf, size);
+    key->size = size;
+
+    /* Not every target has a build-id, the hash alone is enough then. */
+    if(get_build_id(buf, size, key->build_id, &key->build_id_size, output) < 0)
+    {
+        output->write(ERROR, "Can't read build-id\n");
+        return (-1);
+    }
+
+    return (0);
+}
+
+/* Caches go in NEXTGEN_CACHE, or ~/.cache/nextgen when it isn't set. */
+static int32_t get_cache_dir(char **dir, struct output_writter *output)
+{
+    int32_t rtrn = 0;
+    char *home auto_free = NULL;
+    char *parent auto_free = NULL;
+
+    char *env = getenv(ANALYSIS_CACHE_ENV);
+    if(env != NULL)
+    {
+        rtrn = asprintf(dir, "%s", env);
+        if(rtrn < 0)
+        {
+            output->write(ERROR, "Can't create cache path: %s\n", strerror(errno));
+            return (-1);
+        }
+
+        return (0);
+    }
+
+    rtrn = get_home(&home);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't get home directory\n");
+        return (-1);
+    }
+
+    if(asprintf(&parent, "%s/.cache", home) < 0 ||
+       asprintf(dir, "%s/.cache/nextgen", home) < 0)
+    {
+        output->write(ERROR, "Can't create cache path: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    /* Make the directories the first time we run. */
+    if((mkdir(parent, 0700) < 0 && errno != EEXIST) ||
+       (mkdir((*dir), 0700) < 0 && errno != EEXIST))
+    {
+        output->write(ERROR, "mkdir: %s\n", strerror(errno));
+        free((*dir));
+        (*dir) = NULL;
+        return (-1);
+    }
+
+    return (0);
+}
+
+/* One cache per target, named after the target's hash. */
+static int32_t get_cache_path(const struct analysis_key *key, char **path, struct output_writter *output)
+{
+    char *dir auto_free = NULL;
+
+    if(get_cache_dir(&dir, output) < 0)
+    {
+        output->write(ERROR, "Can't get cache directory\n");
+        return (-1);
+    }
+
+    if(asprintf(path, "%s/%016llx.nxa", dir, (unsigned long long)key->hash) < 0)
+    {
+        output->write(ERROR, "Can't create cache path: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    return (0);
+}
+
+/* Make sure count entries of size bytes at offset fit in an image of image_size bytes. */
+static int32_t check_range(uint64_t offset, uint64_t count, uint64_t size, uint64_t image_size)
+{
+    if(offset > image_size || count > (image_size - offset) / size)
+        return (-1);
+
+    return (0);
+}
+
+static int32_t check_analysis(const struct analysis_header *analysis,
+                              const struct analysis_key *key,
+                              uint64_t file_size)
+{
+    if(analysis->magic != ANALYSIS_MAGIC || analysis->version != ANALYSIS_VERSION)
+        return (-1);
+
+    if(analysis->image_size != file_size)
+        return (-1);
+
+    if(analysis->key.hash != key->hash || analysis->key.size != key->size ||
+       analysis->key.build_id_size != key->build_id_size ||
+       memcmp(analysis->key.build_id, key->build_id, key->build_id_size) != 0)
+        return (-1);
+
+    /* A truncated or corrupt cache must not send us past the end of the mapping. */
+    if(check_range(analysis->blocks_offset, analysis->total_blocks, sizeof(uint64_t), file_size) < 0 ||
+       check_range(analysis->branches_offset, analysis->total_branches, sizeof(uint64_t), file_size) < 0 ||
+       check_range(analysis->functions_offset, analysis->total_functions,
+                   sizeof(struct analysis_function), file_size) < 0 ||
+       check_range(analysis->strings_offset, analysis->strings_size, 1, file_size) < 0)
+        return (-1);
+
+    /* Every name has to end inside the string table. */
+    if(analysis->strings_size > 0 &&
+       ((const char *)analysis)[analysis->strings_offset + analysis->strings_size - 1] != '\0')
+        return (-1);
+
+    uint64_t i;
+    const uint64_t *blocks = analysis_blocks(analysis);
+    const struct analysis_function *functions = analysis_functions(analysis);
+
+    /* Block probes are looked up with a binary search, so the blocks have to be in order. */
+    for(i = 1; i < analysis->total_blocks; i++)
+    {
+        if(blocks[i - 1] >= blocks[i])
+            return (-1);
+    }
+
+    for(i = 0; i < analysis->total_functions; i++)
+    {
+        if(functions[i].name >= analysis->strings_size)
+            return (-1);
+    }
+
+    return (0);
+}
+
+struct analysis_header *load_analysis(const struct analysis_key *key,
+                                      struct output_writter *output)
+{
+    struct stat sb;
+    char *path auto_free = NULL;
+    int32_t fd auto_close = 0;
+
+    if(get_cache_path(key, &path, output) < 0)
+        return (NULL);
+
+    fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return (NULL);
+
+    if(fstat(fd, &sb) < 0 || (uint64_t)sb.st_size < sizeof(struct analysis_header))
+        return (NULL);
+
+    struct analysis_header *analysis = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(analysis == MAP_FAILED)
+    {
+        output->write(ERROR, "mmap: %s\n", strerror(errno));
+        return (NULL);
+    }
+
+    /* A stale or damaged cache is a miss, it's rebuilt and replaced. */
+    if(check_analysis(analysis, key, (uint64_t)sb.st_size) < 0)
+    {
+        munmap(analysis, (size_t)sb.st_size);
+        return (NULL);
+    }
+
+    return (analysis);
+}
+
+struct analysis_header *create_analysis(const struct analysis_key *key,
+                                        const uint64_t *blocks,
+                                        uint64_t total_blocks,
+                                        const uint64_t *branches,
+                                        uint64_t total_branches,
+                                        const struct analysis_function *functions,
+                                        uint64_t total_functions,
+                                        const char *strings,
+                                        uint64_t strings_size,
+                                        struct output_writter *output)
+{
+    uint64_t offset = sizeof(struct analysis_header);
+
+    uint64_t blocks_offset = offset;
+    offset += total_blocks * sizeof(uint64_t);
+
+    uint64_t branches_offset = offset;
+    offset += total_branches * sizeof(uint64_t);
+
+    uint64_t functions_offset = offset;
+    offset += total_functions * sizeof(struct analysis_function);
+
+    uint64_t strings_offset = offset;
+    offset += strings_size;
+
+    struct analysis_header *analysis = calloc(1, (size_t)offset);
+    if(analysis == NULL)
+    {
+        output->write(ERROR, "Can't allocate analysis: %s\n", strerror(errno));
+        return (NULL);
+    }
+
+    analysis->magic = ANALYSIS_MAGIC;
+    analysis->version = ANALYSIS_VERSION;
+    memcpy(&analysis->key, key, sizeof(struct analysis_key));
+    analysis->image_size = offset;
+    analysis->total_blocks = total_blocks;
+    analysis->blocks_offset = blocks_offset;
+    analysis->total_branches = total_branches;
+    analysis->branches_offset = branches_offset;
+    analysis->total_functions = total_functions;
+    analysis->functions_offset = functions_offset;
+    analysis->strings_size = strings_size;
+    analysis->strings_offset = strings_offset;
+
+    char *image = (char *)analysis;
+
+    memcpy(image + blocks_offset, blocks, total_blocks * sizeof(uint64_t));
+    memcpy(image + branches_offset, branches, total_branches * sizeof(uint64_t));
+    memcpy(image + functions_offset, functions, total_functions * sizeof(struct analysis_function));
+    memcpy(image + strings_offset, strings, strings_size);
+
+    return (analysis);
+}
+
+int32_t save_analysis(const struct analysis_header *analysis, struct output_writter *output)
+{
+    char *path auto_free = NULL;
+    char *tmp_path auto_free = NULL;
+    int32_t fd auto_close = 0;
+    uint64_t written = 0;
+
+    if(get_cache_path(&analysis->key, &path, output) < 0)
+        return (-1);
+
+    if(asprintf(&tmp_path, "%s.XXXXXX", path) < 0)
+    {
+        output->write(ERROR, "Can't create cache path: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    /* Write to a temporary file and rename it over the cache, so another
+       nextgen starting up never maps half a cache. */
+    fd = mkstemp(tmp_path);
+    if(fd < 0)
+    {
+        output->write(ERROR, "mkstemp: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    while(written < analysis->image_size)
+    {
+        ssize_t ret = write(fd, (const char *)analysis + written, (size_t)(analysis->image_size - written));
+        if(ret < 0)
+        {
+            if(errno == EINTR)
+                continue;
+
+            output->write(ERROR, "write: %s\n", strerror(errno));
+            (void)unlink(tmp_path);
+            return (-1);
+        }
+
+        written += (uint64_t)ret;
+    }
+
+    if(rename(tmp_path, path) < 0)
+    {
+        output->write(ERROR, "rename: %s\n", strerror(errno));
+        (void)unlink(tmp_path);
+        return (-1);
+    }
+
+    return (0);
+}
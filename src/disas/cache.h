@@ -0,0 +1,155 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "io/io.h"
+
+#include <stdint.h>
+
+/* "NXAC" in little endian, at the start of every analysis cache file. */
+#define ANALYSIS_MAGIC 0x4341584EU
+
+/* Bump this whenever the layout below changes, old caches are then rebuilt. */
+#define ANALYSIS_VERSION 1
+
+/* Longest build-id we keep, GNU ld makes 20 byte ones by default. */
+#define BUILD_ID_MAX 64
+
+/* Directory the caches go in, overrides ~/.cache/nextgen. */
+#define ANALYSIS_CACHE_ENV "NEXTGEN_CACHE"
+
+/* What a cache is built from, it's only used when all of this matches the target. */
+struct analysis_key
+{
+    /* Hash of the whole executable. */
+    uint64_t hash;
+
+    uint64_t size;
+
+    uint32_t build_id_size;
+
+    const char padding[4];
+
+    uint8_t build_id[BUILD_ID_MAX];
+};
+
+/**
+ * The analysis of a target. The arrays follow the header in the same block
+ * of memory at the offsets given, so the file on disk is used as is once it's
+ * mapped. All addresses are link time addresses.
+ */
+struct analysis_header
+{
+    uint32_t magic;
+
+    uint32_t version;
+
+    struct analysis_key key;
+
+    /* Size of the header and everything after it. */
+    uint64_t image_size;
+
+    /* Where main() is, or the entry point if the target is stripped. */
+    uint64_t main_address;
+
+    /* The address after the last instruction. */
+    uint64_t end_address;
+
+    /* Basic block start addresses, sorted with no duplicates. */
+    uint64_t total_blocks;
+    uint64_t blocks_offset;
+
+    /* Addresses of the jump instructions, sorted. */
+    uint64_t total_branches;
+    uint64_t branches_offset;
+
+    /* Function symbols, sorted by address. */
+    uint64_t total_functions;
+    uint64_t functions_offset;
+
+    /* The symbol names, NUL terminated. */
+    uint64_t strings_size;
+    uint64_t strings_offset;
+};
+
+struct analysis_function
+{
+    uint64_t address;
+
+    uint64_t size;
+
+    /* Offset of the name in the string table. */
+    uint64_t name;
+};
+
+#define analysis_blocks(a) ((const uint64_t *)((const char *)(a) + (a)->blocks_offset))
+
+#define analysis_branches(a) ((const uint64_t *)((const char *)(a) + (a)->branches_offset))
+
+#define analysis_functions(a) \
+    ((const struct analysis_function *)((const char *)(a) + (a)->functions_offset))
+
+#define analysis_name(a, f) ((const char *)(a) + (a)->strings_offset + (f)->name)
+
+/**
+ * Hash the executable in buf and find it's build-id.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t get_analysis_key(const char *buf,
+                                uint64_t size,
+                                struct analysis_key *key,
+                                struct output_writter *output);
+
+/**
+ * Map the cached analysis for key from disk.
+ * @return The analysis or NULL if there is no usable cache for key.
+ */
+extern struct analysis_header *load_analysis(const struct analysis_key *key,
+                                             struct output_writter *output);
+
+/**
+ * Lay out a new analysis in one block of memory, free it with free().
+ * @param key The key of the target analyzed.
+ * @param blocks Sorted basic block start addresses.
+ * @param total_blocks Number of blocks.
+ * @param branches Sorted jump addresses.
+ * @param total_branches Number of jumps.
+ * @param functions Function symbols sorted by address, name holds an offset into strings.
+ * @param total_functions Number of functions.
+ * @param strings The symbol names.
+ * @param strings_size Size of strings.
+ * @param output An output writter object.
+ * @return The analysis on success and NULL on failure.
+ */
+extern struct analysis_header *create_analysis(const struct analysis_key *key,
+                                               const uint64_t *blocks,
+                                               uint64_t total_blocks,
+                                               const uint64_t *branches,
+                                               uint64_t total_branches,
+                                               const struct analysis_function *functions,
+                                               uint64_t total_functions,
+                                               const char *strings,
+                                               uint64_t strings_size,
+                                               struct output_writter *output);
+
+/**
+ * Write analysis to the cache directory, replacing any older cache for the same target.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t save_analysis(const struct analysis_header *analysis, struct output_writter *output);
+
+#endif
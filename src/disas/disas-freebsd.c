@@ -14,12 +14,12 @@
  **/
 
 #include "disas.h"
-#include "file/file.h"
 #include "io/io.h"
 
 #include <string.h>
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -28,25 +28,14 @@
 #include <sys/ptrace.h>
 #include <machine/reg.h>
 
-int32_t get_load_address(uint64_t *main_addr)
+int32_t get_load_address(char *exec_path, uint64_t *main_addr)
 {
-    (void)main_addr;
 	int32_t fd = 0;
-    int32_t rtrn = 0;
     GElf_Ehdr ehdr;
     Elf *elf = NULL;
-    char *path_to_exec = NULL;
-
-    /* Grab the executable path. */
-    rtrn = get_exec_path(&path_to_exec);
-    if(rtrn < 0)
-    {
-        output(ERROR, "Can't get target exec path\n");
-        return (-1);
-    }
 
     /* Open the file. */
-    fd = open(path_to_exec, O_RDONLY);
+    fd = open(exec_path, O_RDONLY);
     if(fd < 0)
     {
         output(ERROR, "open: %s\n", strerror(errno));
@@ -82,7 +71,7 @@ int32_t get_load_address(uint64_t *main_addr)
                 return (-1);
             }
 
-            set_start_addr(ehdr.e_entry);
+            (*main_addr) = ehdr.e_entry;
             
             break;
 
@@ -102,3 +91,99 @@ int32_t get_load_address(uint64_t *main_addr)
 
 	return (0);
 }
+
+int32_t get_code_sections(const char *buf,
+                          uint64_t size,
+                          struct code_section **sections,
+                          uint32_t *total,
+                          struct output_writter *output)
+{
+    size_t shnum = 0;
+    Elf *elf = NULL;
+    Elf_Scn *scn = NULL;
+    GElf_Shdr shdr;
+
+    if(elf_version(EV_CURRENT) == EV_NONE)
+    {
+        output->write(ERROR, "Can't init elf library: %s\n", elf_errmsg(elf_errno()));
+        return (-1);
+    }
+
+    elf = elf_memory((char *)buf, size);
+    if(elf == NULL || elf_kind(elf) != ELF_K_ELF || elf_getshdrnum(elf, &shnum) != 0)
+    {
+        output->write(ERROR, "Can't read an elf file: %s\n", elf_errmsg(elf_errno()));
+        if(elf != NULL)
+            elf_end(elf);
+        return (-1);
+    }
+
+    (*sections) = calloc(shnum, sizeof(struct code_section));
+    if((*sections) == NULL)
+    {
+        output->write(ERROR, "Can't allocate sections: %s\n", strerror(errno));
+        elf_end(elf);
+        return (-1);
+    }
+
+    (*total) = 0;
+
+    /* Only executable sections with bytes in the file hold code. */
+    while((scn = elf_nextscn(elf, scn)) != NULL && (*total) < shnum)
+    {
+        if(gelf_getshdr(scn, &shdr) == NULL)
+            continue;
+
+        if(shdr.sh_type != SHT_PROGBITS || (shdr.sh_flags & SHF_EXECINSTR) == 0)
+            continue;
+
+        if(shdr.sh_size == 0 || shdr.sh_offset + shdr.sh_size > size)
+            continue;
+
+        (*sections)[(*total)].code = (const uint8_t *)(buf + shdr.sh_offset);
+        (*sections)[(*total)].size = shdr.sh_size;
+        (*sections)[(*total)].address = shdr.sh_addr;
+        (*total)++;
+    }
+
+    elf_end(elf);
+
+    return (0);
+}
+
+int32_t get_build_id(const char *buf,
+                     uint64_t size,
+                     uint8_t *id,
+                     uint32_t *id_size,
+                     struct output_writter *output)
+{
+    (void)buf;
+    (void)size;
+    (void)id;
+    (void)output;
+
+    /* FreeBSD's linker doesn't always emit a build-id, the hash is enough. */
+    (*id_size) = 0;
+
+    return (0);
+}
+
+int32_t get_function_symbols(const char *buf,
+                             uint64_t size,
+                             struct analysis_function **functions,
+                             uint64_t *total,
+                             char **strings,
+                             uint64_t *strings_size,
+                             struct output_writter *output)
+{
+    (void)buf;
+    (void)size;
+    (void)output;
+
+    (*functions) = NULL;
+    (*total) = 0;
+    (*strings) = NULL;
+    (*strings_size) = 0;
+
+    return (0);
+}
@@ -1,24 +1,371 @@
-
-
 /**
  * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
- * 
+ *
  * Permission to use, copy, modify, and/or distribute this software for any purpose
- * with or without fee is hereby granted, provided that the above copyright notice 
+ * with or without fee is hereby granted, provided that the above copyright notice
  * and this permission notice appear in all copies.
- * 
- * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH 
- * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY 
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
  * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
- * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, 
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
  * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
  * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  **/
 
 #include "disas.h"
+#include "io/io.h"
+#include "utils/utils.h"
+#include "utils/autoclose.h"
+
+#include <elf.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/* Look for the main symbol in the symbol table section, returns zero if not found. */
+static uint64_t find_main(const char *buf, uint64_t size, const Elf64_Shdr *symtab)
+{
+    uint64_t i;
+    const Elf64_Ehdr *ehdr = (const Elf64_Ehdr *)buf;
+    const Elf64_Shdr *shdr = (const Elf64_Shdr *)(buf + ehdr->e_shoff);
+    const Elf64_Shdr *strtab = NULL;
+
+    if(symtab->sh_link >= ehdr->e_shnum)
+        return (0);
+
+    strtab = &shdr[symtab->sh_link];
+
+    /* Make sure both sections are inside the file. */
+    if(symtab->sh_offset + symtab->sh_size > size ||
+       strtab->sh_offset + strtab->sh_size > size)
+        return (0);
+
+    const Elf64_Sym *sym = (const Elf64_Sym *)(buf + symtab->sh_offset);
+    uint64_t total = symtab->sh_size / sizeof(Elf64_Sym);
+
+    for(i = 0; i < total; i++)
+    {
+        if(ELF64_ST_TYPE(sym[i].st_info) != STT_FUNC || sym[i].st_value == 0)
+            continue;
+
+        if(sym[i].st_name >= strtab->sh_size)
+            continue;
+
+        if(strcmp(buf + strtab->sh_offset + sym[i].st_name, "main") == 0)
+            return (sym[i].st_value);
+    }
+
+    return (0);
+}
+
+int32_t get_load_address(char *exec_path, uint64_t *main_addr)
+{
+    uint16_t i;
+    int32_t rtrn = 0;
+    uint64_t size = 0;
+    char *buf = NULL;
+    int32_t fd auto_close = 0;
+    struct output_writter *output = NULL;
+
+    /* Just grab the console writter in here so we don't break the old api. */
+    output = get_console_writter();
+    if(output == NULL)
+    {
+        printf("Failed to get console writter\n");
+        return (-1);
+    }
+
+    fd = open(exec_path, O_RDONLY);
+    if(fd < 0)
+    {
+        output->write(ERROR, "open: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    rtrn = map_file_in(fd, &buf, &size, READ, output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't memory map file\n");
+        return (-1);
+    }
+
+    const Elf64_Ehdr *ehdr = (const Elf64_Ehdr *)buf;
+
+    /* Let's make sure the file is a 64 bit elf file. */
+    if(size < sizeof(Elf64_Ehdr) ||
+       memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 ||
+       ehdr->e_ident[EI_CLASS] != ELFCLASS64)
+    {
+        output->write(ERROR, "Not a 64 bit ELF file\n");
+        munmap(buf, size);
+        return (-1);
+    }
+
+    /* Default to the entry point for stripped binaries. */
+    (*main_addr) = ehdr->e_entry;
+
+    if(ehdr->e_shoff != 0 &&
+       ehdr->e_shoff + (uint64_t)ehdr->e_shnum * sizeof(Elf64_Shdr) <= size)
+    {
+        const Elf64_Shdr *shdr = (const Elf64_Shdr *)(buf + ehdr->e_shoff);
+        uint64_t addr = 0;
+
+        /* Prefer the full symbol table and fall back to the dynamic one. */
+        for(i = 0; i < ehdr->e_shnum && addr == 0; i++)
+        {
+            if(shdr[i].sh_type == SHT_SYMTAB)
+                addr = find_main(buf, size, &shdr[i]);
+        }
+
+        for(i = 0; i < ehdr->e_shnum && addr == 0; i++)
+        {
+            if(shdr[i].sh_type == SHT_DYNSYM)
+                addr = find_main(buf, size, &shdr[i]);
+        }
+
+        if(addr != 0)
+            (*main_addr) = addr;
+    }
+
+    munmap(buf, size);
+
+    return (0);
+}
+
+int32_t get_code_sections(const char *buf,
+                          uint64_t size,
+                          struct code_section **sections,
+                          uint32_t *total,
+                          struct output_writter *output)
+{
+    uint16_t i;
+    const Elf64_Ehdr *ehdr = (const Elf64_Ehdr *)buf;
+
+    if(size < sizeof(Elf64_Ehdr) ||
+       memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 ||
+       ehdr->e_ident[EI_CLASS] != ELFCLASS64)
+    {
+        output->write(ERROR, "Not a 64 bit ELF file\n");
+        return (-1);
+    }
+
+    if(ehdr->e_shoff == 0 ||
+       ehdr->e_shoff + (uint64_t)ehdr->e_shnum * sizeof(Elf64_Shdr) > size)
+    {
+        output->write(ERROR, "The target has no section headers\n");
+        return (-1);
+    }
+
+    const Elf64_Shdr *shdr = (const Elf64_Shdr *)(buf + ehdr->e_shoff);
+
+    (*sections) = calloc(ehdr->e_shnum, sizeof(struct code_section));
+    if((*sections) == NULL)
+    {
+        output->write(ERROR, "Can't allocate sections: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    (*total) = 0;
+
+    /* Only executable sections with bytes in the file hold code, the rest would
+       just be data disassembled into nonsense. */
+    for(i = 0; i < ehdr->e_shnum; i++)
+    {
+        if(shdr[i].sh_type != SHT_PROGBITS || (shdr[i].sh_flags & SHF_EXECINSTR) == 0)
+            continue;
+
+        if(shdr[i].sh_size == 0 || shdr[i].sh_offset + shdr[i].sh_size > size)
+            continue;
+
+        (*sections)[(*total)].code = (const uint8_t *)(buf + shdr[i].sh_offset);
+        (*sections)[(*total)].size = shdr[i].sh_size;
+        (*sections)[(*total)].address = shdr[i].sh_addr;
+        (*total)++;
+    }
+
+    return (0);
+}
+
+int32_t get_build_id(const char *buf,
+                     uint64_t size,
+                     uint8_t *id,
+                     uint32_t *id_size,
+                     struct output_writter *output)
+{
+    uint16_t i;
+    const Elf64_Ehdr *ehdr = (const Elf64_Ehdr *)buf;
+
+    (*id_size) = 0;
+
+    if(size < sizeof(Elf64_Ehdr) ||
+       memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 ||
+       ehdr->e_ident[EI_CLASS] != ELFCLASS64)
+    {
+        output->write(ERROR, "Not a 64 bit ELF file\n");
+        return (-1);
+    }
+
+    /* No section headers just means no build-id. */
+    if(ehdr->e_shoff == 0 ||
+       ehdr->e_shoff + (uint64_t)ehdr->e_shnum * sizeof(Elf64_Shdr) > size)
+        return (0);
+
+    const Elf64_Shdr *shdr = (const Elf64_Shdr *)(buf + ehdr->e_shoff);
+
+    for(i = 0; i < ehdr->e_shnum; i++)
+    {
+        if(shdr[i].sh_type != SHT_NOTE || shdr[i].sh_offset + shdr[i].sh_size > size)
+            continue;
+
+        uint64_t offset = 0;
+        const char *notes = buf + shdr[i].sh_offset;
+
+        /* Walk the notes, names and descriptors are padded to four bytes. */
+        while(offset + sizeof(Elf64_Nhdr) <= shdr[i].sh_size)
+        {
+            const Elf64_Nhdr *note = (const Elf64_Nhdr *)(notes + offset);
+            uint64_t name_size = ((uint64_t)note->n_namesz + 3) & ~3ULL;
+            uint64_t desc_size = ((uint64_t)note->n_descsz + 3) & ~3ULL;
+            const char *name = notes + offset + sizeof(Elf64_Nhdr);
+
+            if(offset + sizeof(Elf64_Nhdr) + name_size + desc_size > shdr[i].sh_size)
+                break;
+
+            if(note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4 &&
+               memcmp(name, "GNU", 4) == 0 && note->n_descsz <= BUILD_ID_MAX)
+            {
+                memcpy(id, name + name_size, note->n_descsz);
+                (*id_size) = note->n_descsz;
+                return (0);
+            }
+
+            offset += sizeof(Elf64_Nhdr) + name_size + desc_size;
+        }
+    }
+
+    return (0);
+}
+
+static int compare_function(const void *a, const void *b)
+{
+    const struct analysis_function *x = a;
+    const struct analysis_function *y = b;
+
+    return ((x->address > y->address) - (x->address < y->address));
+}
+
+/* Copy the function symbols out of one symbol table section. */
+static int32_t read_functions(const char *buf,
+                              uint64_t size,
+                              const Elf64_Shdr *symtab,
+                              struct analysis_function **functions,
+                              uint64_t *total,
+                              char **strings,
+                              uint64_t *strings_size,
+                              struct output_writter *output)
+{
+    uint64_t i;
+    const Elf64_Ehdr *ehdr = (const Elf64_Ehdr *)buf;
+    const Elf64_Shdr *shdr = (const Elf64_Shdr *)(buf + ehdr->e_shoff);
+
+    if(symtab->sh_link >= ehdr->e_shnum)
+        return (0);
+
+    const Elf64_Shdr *strtab = &shdr[symtab->sh_link];
+
+    if(symtab->sh_offset + symtab->sh_size > size ||
+       strtab->sh_offset + strtab->sh_size > size || strtab->sh_size == 0)
+        return (0);
+
+    const Elf64_Sym *sym = (const Elf64_Sym *)(buf + symtab->sh_offset);
+    uint64_t count = symtab->sh_size / sizeof(Elf64_Sym);
+
+    (*functions) = calloc(count + 1, sizeof(struct analysis_function));
+    (*strings) = malloc(strtab->sh_size + 1);
+    if((*functions) == NULL || (*strings) == NULL)
+    {
+        output->write(ERROR, "Can't allocate symbols: %s\n", strerror(errno));
+        free((*functions));
+        free((*strings));
+        (*functions) = NULL;
+        (*strings) = NULL;
+        return (-1);
+    }
+
+    /* Keep the string table as is so the names can point into it. */
+    memcpy((*strings), buf + strtab->sh_offset, strtab->sh_size);
+    (*strings)[strtab->sh_size] = '\0';
+    (*strings_size) = strtab->sh_size + 1;
+
+    for(i = 0; i < count; i++)
+    {
+        if(ELF64_ST_TYPE(sym[i].st_info) != STT_FUNC || sym[i].st_value == 0)
+            continue;
+
+        if(sym[i].st_name >= strtab->sh_size)
+            continue;
+
+        (*functions)[(*total)].address = sym[i].st_value;
+        (*functions)[(*total)].size = sym[i].st_size;
+        (*functions)[(*total)].name = sym[i].st_name;
+        (*total)++;
+    }
+
+    qsort((*functions), (size_t)(*total), sizeof(struct analysis_function), &compare_function);
+
+    return (0);
+}
+
+int32_t get_function_symbols(const char *buf,
+                             uint64_t size,
+                             struct analysis_function **functions,
+                             uint64_t *total,
+                             char **strings,
+                             uint64_t *strings_size,
+                             struct output_writter *output)
+{
+    uint16_t i;
+    const Elf64_Ehdr *ehdr = (const Elf64_Ehdr *)buf;
+
+    (*functions) = NULL;
+    (*total) = 0;
+    (*strings) = NULL;
+    (*strings_size) = 0;
+
+    if(size < sizeof(Elf64_Ehdr) ||
+       memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 ||
+       ehdr->e_ident[EI_CLASS] != ELFCLASS64)
+    {
+        output->write(ERROR, "Not a 64 bit ELF file\n");
+        return (-1);
+    }
+
+    if(ehdr->e_shoff == 0 ||
+       ehdr->e_shoff + (uint64_t)ehdr->e_shnum * sizeof(Elf64_Shdr) > size)
+        return (0);
+
+    const Elf64_Shdr *shdr = (const Elf64_Shdr *)(buf + ehdr->e_shoff);
+
+    /* Prefer the full symbol table and fall back to the dynamic one. */
+    for(i = 0; i < ehdr->e_shnum && (*strings) == NULL; i++)
+    {
+        if(shdr[i].sh_type != SHT_SYMTAB)
+            continue;
+
+        if(read_functions(buf, size, &shdr[i], functions, total, strings, strings_size, output) < 0)
+            return (-1);
+    }
+
+    for(i = 0; i < ehdr->e_shnum && (*strings) == NULL; i++)
+    {
+        if(shdr[i].sh_type != SHT_DYNSYM)
+            continue;
+
+        if(read_functions(buf, size, &shdr[i], functions, total, strings, strings_size, output) < 0)
+            return (-1);
+    }
 
-int32_t get_load_address(uint64_t *main_addr)
-{ 
-	(void)main_addr;
-	return (0); 
+    return (0);
 }
@@ -17,8 +17,61 @@
 
 #include "disas.h"
 
-int32_t get_load_address(uint64_t *main_addr)
+int32_t get_load_address(char *exec_path, uint64_t *main_addr)
 { 
+	(void)exec_path;
 	(void)main_addr;
 	return (0); 
 }
+
+int32_t get_code_sections(const char *buf,
+                          uint64_t size,
+                          struct code_section **sections,
+                          uint32_t *total,
+                          struct output_writter *output)
+{
+    (void)buf;
+    (void)size;
+    (void)sections;
+    (void)total;
+
+    output->write(ERROR, "Mach-O executables are not supported yet\n");
+
+    return (-1);
+}
+
+int32_t get_build_id(const char *buf,
+                     uint64_t size,
+                     uint8_t *id,
+                     uint32_t *id_size,
+                     struct output_writter *output)
+{
+    (void)buf;
+    (void)size;
+    (void)id;
+    (void)output;
+
+    (*id_size) = 0;
+
+    return (0);
+}
+
+int32_t get_function_symbols(const char *buf,
+                             uint64_t size,
+                             struct analysis_function **functions,
+                             uint64_t *total,
+                             char **strings,
+                             uint64_t *strings_size,
+                             struct output_writter *output)
+{
+    (void)buf;
+    (void)size;
+    (void)output;
+
+    (*functions) = NULL;
+    (*total) = 0;
+    (*strings) = NULL;
+    (*strings_size) = 0;
+
+    return (0);
+}
@@ -15,9 +15,9 @@
 
 #include "disas.h"
 #include "capstone.h"
-#include "file/file.h"
 #include "io/io.h"
 #include "memory/memory.h"
+#include "runtime/platform.h"
 #include "utils/utils.h"
 #include "utils/autoclose.h"
 #include "utils/autofree.h"
@@ -25,227 +25,418 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
-int32_t disas_executable_and_examine(struct output_writter *output)
+/* The target's analysis, either mapped from the cache or built by us. */
+static struct analysis_header *analysis;
+
+/* A growing list of addresses. */
+struct address_list
 {
+    uint64_t *list;
+
+    uint64_t total;
+
+    /* Room in list before it has to grow. */
+    uint64_t space;
+};
+
+/* One section's worth of disassembly, each runs on it's own thread. */
+struct disas_job
+{
+    const struct code_section *section;
+
+    /* One bit per byte of the section, set where an instruction starts. */
+    uint8_t *starts;
+
+    /* Block starts found in this section, not sorted yet. */
+    struct address_list blocks;
+
+    /* Addresses of the jumps in this section. */
+    struct address_list branches;
+
+    /* The address after the last instruction we decoded. */
+    uint64_t end;
+
     int32_t rtrn;
-    uint64_t file_size;
-    uint32_t count = 0;
-    int32_t file auto_close = 0;
-    char *file_buffer = NULL;
-    char *exec_path auto_free = NULL;
 
-    /* Ask the file module for the path of the binary to test. */
-    rtrn = get_exec_path(&exec_path, output);
-    if(rtrn < 0)
-    {
-        output->write(ERROR, "Can't get exec path\n");
-        return -1;
-    }
+    const char padding[4];
+};
 
-    /* Open the target binary. */
-    file = open(exec_path, O_RDONLY);
-    if(file < 0)
+static int32_t add_address(struct address_list *list, uint64_t address)
+{
+    if(list->total == list->space)
     {
-        output->write(ERROR, "open: %s\n", strerror(errno));
-        return (-1);
-    }
+        uint64_t space = (list->space == 0) ? 1024 : list->space * 2;
 
-    /* Read file in to memory. */
-    rtrn = map_file_in(file, &file_buffer, &file_size, READ, output);
-    if(rtrn < 0)
-    {
-        output->write(ERROR, "Can't memory map file\n");
-        return (-1);
+        uint64_t *grown = realloc(list->list, space * sizeof(uint64_t));
+        if(grown == NULL)
+            return (-1);
+
+        list->list = grown;
+        list->space = space;
     }
 
-    /* Create a const pointer to the file buffer so we can avoid
-    a warning when using cs_disasm_iter(). */
-    const uint8_t *file_buffer_copy = (uint8_t *)file_buffer;
+    list->list[list->total] = address;
+    list->total++;
+
+    return (0);
+}
 
-    /* Create capstone handle.*/
+static void *disas_section(void *arg)
+{
+    struct disas_job *job = arg;
+    const struct code_section *section = job->section;
+    const uint8_t *code = section->code;
+    size_t code_size = (size_t)section->size;
+    uint64_t address = section->address;
     csh handle;
-    cs_open(CS_ARCH_X86, CS_MODE_32, &handle);
+
+    job->rtrn = -1;
+
+    job->starts = calloc((size_t)(section->size / 8) + 1, 1);
+    if(job->starts == NULL)
+        return (NULL);
+
+    /* Handles aren't shared between threads, so each job gets it's own.
+       The targets we handle are all x86-64. */
+    if(cs_open(CS_ARCH_X86, CS_MODE_64, &handle) != CS_ERR_OK)
+        return (NULL);
+
+    /* We need the details for the instruction groups and the branch operand. */
+    (void)cs_option(handle, CS_OPT_DETAIL, CS_OPT_ON);
 
     /* Allocate memory cache for 1 instruction, to be used by cs_disasm_iter later. */
     cs_insn *insn = cs_malloc(handle);
+    if(insn == NULL)
+    {
+        cs_close(&handle);
+        return (NULL);
+    }
 
-    uint64_t address = 0;
+    job->rtrn = 0;
 
     /* Disassemble one instruction at a time & store the result into the insn variable above */
-    while(cs_disasm_iter(handle, (const uint8_t **)&file_buffer_copy,
-                         (unsigned long *)&file_size, &address, insn))
+    while(cs_disasm_iter(handle, &code, &code_size, &address, insn))
     {
-        /* Check for branchs in the disasembly, maybe switch to a hash map in the future. */
-        if(strncmp(insn->mnemonic, "jne", 3) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "je", 2) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jg", 2) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jle", 3) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jl", 2) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jge", 3) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jo", 2) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jno", 3) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "js", 2) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jns", 3) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jz", 2) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jb", 2) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jnae", 4) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jc", 2) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jnb", 3) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jae", 3) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jnc", 3) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jbe", 3) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jna", 3) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "ja", 2) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jnbe", 4) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jl", 2) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jnge", 4) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jge", 3) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jng", 3) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jnle", 4) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jp", 2) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jpe", 3) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jnp", 3) == 0)
-        {
-            goto found_branch;
-        }
-        else if(strncmp(insn->mnemonic, "jpo", 3) == 0)
+        uint64_t offset = insn->address - section->address;
+
+        job->starts[offset / 8] |= (uint8_t)(1 << (offset % 8));
+
+        /* Conditional, direct and indirect jumps are all in the jump group. */
+        if(cs_insn_group(handle, insn, CS_GRP_JUMP) == false)
+            continue;
+
+        if(add_address(&job->branches, insn->address) < 0)
         {
-            goto found_branch;
+            job->rtrn = -1;
+            break;
         }
-        else if(strncmp(insn->mnemonic, "jcxz", 4) == 0)
+
+        /* Unless the jump always goes, it also starts the block it falls into. */
+        if(insn->id != X86_INS_JMP && insn->id != X86_INS_LJMP)
         {
-            goto found_branch;
+            if(add_address(&job->blocks, insn->address + insn->size) < 0)
+            {
+                job->rtrn = -1;
+                break;
+            }
         }
-        else if(strncmp(insn->mnemonic, "jecxz", 5) == 0)
+
+        /* Indirect jumps go somewhere we can't know from here. */
+        const cs_x86 *x86 = &insn->detail->x86;
+        if(x86->op_count != 1 || x86->operands[0].type != X86_OP_IMM)
+            continue;
+
+        if(add_address(&job->blocks, (uint64_t)x86->operands[0].imm) < 0)
         {
-            goto found_branch;
+            job->rtrn = -1;
+            break;
         }
-        else
-        {
-            /* We didn't find a branch instruction so cotinue looping */
+    }
+
+    job->end = address;
+
+    cs_free(insn, 1); // release the cache memory when done
+    cs_close(&handle);
+
+    return (NULL);
+}
+
+static int compare_address(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return ((x > y) - (x < y));
+}
+
+/* Check that address is the start of an instruction we decoded, so a breakpoint
+   planted there can't land in the middle of one. */
+static int32_t is_instruction(uint64_t address, const struct disas_job *jobs, uint32_t total_jobs)
+{
+    uint32_t i;
+
+    for(i = 0; i < total_jobs; i++)
+    {
+        const struct code_section *section = jobs[i].section;
+
+        if(address < section->address || address - section->address >= section->size)
             continue;
-        }
 
-    found_branch:
+        uint64_t offset = address - section->address;
+
+        return ((jobs[i].starts[offset / 8] >> (offset % 8)) & 1);
+    }
+
+    return (0);
+}
+
+/* Gather every job's blocks, or branches when branches is TRUE, sort them,
+   then squeeze out duplicates and addresses that aren't instructions. */
+static int32_t merge_addresses(const struct disas_job *jobs,
+                               uint32_t total_jobs,
+                               int32_t branches,
+                               uint64_t **list,
+                               uint64_t *total_list,
+                               struct output_writter *output)
+{
+    uint32_t i;
+    uint64_t j;
+    uint64_t total = 0;
+    uint64_t kept = 0;
+
+    for(i = 0; i < total_jobs; i++)
+        total += (branches == TRUE) ? jobs[i].branches.total : jobs[i].blocks.total;
+
+    (*list) = malloc((total + 1) * sizeof(uint64_t));
+    if((*list) == NULL)
+    {
+        output->write(ERROR, "Can't allocate address list: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    for(i = 0; i < total_jobs; i++)
+    {
+        const struct address_list *addresses = (branches == TRUE) ? &jobs[i].branches : &jobs[i].blocks;
+
+        memcpy(&(*list)[kept], addresses->list, addresses->total * sizeof(uint64_t));
+        kept += addresses->total;
+    }
+
+    qsort((*list), total, sizeof(uint64_t), &compare_address);
 
-        /*map->exec_ctx->address_index = realloc(map->exec_ctx->address_index, sizeof(char *) * count);
-        if(map->exec_ctx->address_index == NULL)
+    kept = 0;
+
+    for(j = 0; j < total; j++)
+    {
+        if(kept > 0 && (*list)[kept - 1] == (*list)[j])
+            continue;
+
+        if(is_instruction((*list)[j], jobs, total_jobs) == 0)
+            continue;
+
+        (*list)[kept] = (*list)[j];
+        kept++;
+    }
+
+    (*total_list) = kept;
+
+    return (0);
+}
+
+/* Disassemble every code section of the target at once and lay the results
+   out as an analysis that can be cached. */
+static struct analysis_header *analyze_target(char *exec_path,
+                                              const char *buf,
+                                              uint64_t size,
+                                              const struct analysis_key *key,
+                                              struct output_writter *output)
+{
+    int32_t rtrn = 0;
+    uint32_t i;
+    uint32_t started = 0;
+    uint64_t end = 0;
+    uint64_t main_address = 0;
+    uint32_t total_sections = 0;
+    struct code_section *sections = NULL;
+    struct disas_job *jobs = NULL;
+    pthread_t *threads = NULL;
+    uint64_t *blocks = NULL;
+    uint64_t total_blocks = 0;
+    uint64_t *branches = NULL;
+    uint64_t total_branches = 0;
+    struct analysis_function *functions = NULL;
+    uint64_t total_functions = 0;
+    char *strings = NULL;
+    uint64_t strings_size = 0;
+    struct analysis_header *result = NULL;
+
+    /* Only walk the code, at the addresses it's linked at. */
+    rtrn = get_code_sections(buf, size, &sections, &total_sections, output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't find the target's code\n");
+        return (NULL);
+    }
+
+    jobs = calloc(total_sections + 1, sizeof(struct disas_job));
+    threads = calloc(total_sections + 1, sizeof(pthread_t));
+    if(jobs == NULL || threads == NULL)
+    {
+        output->write(ERROR, "Can't allocate disassembly jobs: %s\n", strerror(errno));
+        goto out;
+    }
+
+    /* Sections don't depend on each other, so disassemble them all at once. */
+    for(i = 0; i < total_sections; i++)
+    {
+        jobs[i].section = &sections[i];
+
+        if(pthread_create(&threads[i], NULL, &disas_section, &jobs[i]) != 0)
         {
-            output(ERROR, "Can't realloc address index: %s\n", strerror(errno));
-            return -1;
+            output->write(ERROR, "Can't start disassembly thread\n");
+            rtrn = -1;
+            break;
         }
 
-        rtrn = asprintf(&map->exec_ctx->address_index[count], "%s", insn->address);
-        if(rtrn < 0)
+        started++;
+    }
+
+    for(i = 0; i < started; i++)
+    {
+        (void)pthread_join(threads[i], NULL);
+
+        if(jobs[i].rtrn < 0)
         {
-            output(ERROR, "Can't alloc address index slot: %s\n", strerror(errno));
-            return -1;
-        } */
+            output->write(ERROR, "Can't disassemble section at 0x%llx\n", sections[i].address);
+            rtrn = -1;
+        }
+
+        if(jobs[i].end > end)
+            end = jobs[i].end;
+    }
 
-        count++;
+    if(rtrn < 0)
+        goto out;
 
-        continue;
+    if(merge_addresses(jobs, total_sections, FALSE,
+                       &blocks, &total_blocks, output) < 0 ||
+       merge_addresses(jobs, total_sections, TRUE,
+                       &branches, &total_branches, output) < 0)
+    {
+        output->write(ERROR, "Can't merge addresses\n");
+        goto out;
     }
 
-    /* Save the offset of where the program ends. */
-    rtrn = set_end_offset(insn[0].address);
+    /* Find main, the fork server parks the target there. */
+    rtrn = get_load_address(exec_path, &main_address);
     if(rtrn < 0)
     {
-        output->write(ERROR, "Can't set end offset\n");
-        return -1;
+        output->write(ERROR, "Can't get load address\n");
+        goto out;
+    }
+
+    rtrn = get_function_symbols(buf, size, &functions, &total_functions, &strings, &strings_size, output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't read function symbols\n");
+        goto out;
+    }
+
+    result = create_analysis(key, blocks, total_blocks, branches, total_branches,
+                             functions, total_functions, strings, strings_size, output);
+    if(result == NULL)
+    {
+        output->write(ERROR, "Can't create analysis\n");
+        goto out;
+    }
+
+    result->main_address = main_address;
+    result->end_address = end;
+
+out:
+    for(i = 0; jobs != NULL && i < total_sections; i++)
+    {
+        free(jobs[i].starts);
+        free(jobs[i].blocks.list);
+        free(jobs[i].branches.list);
+    }
+
+    free(jobs);
+    free(threads);
+    free(sections);
+    free(blocks);
+    free(branches);
+    free(functions);
+    free(strings);
+
+    return (result);
+}
+
+const struct analysis_header *disas_executable_and_examine(char *exec_path,
+                                                           struct output_writter *output)
+{
+    int32_t rtrn;
+    uint64_t file_size;
+    int32_t file auto_close = 0;
+    char *file_buffer = NULL;
+    struct analysis_key key;
+
+    /* Open the target binary. */
+    file = open(exec_path, O_RDONLY);
+    if(file < 0)
+    {
+        output->write(ERROR, "open: %s\n", strerror(errno));
+        return (NULL);
+    }
+
+    /* Read file in to memory. */
+    rtrn = map_file_in(file, &file_buffer, &file_size, READ, output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't memory map file\n");
+        return (NULL);
+    }
+
+    rtrn = get_analysis_key(file_buffer, file_size, &key, output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't create analysis key\n");
+        munmap(file_buffer, (size_t)file_size);
+        return (NULL);
+    }
+
+    /* Skip the disassembly if we've seen this target before. */
+    analysis = load_analysis(&key, output);
+    if(analysis != NULL)
+    {
+        output->write(STD, "Using cached analysis\n");
+    }
+    else
+    {
+        analysis = analyze_target(exec_path, file_buffer, file_size, &key, output);
+        if(analysis == NULL)
+        {
+            output->write(ERROR, "Can't analyze target\n");
+            munmap(file_buffer, (size_t)file_size);
+            return (NULL);
+        }
+
+        /* We can still test the target without a cache, we just redo the work next time. */
+        rtrn = save_analysis(analysis, output);
+        if(rtrn < 0)
+            output->write(ERROR, "Can't save analysis\n");
     }
 
-    cs_free(insn, 1); // release the cache memory when done
     munmap(file_buffer, (size_t)file_size);
 
-    return 0;
+    output->write(STD, "Found %llu basic blocks\n", analysis->total_blocks);
+
+    return (analysis);
 }
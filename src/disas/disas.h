@@ -16,11 +16,90 @@
 #ifndef DISAS_H
 #define DISAS_H
 
+#include "cache.h"
 #include "io/io.h"
 #include <stdint.h>
 
-extern int32_t get_load_address(uint64_t *main_addr);
+/* A section of the target that holds code. */
+struct code_section
+{
+    /* The section's bytes in the mapped executable. */
+    const uint8_t *code;
 
-extern int32_t disas_executable_and_examine(struct output_writter *output);
+    /* Length of the section. */
+    uint64_t size;
+
+    /* The link time address of the first byte. */
+    uint64_t address;
+};
+
+/**
+ * Find main() in the executable at exec_path, or the entry point if the target is stripped.
+ * @param exec_path Path of the executable.
+ * @param main_addr Where the link time address is placed.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t get_load_address(char *exec_path, uint64_t *main_addr);
+
+/**
+ * Find the executable sections in the executable mapped at buf.
+ * @param buf The executable.
+ * @param size Length of buf.
+ * @param sections Where an array of the sections is placed, free it with free().
+ * @param total Where the number of sections is placed.
+ * @param output An output writter object.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t get_code_sections(const char *buf,
+                                 uint64_t size,
+                                 struct code_section **sections,
+                                 uint32_t *total,
+                                 struct output_writter *output);
+
+/**
+ * Find the GNU build-id note in the executable mapped at buf.
+ * @param buf The executable.
+ * @param size Length of buf.
+ * @param id Where the build-id is copied, BUILD_ID_MAX bytes long.
+ * @param id_size Where the length of the build-id is placed, zero if the target has none.
+ * @param output An output writter object.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t get_build_id(const char *buf,
+                            uint64_t size,
+                            uint8_t *id,
+                            uint32_t *id_size,
+                            struct output_writter *output);
+
+/**
+ * Read the function symbols from the executable mapped at buf. Uses the full
+ * symbol table and falls back to the dynamic one when the target is stripped.
+ * @param buf The executable.
+ * @param size Length of buf.
+ * @param functions Where an array of the functions sorted by address is placed, free it with free().
+ * @param total Where the number of functions is placed.
+ * @param strings Where the names are placed, free it with free().
+ * @param strings_size Where the size of strings is placed.
+ * @param output An output writter object.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t get_function_symbols(const char *buf,
+                                    uint64_t size,
+                                    struct analysis_function **functions,
+                                    uint64_t *total,
+                                    char **strings,
+                                    uint64_t *strings_size,
+                                    struct output_writter *output);
+
+/**
+ * Disassemble the target and find main() and the start addresses of it's basic
+ * blocks. The analysis is cached on disk and mapped back in when the same target
+ * is tested again.
+ * @param exec_path Path of the target executable.
+ * @param output An output writter object.
+ * @return The analysis on success and NULL on failure, it lives until we exit.
+ */
+extern const struct analysis_header *disas_executable_and_examine(char *exec_path,
+                                                                  struct output_writter *output);
 
 #endif
@@ -1,25 +1,283 @@
 /**
  * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
- * 
+ *
  * Permission to use, copy, modify, and/or distribute this software for any purpose
- * with or without fee is hereby granted, provided that the above copyright notice 
+ * with or without fee is hereby granted, provided that the above copyright notice
  * and this permission notice appear in all copies.
- * 
- * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH 
- * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY 
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
  * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
- * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, 
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
  * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
  * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  **/
 
+/* We need to define _GNU_SOURCE to use
+ asprintf on Linux. We also need to place
+ _GNU_SOURCE at the top of the file before
+ any other includes for it to work properly. */
+#define _GNU_SOURCE
+
 #include "file.h"
+#include "io/io.h"
+#include "probe/probe.h"
+#include "runtime/platform.h"
+#include "utils/utils.h"
+#include "utils/autofree.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <sys/wait.h>
+
+/* How long a test case may run before we kill it. */
+static const int64_t TEST_CASE_TIMEOUT_NS = 1000000000;
+
+/* Set to TRUE once the fork server is parked at main(). */
+static int32_t server_running = FALSE;
+
+static int32_t handle_crash(char *file_path,
+                            char *file_extension,
+                            int32_t sig,
+                            struct output_writter *output)
+{
+    int32_t rtrn = 0;
+    char *path auto_free = NULL;
+    char *file_name auto_free = NULL;
+
+    output->write(STD, "Target crashed with signal: %s\n", strsignal(sig));
+
+    /* Create a random file name. */
+    rtrn = generate_name(&file_name, file_extension, FILE_NAME);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't create crash file name\n");
+        return (-1);
+    }
+
+    rtrn = asprintf(&path, "/tmp/crash_%s", file_name);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't create crash path: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    /* Copy the test case out before it's overwritten by the next one. */
+    rtrn = copy_file_to(file_path, path, output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't copy file to crash directory\n");
+        return (-1);
+    }
+
+    return (0);
+}
+
+/* Wait for the test case process to exit, killing it if it runs past the timeout.
+   SIGCHLD must be blocked so that sigtimedwait() can sleep until the child exits.
+   Threads and children of a clone with block probes are traced too, their stops
+   are handled here while we wait. */
+static int32_t wait_for_test_case(pid_t pid, int32_t *status, struct output_writter *output)
+{
+    sigset_t set;
+    struct timespec now;
+    struct timespec deadline;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIGCHLD);
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += TEST_CASE_TIMEOUT_NS / 1000000000;
+    deadline.tv_nsec += TEST_CASE_TIMEOUT_NS % 1000000000;
+
+    while(1)
+    {
+        pid_t ret = waitpid(-1, status, WNOHANG | __WALL);
+        if(ret > 0 && ret != pid)
+        {
+            /* A thread or child of the clone ran into a probe or changed state. */
+            if(WIFSTOPPED((*status)) != 0 && handle_probe_stop(ret, (*status), output) < 0)
+            {
+                output->write(ERROR, "Can't handle block probe\n");
+                (void)kill(ret, SIGKILL);
+            }
+
+            continue;
+        }
+
+        if(ret == pid)
+        {
+            /* Only a clone with block probes in it stops instead of exiting. */
+            if(WIFSTOPPED((*status)) == 0)
+                return (0);
+
+            if(handle_probe_stop(pid, (*status), output) < 0)
+            {
+                output->write(ERROR, "Can't handle block probe\n");
+                (void)kill(pid, SIGKILL);
+                (void)waitpid(pid, status, 0);
+                return (-1);
+            }
+
+            continue;
+        }
+
+        if(ret < 0)
+        {
+            output->write(ERROR, "waitpid: %s\n", strerror(errno));
+            return (-1);
+        }
+
+        (void)clock_gettime(CLOCK_MONOTONIC, &now);
+
+        int64_t left = (deadline.tv_sec - now.tv_sec) * 1000000000 +
+                       (deadline.tv_nsec - now.tv_nsec);
+        if(left <= 0)
+            break;
+
+        struct timespec timeout = { left / 1000000000, left % 1000000000 };
+
+        /* Sleep until a child changes state or we run out of time. */
+        if(sigtimedwait(&set, NULL, &timeout) < 0 && errno != EAGAIN && errno != EINTR)
+        {
+            output->write(ERROR, "sigtimedwait: %s\n", strerror(errno));
+            return (-1);
+        }
+    }
+
+    /* The test case timed out, kill it and reap it. */
+    (void)kill(pid, SIGKILL);
+
+    if(waitpid(pid, status, 0) < 0)
+    {
+        output->write(ERROR, "waitpid: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    return (0);
+}
+
+int32_t start_fork_server(char *exec_path, char *input_path, struct output_writter *output)
+{
+    int32_t rtrn = 0;
+    pid_t pid = 0;
+    uint64_t main_addr = get_start_addr();
+
+    /* We park the target at main() so we can't do anything without it. */
+    if(main_addr == 0)
+    {
+        output->write(ERROR, "Target start address is not set\n");
+        return (-1);
+    }
+
+    /* Start the target and stop it right after exec. */
+    rtrn = start_and_pause_target(exec_path, input_path, &pid, output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't start target\n");
+        return (-1);
+    }
+
+    /* Run it up to main and turn it into a fork server. */
+    rtrn = inject_fork_server(main_addr, output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't inject fork server\n");
+        cleanup_fork_server();
+        return (-1);
+    }
+
+    server_running = TRUE;
+
+    return (0);
+}
+
+void stop_fork_server(void)
+{
+    if(server_running != TRUE)
+        return;
+
+    cleanup_fork_server();
+
+    server_running = FALSE;
+
+    return;
+}
 
 int32_t run_test_case(char *exec_path, char *file_path, char *file_extension)
 {
-	(void)exec_path;
-	(void)file_path;
-	(void)file_extension;
+    int32_t rtrn = 0;
+    int32_t status = 0;
+    pid_t child_pid = 0;
+    struct output_writter *output = NULL;
+
+    /* Just grab the console writter in here so we don't break the old api. */
+    output = get_console_writter();
+    if(output == NULL)
+    {
+        printf("Failed to get console writter\n");
+        return (-1);
+    }
+
+    if(server_running == TRUE)
+    {
+        /* Clone the target parked at main(), it reads file_path from argv. */
+        rtrn = fork_server_clone(&child_pid, output);
+        if(rtrn < 0)
+        {
+            output->write(ERROR, "Can't clone fork server\n");
+            return (-1);
+        }
+    }
+    else
+    {
+        child_pid = fork();
+        if(child_pid == 0)
+        {
+            char * const argv[] = {exec_path, file_path, NULL};
+
+            /* Execute the target executable with the file we generated. */
+            (void)execv(exec_path, argv);
+
+            _exit(-1);
+        }
+        else if(child_pid < 0)
+        {
+            output->write(ERROR, "Can't create child process: %s\n", strerror(errno));
+            return (-1);
+        }
+    }
+
+    /* Wait for test program to exit, crash or be killed for running too long. */
+    rtrn = wait_for_test_case(child_pid, &status, output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't wait for test case\n");
+        return (-1);
+    }
+
+    /* Check if the target program recieved a signal. */
+    if(WIFSIGNALED(status))
+    {
+        switch(WTERMSIG(status))
+        {
+            /* The program we are testing crashed let's save the file
+              that caused the crash.  */
+            case SIGSEGV:
+            case SIGBUS:
+            case SIGILL:
+            case SIGFPE:
+            case SIGABRT:
+                (void)handle_crash(file_path, file_extension, WTERMSIG(status), output);
+                break;
+
+            /* SIGKILL is from the timeout, anything else is less interesting. */
+            default:
+                break;
+        }
+    }
 
-	return (0);
+    return (0);
 }
@@ -66,3 +66,15 @@ int32_t run_test_case(char *exec_path, char *file_path, char *file_extension)
 
     return (0);
 }
+
+int32_t start_fork_server(char *exec_path, char *input_path, struct output_writter *output)
+{
+    (void)exec_path;
+    (void)input_path;
+
+    output->write(ERROR, "The fork server is not supported on this platform yet\n");
+
+    return (-1);
+}
+
+void stop_fork_server(void) { return; }
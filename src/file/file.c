@@ -24,6 +24,10 @@
 #endif
 
 #include "file.h"
+#include "persistent.h"
+#include "coverage/coverage.h"
+#include "disas/disas.h"
+#include "probe/probe.h"
 #include "utils/autoclose.h"
 #include "utils/autofree.h"
 #include "crypto/crypto.h"
@@ -38,7 +42,10 @@
 #include <dirent.h>
 #include <errno.h>
 #include <signal.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 
 static int32_t *stop_ptr;
@@ -72,6 +79,34 @@ static char *input_dir;
 
 static int32_t setup;
 
+/* Fork server clones all read their test case from this path, the argument
+   vector is fixed when the server is started. */
+static char *fork_server_input = "/tmp/nextgen_fork_server_input";
+
+/* Set to TRUE when the target loops over test cases with the persistent harness. */
+static int32_t persistent_mode;
+
+/* Hit counts an instrumented target writes for the test case it's running. In
+   persistent mode it's PERSISTENT_SLOTS maps, one for each slot in the ring. */
+static uint8_t *coverage_trace;
+
+/* Size of the mapping at coverage_trace. */
+static uint64_t coverage_size;
+
+/* Edges no test case has reached yet. */
+static uint8_t *virgin_map;
+
+/* Path of the file backing the trace map, targets find it in COVERAGE_TRACE_ENV. */
+static char coverage_path[] = "/tmp/nextgen_coverage_XXXXXX";
+
+/* Number of edges the test cases have reached. */
+static uint64_t total_edges;
+
+/* The target's basic blocks, from the disassembler. */
+static const uint64_t *block_list;
+
+static uint64_t total_blocks;
+
 static void ctrlc_handler(int sig)
 {
     (void)sig;
@@ -79,12 +114,26 @@ static void ctrlc_handler(int sig)
     return;
 }
 
-static void setup_signal_handler(void)
+static int32_t setup_signal_handler(struct output_writter *output)
 {
+    sigset_t set;
+
     (void)signal(SIGFPE, SIG_DFL);
     (void)signal(SIGCHLD, SIG_DFL);
     (void)signal(SIGINT, ctrlc_handler);
-    return;
+
+    /* Keep SIGCHLD pending instead of discarded, so run_test_case() can sleep
+       on it with sigtimedwait() whether or not the fork server is running. */
+    sigemptyset(&set);
+    sigaddset(&set, SIGCHLD);
+
+    if(sigprocmask(SIG_BLOCK, &set, NULL) < 0)
+    {
+        output->write(ERROR, "sigprocmask: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    return (0);
 }
 
 static int32_t get_file(int32_t *file,
@@ -145,6 +194,21 @@ void set_start_addr(uint64_t addr)
 
 uint64_t get_start_addr(void) { return (start_offset); }
 
+void set_basic_blocks(const uint64_t *blocks, uint64_t total)
+{
+    block_list = blocks;
+    total_blocks = total;
+
+    return;
+}
+
+void set_persistent_mode(int32_t mode)
+{
+    persistent_mode = mode;
+
+    return;
+}
+
 static struct file_ctx *init_file_ctx(char *path, struct output_writter *output)
 {
     int32_t rtrn = 0;
@@ -293,13 +357,169 @@ int32_t set_end_offset(uint64_t offset)
     return (0);
 }
 
+/* Share a trace map with the target through a file, so it survives the
+   target's exec and the fork server's clones all write to the same one. */
+static int32_t setup_file_coverage(struct output_writter *output)
+{
+    int32_t fd auto_close = 0;
+
+    coverage_size = (persistent_mode == TRUE) ? PERSISTENT_TRACE_SIZE : COVERAGE_MAP_SIZE;
+
+    fd = mkstemp(coverage_path);
+    if(fd < 0)
+    {
+        output->write(ERROR, "mkstemp: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    if(ftruncate(fd, (off_t)coverage_size) < 0)
+    {
+        output->write(ERROR, "ftruncate: %s\n", strerror(errno));
+        (void)unlink(coverage_path);
+        return (-1);
+    }
+
+    coverage_trace = mmap(NULL, coverage_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(coverage_trace == MAP_FAILED)
+    {
+        output->write(ERROR, "mmap: %s\n", strerror(errno));
+        (void)unlink(coverage_path);
+        coverage_trace = NULL;
+        return (-1);
+    }
+
+    virgin_map = coverage_create_map(0xFF, get_default_allocator(), output);
+    if(virgin_map == NULL)
+    {
+        output->write(ERROR, "Can't create virgin map\n");
+        return (-1);
+    }
+
+    setup_coverage_module();
+
+    /* Targets started from here on inherit the path. */
+    if(setenv(COVERAGE_TRACE_ENV, coverage_path, 1) < 0)
+    {
+        output->write(ERROR, "setenv: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    return (0);
+}
+
+static void check_file_coverage(uint8_t *trace)
+{
+    uint32_t new_edges = 0;
+
+    coverage_classify(trace);
+    if(coverage_has_new_bits(trace, virgin_map, &new_edges) == COVERAGE_NEW_EDGES)
+        total_edges += new_edges;
+
+    return;
+}
+
+/* Called by the persistent module for each test case the target finishes. */
+static void check_persistent_coverage(uint8_t *trace)
+{
+    check_file_coverage(trace);
+
+    /* The slot's next test case starts with an empty trace. */
+    coverage_reset(trace);
+
+    return;
+}
+
+/* Find main() and the target's basic blocks, for the fork server and it's block probes. */
+static int32_t examine_target(struct output_writter *output)
+{
+    const struct analysis_header *analysis = NULL;
+
+    analysis = disas_executable_and_examine(path_to_exec, output);
+    if(analysis == NULL)
+    {
+        output->write(ERROR, "Can't examine target\n");
+        return (-1);
+    }
+
+    set_start_addr(analysis->main_address);
+
+    /* Save the offset of where the program ends. */
+    if(set_end_offset(analysis->end_address) < 0)
+    {
+        output->write(ERROR, "Can't set end offset\n");
+        return (-1);
+    }
+
+    set_basic_blocks(analysis_blocks(analysis), analysis->total_blocks);
+
+    return (0);
+}
+
+static void cleanup_file_coverage(struct output_writter *output)
+{
+    if(coverage_trace == NULL)
+        return;
+
+    output->write(STD, "Test cases reached %llu edges\n", total_edges);
+
+    munmap(coverage_trace, coverage_size);
+    (void)unlink(coverage_path);
+    coverage_free_map(&virgin_map, get_default_allocator());
+
+    coverage_trace = NULL;
+
+    return;
+}
+
 void start_main_file_loop(struct output_writter *output,
                           struct random_generator *random)
 {
+    int32_t server = FALSE;
+
     output->write(STD, "Starting fuzzer\n");
 
     /* Set up signal handler. */
-    setup_signal_handler();
+    if(setup_signal_handler(output) < 0)
+    {
+        output->write(ERROR, "Can't setup signal handler\n");
+        return;
+    }
+
+    /* Set up coverage before starting the target so it finds the trace map. A
+       target that isn't instrumented just leaves the map empty. */
+    if(setup_file_coverage(output) < 0)
+    {
+        output->write(ERROR, "Can't setup coverage\n");
+        return;
+    }
+
+    if(persistent_mode == TRUE)
+    {
+        set_persistent_coverage(coverage_trace, &check_persistent_coverage);
+
+        /* The target stays up and reads test cases from the ring. */
+        if(start_persistent_target(path_to_exec, output) < 0)
+        {
+            output->write(ERROR, "Can't start persistent target\n");
+            return;
+        }
+    }
+    /* Try to avoid an exec per test case, fallback to exec'ing the target if we can't. */
+    else if(examine_target(output) == 0 &&
+            start_fork_server(path_to_exec, fork_server_input, output) == 0)
+    {
+        server = TRUE;
+
+        /* Targets that aren't instrumented still get block coverage from probes. */
+        if(total_blocks > 0 && inject_block_probes(block_list, total_blocks, coverage_trace, output) < 0)
+        {
+            output->write(ERROR, "Can't inject block probes\n");
+            stop_fork_server();
+            return;
+        }
+    }
+    else
+        output->write(STD, "Fork server unavailable, exec'ing target for each test case\n");
 
     /* Check if we should stop or continue running. */
     while(ck_pr_load_int(stop_ptr) == FALSE)
@@ -338,6 +558,21 @@ void start_main_file_loop(struct output_writter *output,
             return;
         }
 
+        /* In persistent mode the test case never touches the disk. */
+        if(persistent_mode == TRUE)
+        {
+            rtrn = persistent_push(file_buffer, file_size, output);
+            mem_free_shared((void **)&file_buffer, (size_t)file_size);
+            if(rtrn < 0)
+            {
+                output->write(ERROR, "Can't send test case to target\n");
+                return;
+            }
+
+            /* The persistent module checks it's coverage once the target is done with it. */
+            continue;
+        }
+
         /* Generate random file name. */
         rtrn = generate_name(&file_name, file_extension, FILE_NAME);
         if(rtrn < 0)
@@ -346,8 +581,11 @@ void start_main_file_loop(struct output_writter *output,
             return;
         }
 
-        /* Create out path. */
-        rtrn = asprintf(&file_path, "/tmp/%s", file_name);
+        /* Create out path, the fork server always reads the same path. */
+        if(server == TRUE)
+            rtrn = asprintf(&file_path, "%s", fork_server_input);
+        else
+            rtrn = asprintf(&file_path, "/tmp/%s", file_name);
         if(rtrn < 0)
         {
             output->write(ERROR, "Can't create out path\n");
@@ -371,6 +609,9 @@ void start_main_file_loop(struct output_writter *output,
             return;
         }
 
+        /* Each test case starts with an empty trace. */
+        coverage_reset(coverage_trace);
+
         /* Create children process and exec the target executable and run it with
         the generated file. */
         rtrn = run_test_case(path_to_exec, file_path, file_extension);
@@ -380,9 +621,15 @@ void start_main_file_loop(struct output_writter *output,
             return;
         }
 
+        check_file_coverage(coverage_trace);
+
         /* Clean up our mess. */
         mem_free_shared((void **)&file_buffer, (size_t)file_size);
 
+        /* The fork server input gets truncated by the next test case. */
+        if(server == TRUE)
+            continue;
+
         rtrn = unlink(file_path);
         if(rtrn < 0)
         {
@@ -391,6 +638,14 @@ void start_main_file_loop(struct output_writter *output,
         }
     }
 
+    /* Don't lose a crash in the test cases still in the ring. */
+    if(persistent_mode == TRUE && persistent_drain(output) < 0)
+        output->write(ERROR, "Can't drain persistent target\n");
+
+    stop_fork_server();
+    stop_persistent_target();
+    cleanup_file_coverage(output);
+
     output->write(STD, "Exiting main loop\n");
 
     return;
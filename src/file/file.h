@@ -38,8 +38,24 @@ extern void set_start_addr(uint64_t addr);
 
 extern uint64_t get_start_addr(void);
 
+/* Link time start addresses of the target's basic blocks, sorted from lowest
+   to highest. With a fork server each one gets a one shot block probe. */
+extern void set_basic_blocks(const uint64_t *blocks, uint64_t total);
+
+/* Pass TRUE to send test cases to a target built against file/harness.h through a
+   shared memory ring, instead of writing them to disk and running the target on each. */
+extern void set_persistent_mode(int32_t mode);
+
 extern int32_t run_test_case(char *exec_path, char *file_path, char *file_extension);
 
+/* Start the target under ptrace, run it up to main() and park it there so
+   run_test_case() can clone it instead of exec'ing the target for every test case.
+   Every clone reads its test case from input_path. Needs set_start_addr()
+   to have been called with the address of main() first. */
+extern int32_t start_fork_server(char *exec_path, char *input_path, struct output_writter *output);
+
+extern void stop_fork_server(void);
+
 extern int32_t initial_fuzz_run(void);
 
 #endif
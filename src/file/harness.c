@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+/* This file is linked into the target, so it can only depend on libc and
+   header only parts of nextgen. */
+
+#include "harness.h"
+#include "persistent.h"
+#include "concurrent/concurrent.h"
+#include "coverage/coverage.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/* Edge hit counts shared with nextgen, NULL when nextgen isn't collecting them. */
+static uint8_t *coverage_trace;
+
+/* In the persistent loop every slot has it's own trace map. */
+static uint8_t *slot_traces;
+
+/* The guard of the last edge we passed, shifted like AFL's prev_loc. */
+static uint32_t prev_guard;
+
+static void map_coverage_trace(void)
+{
+    int32_t fd = 0;
+    char *path = getenv(COVERAGE_TRACE_ENV);
+    if(path == NULL)
+        return;
+
+    fd = open(path, O_RDWR);
+    if(fd < 0)
+        return;
+
+    void *map = mmap(NULL, COVERAGE_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void)close(fd);
+    if(map == MAP_FAILED)
+        return;
+
+    coverage_trace = map;
+
+    return;
+}
+
+/* Swap the single trace map for one per slot, nextgen sizes the file for them in persistent mode. */
+static void map_slot_traces(void)
+{
+    int32_t fd = 0;
+    char *path = getenv(COVERAGE_TRACE_ENV);
+    if(path == NULL || coverage_trace == NULL)
+        return;
+
+    fd = open(path, O_RDWR);
+    if(fd < 0)
+        return;
+
+    void *map = mmap(NULL, PERSISTENT_TRACE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void)close(fd);
+    if(map == MAP_FAILED)
+        return;
+
+    munmap(coverage_trace, COVERAGE_MAP_SIZE);
+
+    slot_traces = map;
+    coverage_trace = map;
+
+    return;
+}
+
+/* Called by the compiler's instrumentation for each module before main(). */
+void __sanitizer_cov_trace_pc_guard_init(uint32_t *start, uint32_t *stop)
+{
+    static uint32_t total_guards;
+    uint32_t *guard = NULL;
+
+    /* Modules can be initialized more than once. */
+    if(start == stop || (*start) != 0)
+        return;
+
+    if(coverage_trace == NULL)
+        map_coverage_trace();
+
+    /* Spread the guards across the map, zero would turn a guard off. */
+    for(guard = start; guard < stop; guard++)
+    {
+        total_guards++;
+        (*guard) = ((total_guards * 2654435761U) % (COVERAGE_MAP_SIZE - 1)) + 1;
+    }
+
+    return;
+}
+
+/* Called by the compiler's instrumentation on every edge. */
+void __sanitizer_cov_trace_pc_guard(uint32_t *guard)
+{
+    if(coverage_trace == NULL)
+        return;
+
+    coverage_trace[((*guard) ^ prev_guard) % COVERAGE_MAP_SIZE]++;
+    prev_guard = (*guard) >> 1;
+
+    return;
+}
+
+int32_t nextgen_persistent_loop(int32_t (*test)(const uint8_t *buf, uint64_t size))
+{
+    uint32_t i;
+    int32_t fd = 0;
+    char *path = NULL;
+    struct persistent_ring *ring = NULL;
+
+    /* If nextgen did not start us there is no ring. */
+    path = getenv(PERSISTENT_RING_ENV);
+    if(path == NULL)
+        return (-1);
+
+    fd = open(path, O_RDWR);
+    if(fd < 0)
+        return (-1);
+
+    ring = mmap(NULL, PERSISTENT_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void)close(fd);
+    if(ring == MAP_FAILED)
+        return (-1);
+
+    map_slot_traces();
+
+    while(atomic_load_int32(&ring->stop) == 0)
+    {
+        uint32_t tail = atomic_load_uint32(&ring->tail);
+
+        /* Wait for nextgen to queue a test case. */
+        for(i = 0; atomic_load_uint32(&ring->head) == tail; i++)
+        {
+            if(atomic_load_int32(&ring->stop) != 0)
+                break;
+
+            if(i < 1024)
+                atomic_stall();
+            else
+                (void)sched_yield();
+        }
+
+        if(atomic_load_uint32(&ring->head) == tail)
+            continue;
+
+        /* Don't read the slot before we've seen the head that published it. */
+        atomic_fence_load();
+
+        struct persistent_slot *slot = persistent_get_slot(ring, tail);
+
+        /* Count this test case's edges in it's slot's trace, nextgen checks it once we're done. */
+        if(slot_traces != NULL)
+        {
+            coverage_trace = persistent_get_trace(slot_traces, tail);
+            prev_guard = 0;
+        }
+
+        (void)test((const uint8_t *)slot->data, slot->size);
+
+        /* Hand the slot back, if test crashed we never get here and
+          nextgen knows the test case at tail is the culprit. */
+        atomic_store_uint32(&ring->tail, tail + 1);
+    }
+
+    munmap(ring, PERSISTENT_MAP_SIZE);
+
+    return (0);
+}
@@ -0,0 +1,37 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+/* This header is for targets, link the target against libnxharness
+   and call nextgen_persistent_loop() from it's main(). Build the target
+   with -fsanitize-coverage=trace-pc-guard and the harness reports it's
+   edge coverage back to nextgen too. */
+
+#ifndef HARNESS_H
+#define HARNESS_H
+
+#include <stdint.h>
+
+/**
+ * Run test on every test case nextgen sends when the target is started by nextgen
+ * in persistent mode. test must handle one test case and leave the target in a
+ * state where it can handle the next one, a crash in test is reported as a crash
+ * on that test case.
+ * @param test The target's function for handling one test case.
+ * @return Zero when nextgen stops the target and negative one if the target
+ * was not started by nextgen, in which case it should handle argv like normal.
+ */
+extern int32_t nextgen_persistent_loop(int32_t (*test)(const uint8_t *buf, uint64_t size));
+
+#endif
@@ -0,0 +1,352 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+#ifdef LINUX
+
+/* We need to define _GNU_SOURCE to use
+ asprintf on Linux. We also need to place
+ _GNU_SOURCE at the top of the file before
+ any other includes for it to work properly. */
+#define _GNU_SOURCE
+
+#endif
+
+#include "persistent.h"
+#include "concurrent/concurrent.h"
+#include "runtime/platform.h"
+#include "utils/autoclose.h"
+#include "utils/autofree.h"
+#include "utils/utils.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+/* How long the target may spend on one test case before we call it a hang. */
+static const int64_t PERSISTENT_TIMEOUT_NS = 1000000000;
+
+/* The ring shared with the target. */
+static struct persistent_ring *ring;
+
+/* Path of the file backing the ring. */
+static char ring_path[] = "/tmp/nextgen_ring_XXXXXX";
+
+static char *target_path;
+
+static pid_t target_pid;
+
+/* The trace maps of the slots and what to do with a finished one, NULL without coverage. */
+static uint8_t *slot_traces;
+static void (*check_slot_trace)(uint8_t *trace);
+
+/* Number of finished test cases whose trace we have checked. */
+static uint32_t checked;
+
+/* The last tail value we saw and when we saw it change, for hang detection. */
+static uint32_t last_tail;
+static struct timespec last_progress;
+
+void set_persistent_coverage(uint8_t *traces, void (*check)(uint8_t *trace))
+{
+    slot_traces = traces;
+    check_slot_trace = check;
+
+    return;
+}
+
+/* Check the trace of every test case the target has finished. We are the only one
+   that reuses a slot, so the target is never writing to a trace we are reading. */
+static void collect_coverage(void)
+{
+    uint32_t tail = atomic_load_uint32(&ring->tail);
+
+    if(slot_traces == NULL)
+    {
+        checked = tail;
+        return;
+    }
+
+    /* Don't read a trace before we've seen the tail that finished it. */
+    atomic_fence_load();
+
+    while(checked != tail)
+    {
+        check_slot_trace(persistent_get_trace(slot_traces, checked));
+        checked++;
+    }
+
+    return;
+}
+
+static int32_t spawn_target(struct output_writter *output)
+{
+    target_pid = fork();
+    if(target_pid == 0)
+    {
+        char * const argv[] = {target_path, NULL};
+
+        /* Let the harness know where to find it's input. */
+        if(setenv(PERSISTENT_RING_ENV, ring_path, 1) < 0)
+            _exit(-1);
+
+        (void)execv(target_path, argv);
+
+        _exit(-1);
+    }
+    else if(target_pid < 0)
+    {
+        output->write(ERROR, "Can't create target process: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    last_tail = atomic_load_uint32(&ring->tail);
+    (void)clock_gettime(CLOCK_MONOTONIC, &last_progress);
+
+    return (0);
+}
+
+static void save_test_case(struct persistent_slot *slot, int32_t sig, struct output_writter *output)
+{
+    int32_t rtrn = 0;
+    char *path auto_free = NULL;
+
+    output->write(STD, "Target crashed with signal: %s\n", strsignal(sig));
+
+    rtrn = asprintf(&path, "/tmp/crash_persistent_%d_%u", target_pid, atomic_load_uint32(&ring->tail));
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't create crash path: %s\n", strerror(errno));
+        return;
+    }
+
+    /* Copy the test case out of the ring before the slot is reused. */
+    rtrn = map_file_out(path, slot->data, slot->size, output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't write crash file\n");
+        return;
+    }
+
+    return;
+}
+
+/* The target died on the test case at tail, the slot it was consuming, save
+   it if it was a crash, skip it and start a new target to work on the rest of the ring. */
+static int32_t restart_target(int32_t status, struct output_writter *output)
+{
+    uint32_t tail = atomic_load_uint32(&ring->tail);
+
+    if(WIFSIGNALED(status))
+    {
+        switch(WTERMSIG(status))
+        {
+            case SIGSEGV:
+            case SIGBUS:
+            case SIGILL:
+            case SIGFPE:
+            case SIGABRT:
+                save_test_case(persistent_get_slot(ring, tail), WTERMSIG(status), output);
+                break;
+
+            /* SIGKILL is from a hang, anything else is less interesting. */
+            default:
+                break;
+        }
+    }
+
+    /* The target is dead so we are the only one touching tail. */
+    if(tail != atomic_load_uint32(&ring->head))
+        atomic_store_uint32(&ring->tail, tail + 1);
+
+    /* What the test case reached before it died is coverage too. */
+    collect_coverage();
+
+    return (spawn_target(output));
+}
+
+static int32_t check_target(struct output_writter *output)
+{
+    int32_t status = 0;
+    struct timespec now;
+
+    pid_t ret = waitpid(target_pid, &status, WNOHANG);
+    if(ret == target_pid)
+        return (restart_target(status, output));
+
+    if(ret < 0)
+    {
+        output->write(ERROR, "waitpid: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    uint32_t tail = atomic_load_uint32(&ring->tail);
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+
+    /* The target made progress or has nothing to do. */
+    if(tail != last_tail || tail == atomic_load_uint32(&ring->head))
+    {
+        last_tail = tail;
+        last_progress = now;
+        return (0);
+    }
+
+    int64_t elapsed = (now.tv_sec - last_progress.tv_sec) * 1000000000 +
+                      (now.tv_nsec - last_progress.tv_nsec);
+    if(elapsed < PERSISTENT_TIMEOUT_NS)
+        return (0);
+
+    /* The target is stuck on the test case at tail, kill it. */
+    (void)kill(target_pid, SIGKILL);
+
+    if(waitpid(target_pid, &status, 0) < 0)
+    {
+        output->write(ERROR, "waitpid: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    return (restart_target(status, output));
+}
+
+int32_t start_persistent_target(char *exec_path, struct output_writter *output)
+{
+    int32_t fd auto_close = 0;
+
+    /* Back the ring with a file so it survives the target's exec. */
+    fd = mkstemp(ring_path);
+    if(fd < 0)
+    {
+        output->write(ERROR, "mkstemp: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    if(ftruncate(fd, (off_t)PERSISTENT_MAP_SIZE) < 0)
+    {
+        output->write(ERROR, "ftruncate: %s\n", strerror(errno));
+        (void)unlink(ring_path);
+        return (-1);
+    }
+
+    ring = mmap(NULL, PERSISTENT_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(ring == MAP_FAILED)
+    {
+        output->write(ERROR, "mmap: %s\n", strerror(errno));
+        (void)unlink(ring_path);
+        ring = NULL;
+        return (-1);
+    }
+
+    target_path = exec_path;
+    checked = 0;
+
+    return (spawn_target(output));
+}
+
+int32_t persistent_push(char *buf, uint64_t size, struct output_writter *output)
+{
+    uint32_t i;
+    uint32_t head = atomic_load_uint32(&ring->head);
+
+    /* Reap the target on every push, so a crash is caught while the
+       test case it died on is still the one at tail. */
+    if(check_target(output) < 0)
+    {
+        output->write(ERROR, "Can't check target\n");
+        return (-1);
+    }
+
+    /* Wait for the target to free up a slot. */
+    for(i = 0; head - atomic_load_uint32(&ring->tail) >= PERSISTENT_SLOTS; i++)
+    {
+        if(check_target(output) < 0)
+        {
+            output->write(ERROR, "Can't check target\n");
+            return (-1);
+        }
+
+        /* Spin for a bit before giving up the processor. */
+        if(i < 1024)
+            atomic_stall();
+        else
+            (void)sched_yield();
+    }
+
+    /* The slot's trace has to be checked before the target runs another test case in it. */
+    collect_coverage();
+
+    struct persistent_slot *slot = persistent_get_slot(ring, head);
+
+    /* Like AFL we cap the size of a test case instead of growing the slots. */
+    if(size > PERSISTENT_SLOT_SIZE)
+        size = PERSISTENT_SLOT_SIZE;
+
+    memcpy(slot->data, buf, size);
+    slot->size = size;
+
+    /* Make sure the test case is visible before the target can see the new head. */
+    atomic_fence_store();
+    atomic_store_uint32(&ring->head, head + 1);
+
+    return (0);
+}
+
+int32_t persistent_drain(struct output_writter *output)
+{
+    uint32_t i;
+
+    for(i = 0; atomic_load_uint32(&ring->tail) != atomic_load_uint32(&ring->head); i++)
+    {
+        if(check_target(output) < 0)
+        {
+            output->write(ERROR, "Can't check target\n");
+            return (-1);
+        }
+
+        if(i < 1024)
+            atomic_stall();
+        else
+            (void)sched_yield();
+    }
+
+    collect_coverage();
+
+    return (0);
+}
+
+void stop_persistent_target(void)
+{
+    if(ring == NULL)
+        return;
+
+    /* Ask the harness to leave it's loop and give it a moment before killing it. */
+    atomic_store_int32(&ring->stop, TRUE);
+
+    (void)usleep(10000);
+    (void)kill(target_pid, SIGKILL);
+    (void)waitpid(target_pid, NULL, 0);
+
+    munmap(ring, PERSISTENT_MAP_SIZE);
+    (void)unlink(ring_path);
+
+    ring = NULL;
+
+    return;
+}
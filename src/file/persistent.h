@@ -0,0 +1,120 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+#ifndef PERSISTENT_H
+#define PERSISTENT_H
+
+#include "io/io.h"
+#include "coverage/coverage.h"
+#include <stdint.h>
+
+/* Environment variable the target finds the input ring's path in. */
+#define PERSISTENT_RING_ENV "NEXTGEN_RING"
+
+/* Number of test cases that can be queued for the target. */
+#define PERSISTENT_SLOTS 16
+
+/* The largest test case we pass, bigger ones are truncated. */
+#define PERSISTENT_SLOT_SIZE (1024 * 1024)
+
+/* Size of a cache line, used to keep the producer and consumer
+   counters from sharing one. */
+#define PERSISTENT_LINE 64
+
+/**
+ * Header at the start of the shared mapping, the test case slots follow it.
+ * Nextgen is the only writer of head and stop, the target is the only writer of
+ * tail. Both counters only go up, slot n lives at n % PERSISTENT_SLOTS.
+ */
+struct persistent_ring
+{
+    /* Number of test cases nextgen has queued. */
+    uint32_t head;
+
+    /* Set to TRUE to tell the target to leave it's loop. */
+    int32_t stop;
+
+    const char padding[PERSISTENT_LINE - 8];
+
+    /* Number of test cases the target has finished. */
+    uint32_t tail;
+
+    const char padding2[PERSISTENT_LINE - 4];
+};
+
+struct persistent_slot
+{
+    /* Length of the test case in data. */
+    uint64_t size;
+
+    char data[PERSISTENT_SLOT_SIZE];
+};
+
+/* Total size of the shared mapping. */
+#define PERSISTENT_MAP_SIZE \
+    (sizeof(struct persistent_ring) + (PERSISTENT_SLOTS * sizeof(struct persistent_slot)))
+
+/* Address of slot n in the mapping starting at ring. */
+#define persistent_get_slot(ring, n) \
+    ((struct persistent_slot *)((char *)(ring) + sizeof(struct persistent_ring)) + ((n) % PERSISTENT_SLOTS))
+
+/* In persistent mode every slot has it's own trace map, so the trace of a
+   finished test case can be checked while the target runs the next one. */
+#define PERSISTENT_TRACE_SIZE (PERSISTENT_SLOTS * COVERAGE_MAP_SIZE)
+
+/* Address of slot n's trace map in the maps starting at traces. */
+#define persistent_get_trace(traces, n) ((traces) + (((n) % PERSISTENT_SLOTS) * COVERAGE_MAP_SIZE))
+
+/**
+ * Have check called with the trace map of every test case the target finishes,
+ * before the slot is handed out again. check must leave the map empty.
+ * @param traces PERSISTENT_TRACE_SIZE bytes of trace maps shared with the target.
+ * @param check Called with each finished test case's trace map.
+ */
+extern void set_persistent_coverage(uint8_t *traces, void (*check)(uint8_t *trace));
+
+/**
+ * Create the input ring and start the target with it. The target must be built
+ * against the harness in file/harness.h.
+ * @param exec_path Path to the target executable.
+ * @param output An output writter object.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t start_persistent_target(char *exec_path, struct output_writter *output);
+
+/**
+ * Queue a test case for the target, waiting for a free slot if the ring is full.
+ * Crashes and hangs found while waiting are saved and the target is restarted.
+ * @param buf The test case.
+ * @param size Length of the test case.
+ * @param output An output writter object.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t persistent_push(char *buf, uint64_t size, struct output_writter *output);
+
+/**
+ * Wait for the target to finish every queued test case. Crashes and hangs
+ * found while waiting are saved and the target is restarted.
+ * @param output An output writter object.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t persistent_drain(struct output_writter *output);
+
+/**
+ * Tell the target to exit, wait for it and remove the ring.
+ */
+extern void stop_persistent_target(void);
+
+#endif
@@ -18,10 +18,20 @@
 #include "runtime/platform.h"
 
 #include <errno.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <sys/mman.h>
 
+#ifdef LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#elif FREEBSD
+#include <sys/types.h>
+#include <sys/umtx.h>
+#endif
+
 static void *default_mem_alloc(uint64_t nbytes)
 {
     void *ptr = NULL;
@@ -47,6 +57,129 @@ static void *default_mem_alloc_shared(uint64_t nbytes)
     return (pointer);
 }
 
+/* Arena allocations are rounded up to this. */
+static const uint64_t ARENA_ALIGN = 16;
+
+static struct arena_chunk *arena_new_chunk(uint64_t size)
+{
+    struct arena_chunk *chunk = NULL;
+
+    chunk = malloc(MEM_ARENA_HEADER + size);
+    if(chunk == NULL)
+        return (NULL);
+
+    chunk->next = NULL;
+    chunk->size = size;
+
+    return (chunk);
+}
+
+struct mem_arena *mem_arena_create(uint64_t size)
+{
+    struct mem_arena *arena = NULL;
+
+    if(size == 0)
+        return (NULL);
+
+    arena = malloc(sizeof(struct mem_arena));
+    if(arena == NULL)
+        return (NULL);
+
+    arena->first = arena_new_chunk(size);
+    if(arena->first == NULL)
+    {
+        free(arena);
+        return (NULL);
+    }
+
+    arena->current = arena->first;
+    arena->offset = 0;
+
+    return (arena);
+}
+
+int32_t mem_arena_init(struct mem_arena *arena, void *buf, uint64_t size)
+{
+    if(buf == NULL || size <= MEM_ARENA_HEADER)
+        return (-1);
+
+    arena->first = buf;
+    arena->first->next = NULL;
+    arena->first->size = size - MEM_ARENA_HEADER;
+    arena->current = arena->first;
+    arena->offset = 0;
+
+    return (0);
+}
+
+void *mem_arena_alloc(struct mem_arena *arena, uint64_t nbytes)
+{
+    void *ptr = NULL;
+
+    if(nbytes == 0)
+        return (NULL);
+
+    nbytes = (nbytes + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+    /* Out of room, chain a new chunk big enough for this allocation. */
+    if(arena->offset + nbytes > arena->current->size)
+    {
+        uint64_t size = arena->first->size;
+        struct arena_chunk *chunk = NULL;
+
+        if(nbytes > size)
+            size = nbytes;
+
+        chunk = arena_new_chunk(size);
+        if(chunk == NULL)
+            return (NULL);
+
+        arena->current->next = chunk;
+        arena->current = chunk;
+        arena->offset = 0;
+    }
+
+    ptr = (char *)arena->current + MEM_ARENA_HEADER + arena->offset;
+
+    arena->offset += nbytes;
+
+    return (ptr);
+}
+
+void mem_arena_reset(struct mem_arena *arena)
+{
+    struct arena_chunk *chunk = NULL;
+    struct arena_chunk *next = NULL;
+
+    /* Give back the overflow chunks and start over in the first one. */
+    for(chunk = arena->first->next; chunk != NULL; chunk = next)
+    {
+        next = chunk->next;
+        free(chunk);
+    }
+
+    arena->first->next = NULL;
+    arena->current = arena->first;
+    arena->offset = 0;
+
+    return;
+}
+
+void mem_arena_destroy(struct mem_arena **arena)
+{
+    if((*arena) == NULL)
+        return;
+
+    mem_arena_reset((*arena));
+
+    free((*arena)->first);
+    free((*arena));
+
+    (*arena) = NULL;
+
+    return;
+}
+
 void *mem_alloc(uint64_t nbytes)
 {
     void *ptr = NULL;
@@ -161,14 +294,81 @@ void mem_free_shared(void **ptr, uint64_t nbytes)
     return;
 }
 
+/* Sleep while the word at addr still holds val, or until we are woken. */
+static void pool_wait(uint32_t *addr, uint32_t val)
+{
+#ifdef LINUX
+    /* Not a private futex, the pool is shared between processes. */
+    (void)syscall(SYS_futex, addr, FUTEX_WAIT, val, NULL, NULL, 0);
+#elif FREEBSD
+    (void)_umtx_op(addr, UMTX_OP_WAIT_UINT, val, NULL, NULL);
+#else
+    /* Nothing to sleep on, back off and let the caller check again. */
+    if(atomic_load_uint32(addr) == val)
+        (void)usleep(100);
+#endif
+
+    return;
+}
+
+/* Wake one caller sleeping on addr. */
+static void pool_wake(uint32_t *addr)
+{
+#ifdef LINUX
+    (void)syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+#elif FREEBSD
+    (void)_umtx_op(addr, UMTX_OP_WAKE, 1, NULL, NULL);
+#else
+    (void)addr;
+#endif
+
+    return;
+}
+
 void mem_clean_shared_pool(struct mem_pool_shared *pool)
 {
     if(pool == NULL)
         return;
 
+    munmap(pool, pool->map_size);
+
     return;
 }
 
+/* Payloads are rounded up to this so every block's payload is aligned. */
+static const uint64_t POOL_ALIGN = 16;
+
+/* Huge pages are only worth it for slabs at least this big. */
+static const uint64_t POOL_HUGE_PAGE = 2 * 1024 * 1024;
+
+/* Map the slab a pool lives in, on huge pages when the slab is big enough and
+   the system has them to spare, otherwise on normal pages. */
+static void *pool_map_slab(uint64_t *size)
+{
+    void *slab = NULL;
+
+#ifdef LINUX
+    if((*size) >= POOL_HUGE_PAGE)
+    {
+        uint64_t huge_size = ((*size) + POOL_HUGE_PAGE - 1) & ~(POOL_HUGE_PAGE - 1);
+
+        slab = mmap(NULL, huge_size, PROT_READ | PROT_WRITE,
+                    MAP_ANON | MAP_SHARED | MAP_HUGETLB, -1, 0);
+        if(slab != MAP_FAILED)
+        {
+            (*size) = huge_size;
+            return (slab);
+        }
+    }
+#endif
+
+    slab = default_mem_alloc_shared((*size));
+    if(slab == NULL)
+        return (NULL);
+
+    return (slab);
+}
+
 struct mem_pool_shared *mem_create_shared_pool(uint32_t block_size,
                                                uint32_t block_count)
 {
@@ -180,107 +380,170 @@ struct mem_pool_shared *mem_create_shared_pool(uint32_t block_size,
     }
 
     /* If the block_count is zero return NULL. */
-    if(block_count == 0)
+    if(block_count == 0 || block_count == MEM_POOL_EMPTY)
     {
         printf("block_count is zero\n");
         return NULL;
     }
 
     struct mem_pool_shared *pool = NULL;
-
-    /* Allocate the pool structure as shared memory. */
-    pool = default_mem_alloc_shared(sizeof(struct mem_pool_shared));
+    uint64_t stride = ((uint64_t)block_size + POOL_ALIGN - 1) & ~(POOL_ALIGN - 1);
+    uint64_t headers = sizeof(struct mem_pool_shared) +
+                       ((uint64_t)block_count * sizeof(struct memory_block));
+    uint64_t payload_offset = (headers + POOL_ALIGN - 1) & ~(POOL_ALIGN - 1);
+    uint64_t map_size = payload_offset + ((uint64_t)block_count * stride);
+
+    /* The pool, it's block headers and the payloads all share one slab,
+       instead of a mapping for every header and every payload. */
+    pool = pool_map_slab(&map_size);
     if(pool == NULL)
     {
         printf("Can't allocate shared memory\n");
         return (NULL);
     }
 
-    /* Initialize the memory pool. */
-    struct mem_pool_shared s_pool = {
-        .lock = NX_SPINLOCK_INITIALIZER,
-        .block_size = block_size,
-        .block_count = block_count,
-        .free_list = NX_SLIST_HEAD_INITIALIZER(s_pool->free_list),
-        .allocated_list = NX_SLIST_HEAD_INITIALIZER(s_pool->allocated_list)
-    };
-
-    memmove(pool, &s_pool, sizeof(struct mem_pool_shared));
-
-    /* Init the free and allocated block list. */
-    NX_SLIST_INIT(&pool->free_list);
-    NX_SLIST_INIT(&pool->allocated_list);
+    pool->block_size = block_size;
+    pool->block_count = block_count;
+    pool->map_size = map_size;
+    pool->free_seq = 0;
+    pool->waiters = 0;
+    pool->free_count = block_count;
+    pool->retired_count = 0;
+    pool->retired_head = MEM_POOL_EMPTY;
 
     uint32_t i;
+    char *payloads = (char *)pool + payload_offset;
 
-    /* Create blocks of the number requested by the caller of this function. */
+    /* Carve the blocks out of the slab. */
     for(i = 0; i < block_count; i++)
     {
-        /* Declare memory block. */
-        struct memory_block *block = NULL;
-
-        /* Allocate the memory block as shared memory. */
-        block = default_mem_alloc_shared(sizeof(struct memory_block));
-        if(block == NULL)
-        {
-            printf("Can't alloc mem_block\n");
-            return (NULL);
-        }
+        struct memory_block *block = &pool->blocks[i];
 
-        /* Allocate enough space for the user to store what they want. */
-        block->ptr = default_mem_alloc_shared(block_size);
-        if(block->ptr == NULL)
-        {
-            printf("Can't alloc memory block pointer.\n");
-            return (NULL);
-        }
+        block->ptr = payloads + ((uint64_t)i * stride);
+        block->index = i;
+        block->allocated = FALSE;
 
-        /* Insert the node in the free list. */
-        NX_SLIST_INSERT_HEAD(&pool->free_list, block);
+        /* Chain the block onto the free stack, slot zero ends up on top. */
+        block->next = (i + 1 < block_count) ? i + 1 : MEM_POOL_EMPTY;
     }
 
+    pool->free_head = 0;
+
     /* Return memory pool pointer. */
     return (pool);
 }
 
-struct memory_block *mem_get_shared_block(struct mem_pool_shared *pool)
+/* Pop up to count blocks off the stack at head with one CAS, returns how many we got. */
+static uint32_t pool_pop(struct mem_pool_shared *pool,
+                         uint64_t *head_ptr,
+                         struct memory_block **blocks,
+                         uint32_t count)
 {
-    /* Declare a memory block pointer. */
-    struct memory_block *block = NULL;
-
-    /* Loop until we get a shared block. */
     while(1)
     {
-        /* Lock the spinlock for exclusive access. */
-        nx_spinlock_lock(&pool->lock);
-
-        /* Get first node in list and break out of both loops. */
-        NX_SLIST_FOREACH(block, &pool->free_list)
+        uint32_t total = 0;
+        uint64_t head = atomic_load_uint64(head_ptr);
+        uint32_t index = (uint32_t)head;
+
+        /* Walk down from the top. If another caller changes the stack under us
+           the links we read may be stale, but the tag will have changed so our
+           CAS fails and we start over. Stale links are only bounds checked. */
+        while(total < count && index != MEM_POOL_EMPTY && index < pool->block_count)
         {
-            /* Remove the block from the free_list. */
-            NX_SLIST_REMOVE(&pool->free_list, block, memory_block);
-
-            /* Add the block to the allocated block list. */
-            NX_SLIST_INSERT_HEAD(&pool->allocated_list, block);
-
-            if(block != NULL)
-            {
-            /* Were jumping out of the loop, so unlock
-               the spin lock now, before jumping. */
-                nx_spinlock_unlock(&pool->lock);
-                goto done;
-            }
+            blocks[total] = &pool->blocks[index];
+            total++;
+
+            index = atomic_load_uint32(&pool->blocks[index].next);
         }
 
-        /* Unlock the spinlock. */
-        nx_spinlock_unlock(&pool->lock);
+        if(total == 0)
+            return (0);
+
+        uint64_t tag = (head >> 32) + 1;
+
+        if(atomic_cas_uint64(head_ptr, head, (tag << 32) | index) == true)
+            return (total);
     }
+}
+
+/* Push count blocks on to the stack at head with one CAS, blocks[0] ends up on top. */
+static void pool_push(uint64_t *head_ptr, struct memory_block **blocks, uint32_t count)
+{
+    uint32_t i;
+
+    /* Chain the blocks together first, only the bottom one's link depends on the stack. */
+    for(i = 0; i + 1 < count; i++)
+        atomic_store_uint32(&blocks[i]->next, blocks[i + 1]->index);
+
+    while(1)
+    {
+        uint64_t head = atomic_load_uint64(head_ptr);
+        uint64_t tag = (head >> 32) + 1;
+
+        atomic_store_uint32(&blocks[count - 1]->next, (uint32_t)head);
+
+        /* Make sure the links are visible before the blocks are on the stack. */
+        atomic_fence_store();
+
+        if(atomic_cas_uint64(head_ptr, head, (tag << 32) | blocks[0]->index) == true)
+            return;
+    }
+}
+
+uint32_t mem_get_shared_blocks(struct mem_pool_shared *pool,
+                               struct memory_block **blocks,
+                               uint32_t count)
+{
+    uint32_t i;
+    uint32_t total = 0;
+
+    if(count == 0)
+        return (0);
+
+    /* Every block is handed out or waiting to be checked. */
+    total = pool_pop(pool, &pool->free_head, blocks, count);
+    if(total == 0)
+        return (0);
+
+    atomic_sub_uint32(&pool->free_count, total);
+
+    for(i = 0; i < total; i++)
+        atomic_store_int32(&blocks[i]->allocated, TRUE);
+
+    return (total);
+}
+
+struct memory_block *mem_try_get_shared_block(struct mem_pool_shared *pool)
+{
+    struct memory_block *block = NULL;
+
+    if(mem_get_shared_blocks(pool, &block, 1) == 0)
+        return (NULL);
 
-done:
-    /* Return the empty block. */
     return (block);
 }
 
+struct memory_block *mem_get_shared_block(struct mem_pool_shared *pool)
+{
+    struct memory_block *block = NULL;
+
+    while(1)
+    {
+        /* Read the sequence before looking at the stack, a free that lands
+           after our look changes it so the wait below returns right away. */
+        uint32_t seq = atomic_load_uint32(&pool->free_seq);
+
+        block = mem_try_get_shared_block(pool);
+        if(block != NULL)
+            return (block);
+
+        /* Sleep until someone frees a block instead of spinning. */
+        atomic_add_uint32(&pool->waiters, 1);
+        pool_wait(&pool->free_seq, seq);
+        atomic_dec_uint32(&pool->waiters);
+    }
+}
+
 void mem_free_shared_block(struct memory_block *block,
                            struct mem_pool_shared *pool)
 {
@@ -296,21 +559,73 @@ void mem_free_shared_block(struct memory_block *block,
         return;
     }
 
-    /* Lock the spinlock. */
-    nx_spinlock_lock(&pool->lock);
+    atomic_store_int32(&block->allocated, FALSE);
+
+    pool_push(&pool->free_head, &block, 1);
 
-    /* Remove the block from the allocated_list. */
-    NX_SLIST_REMOVE(&pool->allocated_list, block, memory_block);
+    atomic_add_uint32(&pool->free_count, 1);
 
-    /* Add the block to the free block list. */
-    NX_SLIST_INSERT_HEAD(&pool->free_list, block);
+    /* The CAS in pool_push() is a full barrier so this can't pass it, and a
+       waiter that read the old sequence won't sleep through the change. */
+    atomic_add_uint32(&pool->free_seq, 1);
 
-    /* Unlock the spinlock. */
-    nx_spinlock_unlock(&pool->lock);
+    if(atomic_load_uint32(&pool->waiters) > 0)
+        pool_wake(&pool->free_seq);
 
     return;
 }
 
+void mem_retire_shared_blocks(struct memory_block **blocks,
+                              uint32_t count,
+                              struct mem_pool_shared *pool)
+{
+    uint32_t i;
+
+    if(pool == NULL)
+    {
+        printf("Pool is NULL\n");
+        return;
+    }
+
+    if(count == 0)
+        return;
+
+    for(i = 0; i < count; i++)
+        atomic_store_int32(&blocks[i]->allocated, FALSE);
+
+    pool_push(&pool->retired_head, blocks, count);
+
+    atomic_add_uint32(&pool->retired_count, count);
+
+    return;
+}
+
+void mem_retire_shared_block(struct memory_block *block,
+                             struct mem_pool_shared *pool)
+{
+    if(block == NULL)
+    {
+        printf("Block is NULL\n");
+        return;
+    }
+
+    mem_retire_shared_blocks(&block, 1, pool);
+
+    return;
+}
+
+struct memory_block *mem_get_retired_block(struct mem_pool_shared *pool)
+{
+    struct memory_block *block = NULL;
+
+    if(pool_pop(pool, &pool->retired_head, &block, 1) == 0)
+        return (NULL);
+
+    atomic_dec_uint32(&pool->retired_count);
+
+    return (block);
+}
+
 static void default_mem_free(void **ptr)
 {
     /* Return early if the pointer is already NULL. */
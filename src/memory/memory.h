@@ -24,7 +24,16 @@ struct memory_block
 {
     void *ptr;
 
-    NX_SLIST_ENTRY(memory_block);
+    /* The block's slot in the pool, blocks[index]. */
+    uint32_t index;
+
+    /* Slot of the block under this one on the free stack. */
+    uint32_t next;
+
+    /* TRUE while the block is handed out. */
+    int32_t allocated;
+
+    const char padding[4];
 };
 
 struct memory_allocator
@@ -35,11 +44,26 @@ struct memory_allocator
     void (*free_shared) (void **, uint64_t);
 };
 
-/* Memory pool data structure. */
+/* Marks the bottom of a pool's free stack. */
+#define MEM_POOL_EMPTY UINT32_MAX
+
+/**
+ * Memory pool data structure. The pool, it's block headers and the block payloads
+ * live in one shared slab so the pool works across fork(). Free blocks are kept on
+ * a lock free stack of slot indices, get and free are a single compare and swap.
+ */
 struct mem_pool_shared
 {
-    /* Spin lock used to protect underlying data structures in the pool. */
-    ck_spinlock_t lock;
+    /* Top of the free stack, the slot index is in the low 32 bits and a tag
+       that changes on every pop and push is in the high 32 bits, so a slot that
+       is popped and pushed back between our load and our CAS can't fool us. */
+    uint64_t free_head;
+
+    /* Bumped on every free, waiters sleep on it when the pool is empty. */
+    uint32_t free_seq;
+
+    /* Number of callers sleeping in mem_get_shared_block(). */
+    uint32_t waiters;
 
     /* The size of the memory block that ptr points at. */
     uint32_t block_size;
@@ -47,33 +71,173 @@ struct mem_pool_shared
     /* The number of blocks in the memory pool. */
     uint32_t block_count;
 
-    const char padding[4];
+    /* Size of the slab holding the pool, it's block headers and payloads. */
+    uint64_t map_size;
+
+    /* Top of the stack of blocks given back with mem_retire_shared_block(),
+       tagged like free_head. They wait here until the owner checks them. */
+    uint64_t retired_head;
+
+    /* Number of blocks on the free stack. */
+    uint32_t free_count;
+
+    /* Number of blocks on the retired stack. */
+    uint32_t retired_count;
 
-    /* Shared memory list that represents the memory pool. */
-    NX_SLIST_HEAD(free_list, memory_block);
+    struct memory_block blocks[];
+};
+
+/* A chunk of arena memory, the bytes handed out follow the header. */
+struct arena_chunk
+{
+    struct arena_chunk *next;
 
-    /* Shared memory list that represents the memory pool. */
-    NX_SLIST_HEAD(allocated_list, memory_block);
+    /* Usable bytes after the header. */
+    uint64_t size;
 };
 
+/* Bytes at the start of a chunk taken by it's header, rounded up so the first
+   allocation in the chunk is aligned. */
+#define MEM_ARENA_HEADER ((sizeof(struct arena_chunk) + 15) & ~(uint64_t)15)
+
 /**
- * Macro for initializing a shared memory pool.
+ * Bump allocator for memory that lives until the next reset. There is no
+ * per allocation free, mem_arena_reset() releases everything at once.
  */
-#define init_shared_pool(pool,block) CK_SLIST_FOREACH(block, pool->free_list, list_entry)
+struct mem_arena
+{
+    /* The first chunk, kept across resets. */
+    struct arena_chunk *first;
+
+    /* The chunk we are allocating from. */
+    struct arena_chunk *current;
+
+    /* Offset of the next free byte in current. */
+    uint64_t offset;
+};
+
+/**
+ * Macro for initializing a shared memory pool, loops over every block in the pool.
+ */
+#define init_shared_pool(pool, block) \
+    for((block) = (pool)->blocks; (block) < (pool)->blocks + (pool)->block_count; (block)++)
+
+/**
+ * Loop over the blocks of pool that are handed out.
+ */
+#define mem_foreach_allocated_block(pool, block) \
+    init_shared_pool(pool, block) \
+        if(atomic_load_int32(&(block)->allocated) != 0)
 
 /**
  * @return the default heap memory allocator.
  */
 extern struct memory_allocator *get_default_allocator(void);
 
+/**
+ * Unmap a pool created by mem_create_shared_pool() along with it's payloads.
+ */
 extern void mem_clean_shared_pool(struct mem_pool_shared *pool);
 
+/**
+ * Take a block from the pool, sleeping until one is freed if the pool is empty.
+ * @param pool The pool to take a block from.
+ * @return A memory block.
+ */
 extern struct memory_block *mem_get_shared_block(struct mem_pool_shared *pool);
 
+/**
+ * Take a block from the pool without waiting.
+ * @param pool The pool to take a block from.
+ * @return A memory block or NULL if every block is handed out.
+ */
+extern struct memory_block *mem_try_get_shared_block(struct mem_pool_shared *pool);
+
+/**
+ * Take up to count blocks from the pool without waiting, the pool is only
+ * touched once however many blocks are taken.
+ * @param pool The pool to take blocks from.
+ * @param blocks Where the blocks are placed, must have room for count of them.
+ * @param count The most blocks to take.
+ * @return The number of blocks taken, zero if every block is handed out.
+ */
+extern uint32_t mem_get_shared_blocks(struct mem_pool_shared *pool,
+                                      struct memory_block **blocks,
+                                      uint32_t count);
+
+/**
+ * Give a block back to the pool it came from and wake a waiter if there is one.
+ */
 extern void mem_free_shared_block(struct memory_block *block, struct mem_pool_shared *pool);
 
+/**
+ * Create a pool of block_count blocks, each with a block_size byte payload. The pool is
+ * one shared mapping, on huge pages if it's big enough and they are available.
+ * @return A memory pool on success and NULL on failure.
+ */
 extern struct mem_pool_shared *mem_create_shared_pool(uint32_t block_size, uint32_t block_count);
 
+/**
+ * Give a block back to the pool without making it available. It waits on the
+ * pool's retired stack until the pool's owner takes it with mem_get_retired_block(),
+ * checks it and frees it with mem_free_shared_block().
+ */
+extern void mem_retire_shared_block(struct memory_block *block, struct mem_pool_shared *pool);
+
+/**
+ * Retire count blocks at once, the pool is only touched once.
+ */
+extern void mem_retire_shared_blocks(struct memory_block **blocks,
+                                     uint32_t count,
+                                     struct mem_pool_shared *pool);
+
+/**
+ * Take a block off the pool's retired stack.
+ * @return A retired block or NULL if there are none.
+ */
+extern struct memory_block *mem_get_retired_block(struct mem_pool_shared *pool);
+
+/**
+ * Create an arena.
+ * @param size Size of the first chunk, the arena grows past it if needed.
+ * @return An arena on success and NULL on failure.
+ */
+extern struct mem_arena *mem_arena_create(uint64_t size);
+
+/**
+ * Set up an arena whose first chunk is a buffer the caller owns, so the arena
+ * can be embedded in a bigger structure. Don't call mem_arena_destroy() on it.
+ * @param arena The arena to set up.
+ * @param buf A 16 byte aligned buffer, the chunk header takes the start of it.
+ * @param size Size of buf in bytes.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t mem_arena_init(struct mem_arena *arena, void *buf, uint64_t size);
+
+/* Where the first allocation in arena's first chunk starts. */
+#define mem_arena_base(arena) ((char *)(arena)->first + MEM_ARENA_HEADER)
+
+/**
+ * Allocate from an arena, the memory is 16 byte aligned.
+ * @param arena The arena to allocate from.
+ * @param nbytes Number of bytes to allocate.
+ * @return A pointer on success and NULL on failure.
+ */
+extern void *mem_arena_alloc(struct mem_arena *arena, uint64_t nbytes);
+
+/**
+ * Release every allocation made since the last reset. Chunks added because the
+ * first one filled up are freed, so the arena does not grow with use.
+ * @param arena The arena to reset.
+ */
+extern void mem_arena_reset(struct mem_arena *arena);
+
+/**
+ * Free an arena and everything allocated from it.
+ * @param arena A pointer to the arena pointer, set to NULL.
+ */
+extern void mem_arena_destroy(struct mem_arena **arena);
+
 /* General purpose heap memory allocator. */
 DEPRECATED extern void *mem_alloc(uint64_t nbytes);
 
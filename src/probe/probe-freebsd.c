@@ -19,16 +19,20 @@
 
 #include <string.h>
 #include <errno.h>
+#include <signal.h>
 #include <sys/wait.h>
 #include <sys/ptrace.h>
 #include <machine/reg.h>
 
 static pid_t pid;
 
-int32_t start_and_pause_target(char *exec_path, pid_t *target_pid)
+int32_t start_and_pause_target(char *exec_path,
+                               char *input_path,
+                               pid_t *target_pid,
+                               struct output_writter *output)
 {
     int32_t rtrn = 0;
-    char * const argv[] = {"blah", NULL};
+    char * const argv[] = {exec_path, input_path, NULL};
 
     /* Create child process. */
     (*target_pid) = fork();
@@ -41,7 +45,7 @@ int32_t start_and_pause_target(char *exec_path, pid_t *target_pid)
         rtrn = drop_privileges();
         if(rtrn < 0)
         {
-            output(ERROR, "Can't drop privileges\n");
+            output->write(ERROR, "Can't drop privileges\n");
             return (-1);
         }
         /* Let's announce we want to be traced so that we don't execute any instructions on execv. */
@@ -51,7 +55,7 @@ int32_t start_and_pause_target(char *exec_path, pid_t *target_pid)
         rtrn = execv(exec_path, argv);
         if(rtrn < 0)
         {
-            output(ERROR, "execv: %s\n", errno);
+            output->write(ERROR, "execv: %s\n", strerror(errno));
             return -1;
         }
 
@@ -69,21 +73,21 @@ int32_t start_and_pause_target(char *exec_path, pid_t *target_pid)
 
         if(WIFCONTINUED(status) != 0)
         {
-            output(ERROR, "The process we are testing is continuing?\n");
+            output->write(ERROR, "The process we are testing is continuing?\n");
             return -1;
         }
 
         /* Check if the process exited. */
         if(WIFEXITED(status) != 0)
         {
-            output(ERROR, "The process we are testing has exited prematurely\n");
+            output->write(ERROR, "The process we are testing has exited prematurely\n");
             return -1;
         }
 
         /* Check if the process was terminated due to a signal. */
         if(WIFSIGNALED(status) != 0)
         {
-            output(ERROR, "The process we are testing has exited due to a signal\n");
+            output->write(ERROR, "The process we are testing has exited due to a signal\n");
             return -1;
         }
 
@@ -103,10 +107,10 @@ EXIT:
     return 0;
 }
 
-int32_t inject_fork_server(uint64_t main_address)
+int32_t inject_fork_server(uint64_t main_address, struct output_writter *output)
 {
     (void)main_address;
-    output(STD, "Creating fork server\n");
+    output->write(STD, "Creating fork server\n");
 
     /* Variables. */
     struct reg regs;
@@ -130,21 +134,21 @@ int32_t inject_fork_server(uint64_t main_address)
 
     if(WIFCONTINUED(status) != 0)
     {
-        output(ERROR, "The process we are testing is continuing?\n");
+        output->write(ERROR, "The process we are testing is continuing?\n");
         return -1;
     }
 
     /* Check if the process exited. */
     if(WIFEXITED(status) != 0)
     {
-        output(ERROR, "The process we are testing has exited prematurely\n");
+        output->write(ERROR, "The process we are testing has exited prematurely\n");
         return -1;
     }
 
     /* Check if the process was terminated due to a signal. */
     if(WIFSIGNALED(status) != 0)
     {
-        output(ERROR, "The process we are testing has exited due to a signal\n");
+        output->write(ERROR, "The process we are testing has exited due to a signal\n");
         return -1;
     }
 
@@ -163,3 +167,42 @@ int32_t inject_fork_server(uint64_t main_address)
     return 0;
 }
 
+int32_t fork_server_clone(pid_t *clone_pid, struct output_writter *output)
+{
+    (void)clone_pid;
+    output->write(ERROR, "The fork server is not supported on this platform yet\n");
+    return (-1);
+}
+
+int32_t inject_block_probes(const uint64_t *blocks,
+                            uint64_t total,
+                            uint8_t *trace,
+                            struct output_writter *output)
+{
+    (void)blocks;
+    (void)total;
+    (void)trace;
+    output->write(ERROR, "Block probes are not supported on this platform yet\n");
+    return (-1);
+}
+
+int32_t handle_probe_stop(pid_t clone_pid, int32_t status, struct output_writter *output)
+{
+    (void)clone_pid;
+    (void)status;
+    output->write(ERROR, "Block probes are not supported on this platform yet\n");
+    return (-1);
+}
+
+void cleanup_fork_server(void)
+{
+    if(pid == 0)
+        return;
+
+    (void)kill(pid, SIGKILL);
+    (void)waitpid(pid, NULL, 0);
+
+    pid = 0;
+
+    return;
+}
@@ -1,35 +1,761 @@
-
 /**
  * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
- * 
+ *
  * Permission to use, copy, modify, and/or distribute this software for any purpose
- * with or without fee is hereby granted, provided that the above copyright notice 
+ * with or without fee is hereby granted, provided that the above copyright notice
  * and this permission notice appear in all copies.
- * 
- * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH 
- * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY 
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
  * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
- * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, 
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
  * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
  * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  **/
 
+#define _GNU_SOURCE
+
 #include "probe.h"
+#include "concurrent/concurrent.h"
+#include "io/io.h"
+#include "runtime/platform.h"
+#include "utils/autoclose.h"
+
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <linux/kcov.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/user.h>
+#include <sys/wait.h>
 
 struct probe_ctx
 {
-	int32_t member;
+    /* The kcov file descriptor, tracing is tied to the thread that enabled it. */
+    int32_t fd;
+
+    const char padding[4];
+
+    /* The coverage buffer, the first word is the number of PCs that follow it. */
+    uint64_t *cover;
+};
+
+/* The shift that takes a 64 bit hash down to one of the
+   COVERAGE_MAP_SIZE (2^16) edges in a trace map. */
+#define COVERAGE_MAP_SHIFT 48
+
+static int32_t kcov_open(const char *path)
+{
+    return (open(path, O_RDWR));
+}
+
+static int32_t kcov_ioctl(int32_t fd, unsigned long request, unsigned long arg)
+{
+    return (ioctl(fd, request, arg));
+}
+
+static void *kcov_map(int32_t fd, uint64_t size)
+{
+    void *cover = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(cover == MAP_FAILED)
+        return (NULL);
+
+    return (cover);
+}
+
+static void kcov_unmap(void *cover, uint64_t size)
+{
+    (void)munmap(cover, size);
+}
+
+static void kcov_close(int32_t fd)
+{
+    (void)close(fd);
+}
+
+static struct kcov_device real_kcov = {
+
+    .open = &kcov_open,
+    .ioctl = &kcov_ioctl,
+    .map = &kcov_map,
+    .unmap = &kcov_unmap,
+    .close = &kcov_close
+
 };
 
-int32_t start_and_pause_target(char *exec_path, pid_t *target_pid)
+static struct kcov_device *kcov = &real_kcov;
+
+/* The code we plant at main() in the fork server, it's
+   "syscall; int3" in little endian byte order. */
+#define FORK_STUB      0xCC050F
+#define FORK_STUB_MASK 0xFFFFFFFFFF000000
+
+/* The PID of the paused target process that gets cloned for each test case. */
+static pid_t server_pid;
+
+/* Path of the target executable the fork server is running. */
+static char *server_path;
+
+/* The runtime address of main() in the fork server. */
+static uint64_t server_main;
+
+/* The instructions at main() before we planted anything there. */
+static uint64_t orig_word;
+
+/* The fork server's registers at the entry of main(). */
+static struct user_regs_struct server_regs;
+
+/* How far the fork server was relocated from it's link time addresses. */
+static uint64_t server_bias;
+
+/* Runtime addresses of the blocks we planted breakpoints at, from lowest to highest. */
+static uint64_t *probe_address;
+
+/* The byte each breakpoint replaced. */
+static uint8_t *probe_orig;
+
+static uint64_t total_probes;
+
+/* Trace map the blocks clones reach are counted in. */
+static uint8_t *probe_trace;
+
+void set_kcov_device(struct kcov_device *device)
+{
+    kcov = (device != NULL) ? device : &real_kcov;
+
+    return;
+}
+
+static const char *get_kcov_path(void)
+{
+    const char *path = getenv(KCOV_PATH_ENV);
+
+    return ((path != NULL) ? path : KCOV_PATH);
+}
+
+int32_t check_kernel_probes(struct output_writter *output)
+{
+    const char *path = get_kcov_path();
+
+    int32_t fd = kcov->open(path);
+    if(fd < 0)
+    {
+        output->write(ERROR, "Can't open %s, smart mode needs a kernel built with CONFIG_KCOV: %s\n",
+                      path, strerror(errno));
+        return (-1);
+    }
+
+    kcov->close(fd);
+
+    return (0);
+}
+
+int32_t inject_kernel_probes(struct probe_ctx **probe,
+                             struct memory_allocator *allocator,
+                             struct output_writter *output)
+{
+    struct probe_ctx *ctx = NULL;
+    const char *path = get_kcov_path();
+
+    ctx = allocator->alloc(sizeof(struct probe_ctx));
+    if(ctx == NULL)
+    {
+        output->write(ERROR, "Can't allocate probe context\n");
+        return (-1);
+    }
+
+    ctx->fd = kcov->open(path);
+    if(ctx->fd < 0)
+    {
+        output->write(ERROR, "Can't open %s: %s\n", path, strerror(errno));
+        allocator->free((void **)&ctx);
+        return (-1);
+    }
+
+    /* Size the trace in words before mapping it. */
+    if(kcov->ioctl(ctx->fd, KCOV_INIT_TRACE, KCOV_COVER_SIZE) < 0)
+    {
+        output->write(ERROR, "Can't init kcov trace: %s\n", strerror(errno));
+        goto fail;
+    }
+
+    ctx->cover = kcov->map(ctx->fd, KCOV_COVER_SIZE * sizeof(uint64_t));
+    if(ctx->cover == NULL)
+    {
+        output->write(ERROR, "Can't map kcov buffer: %s\n", strerror(errno));
+        goto fail;
+    }
+
+    /* Trace this thread from here on. We leave tracing on and reset the count around
+       each syscall instead, so we don't pay for two more ioctls per test case. */
+    if(kcov->ioctl(ctx->fd, KCOV_ENABLE, KCOV_TRACE_PC) < 0)
+    {
+        output->write(ERROR, "Can't enable kcov: %s\n", strerror(errno));
+        kcov->unmap(ctx->cover, KCOV_COVER_SIZE * sizeof(uint64_t));
+        goto fail;
+    }
+
+    atomic_store_uint64(&ctx->cover[0], 0);
+
+    (*probe) = ctx;
+
+    return (0);
+
+fail:
+    kcov->close(ctx->fd);
+    allocator->free((void **)&ctx);
+    return (-1);
+}
+
+int32_t cleanup_kernel_probes(struct probe_ctx **probe, struct memory_allocator *allocator)
+{
+    struct probe_ctx *ctx = (*probe);
+
+    /* Children that died before injecting probes have nothing to clean. */
+    if(ctx == NULL)
+        return (0);
+
+    (void)kcov->ioctl(ctx->fd, KCOV_DISABLE, 0);
+    kcov->unmap(ctx->cover, KCOV_COVER_SIZE * sizeof(uint64_t));
+    kcov->close(ctx->fd);
+
+    allocator->free((void **)probe);
+
+    return (0);
+}
+
+void start_kernel_coverage(struct probe_ctx *probe)
+{
+    atomic_store_uint64(&probe->cover[0], 0);
+
+    return;
+}
+
+uint32_t collect_kernel_coverage(struct probe_ctx *probe, uint8_t *trace)
 {
-	(void)exec_path;
-	(void)target_pid;
+    uint64_t i;
+    uint32_t prev = 0;
+
+    uint64_t total = atomic_load_uint64(&probe->cover[0]);
+
+    /* The kernel stops recording when the buffer is full. */
+    if(total > KCOV_COVER_SIZE - 1)
+        total = KCOV_COVER_SIZE - 1;
+
+    for(i = 1; i <= total; i++)
+    {
+        /* Like AFL, an edge is the hash of where we came from and where we are, with
+           the previous location shifted so A to B and B to A are different edges. */
+        uint32_t cur = (uint32_t)((probe->cover[i] * 0x9E3779B97F4A7C15ULL) >> COVERAGE_MAP_SHIFT);
+        uint32_t edge = cur ^ prev;
+
+        prev = cur >> 1;
+
+        /* Stick at the top bucket instead of wrapping back to zero hits. */
+        if(trace[edge] != UINT8_MAX)
+            trace[edge]++;
+    }
+
+    return ((uint32_t)total);
+}
+
+static int32_t wait_for_trap(pid_t pid, struct output_writter *output)
+{
+    int32_t status = 0;
+
+    if(waitpid(pid, &status, __WALL) < 0)
+    {
+        output->write(ERROR, "waitpid: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    /* Check if the process exited. */
+    if(WIFEXITED(status) != 0)
+    {
+        output->write(ERROR, "The process we are testing has exited prematurely\n");
+        return (-1);
+    }
+
+    /* Check if the process was terminated due to a signal. */
+    if(WIFSIGNALED(status) != 0)
+    {
+        output->write(ERROR, "The process we are testing has exited due to a signal\n");
+        return (-1);
+    }
+
+    /* The only stop we expect here is the trap from exec or one of our int3's. */
+    if(WIFSTOPPED(status) == 0 || WSTOPSIG(status) != SIGTRAP)
+    {
+        output->write(ERROR, "The process we are testing stopped unexpectedly\n");
+        return (-1);
+    }
+
     return (0);
 }
 
-int32_t inject_fork_server(uint64_t main_address)
+static int32_t get_load_bias(pid_t pid, uint64_t *bias, struct output_writter *output)
 {
-	(void)main_address;
-	return (0);
+    ssize_t ret = 0;
+    Elf64_Ehdr ehdr;
+    Elf64_auxv_t aux;
+    char path[64];
+    int32_t fd auto_close = 0;
+    int32_t auxv auto_close = 0;
+
+    /* Read the link time entry point from the ELF header. */
+    fd = open(server_path, O_RDONLY);
+    if(fd < 0)
+    {
+        output->write(ERROR, "open: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    ret = read(fd, &ehdr, sizeof(Elf64_Ehdr));
+    if(ret != sizeof(Elf64_Ehdr))
+    {
+        output->write(ERROR, "Can't read ELF header\n");
+        return (-1);
+    }
+
+    (void)snprintf(path, sizeof(path), "/proc/%d/auxv", pid);
+
+    /* The kernel tells the target where it's entry point ended up in
+      the aux vector, the difference is how far the target was relocated. */
+    auxv = open(path, O_RDONLY);
+    if(auxv < 0)
+    {
+        output->write(ERROR, "open: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    while(read(auxv, &aux, sizeof(Elf64_auxv_t)) == sizeof(Elf64_auxv_t))
+    {
+        if(aux.a_type != AT_ENTRY)
+            continue;
+
+        (*bias) = aux.a_un.a_val - ehdr.e_entry;
+
+        return (0);
+    }
+
+    output->write(ERROR, "Can't find the target's entry point\n");
+
+    return (-1);
+}
+
+int32_t start_and_pause_target(char *exec_path,
+                               char *input_path,
+                               pid_t *target_pid,
+                               struct output_writter *output)
+{
+    (*target_pid) = fork();
+    if((*target_pid) == 0)
+    {
+        char * const argv[] = {exec_path, input_path, NULL};
+
+        /* Let's announce we want to be traced so that we stop right after execv. */
+        if(ptrace(PTRACE_TRACEME, 0, NULL, NULL) < 0)
+            _exit(-1);
+
+        /* Now we execute the target binary. */
+        (void)execv(exec_path, argv);
+
+        _exit(-1);
+    }
+    else if((*target_pid) < 0)
+    {
+        output->write(ERROR, "Can't create target process: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    /* Wait until the target binary has stopped on the exec trap. */
+    if(wait_for_trap((*target_pid), output) < 0)
+    {
+        output->write(ERROR, "Can't pause target\n");
+        return (-1);
+    }
+
+    server_pid = (*target_pid);
+    server_path = exec_path;
+
+    return (0);
+}
+
+int32_t inject_fork_server(uint64_t main_address, struct output_writter *output)
+{
+    int32_t rtrn = 0;
+    uint64_t bias = 0;
+
+    output->write(STD, "Creating fork server\n");
+
+    /* PIE targets get relocated so work out the runtime address of main. */
+    rtrn = get_load_bias(server_pid, &bias, output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't get target load address\n");
+        return (-1);
+    }
+
+    server_main = main_address + bias;
+    server_bias = bias;
+
+    /* Lets save the code at main in the target process. */
+    errno = 0;
+    orig_word = (uint64_t)ptrace(PTRACE_PEEKTEXT, server_pid, (void *)server_main, NULL);
+    if(errno != 0)
+    {
+        output->write(ERROR, "Can't read main: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    /* Let's set a breakpoint on main. */
+    if(ptrace(PTRACE_POKETEXT, server_pid, (void *)server_main,
+              (void *)((orig_word & TRAP_MASK) | TRAP_INST)) < 0)
+    {
+        output->write(ERROR, "Can't set breakpoint: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    /* Have the kernel stop and attach every clone the server makes,
+      and kill the server if we die. */
+    if(ptrace(PTRACE_SETOPTIONS, server_pid, NULL,
+              (void *)(PTRACE_O_TRACEFORK | PTRACE_O_TRACECLONE | PTRACE_O_EXITKILL)) < 0)
+    {
+        output->write(ERROR, "Can't set trace options: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    /* Now we continue until the breakpoint, dynamic linking and
+      constructors run once here instead of once per test case. */
+    if(ptrace(PTRACE_CONT, server_pid, NULL, NULL) < 0)
+    {
+        output->write(ERROR, "Can't continue target: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    rtrn = wait_for_trap(server_pid, output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Target never reached main\n");
+        return (-1);
+    }
+
+    /* Lets grab the registers at main/breakpoint and rewind past the int3. */
+    if(ptrace(PTRACE_GETREGS, server_pid, NULL, &server_regs) < 0)
+    {
+        output->write(ERROR, "Can't get registers: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    server_regs.rip = server_main;
+
+    /* Swap the breakpoint for the fork stub, we point the server at it on every clone. */
+    if(ptrace(PTRACE_POKETEXT, server_pid, (void *)server_main,
+              (void *)((orig_word & FORK_STUB_MASK) | FORK_STUB)) < 0)
+    {
+        output->write(ERROR, "Can't write fork stub: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    return (0);
+}
+
+int32_t fork_server_clone(pid_t *pid, struct output_writter *output)
+{
+    int32_t status = 0;
+    unsigned long msg = 0;
+    struct user_regs_struct regs = server_regs;
+
+    /* Have the server run clone(CLONE_PARENT | SIGCHLD) from the stub at main.
+      CLONE_PARENT makes us the parent of the clone so we can wait on and reap it. */
+    regs.rip = server_main;
+    regs.rax = SYS_clone;
+    regs.rdi = CLONE_PARENT | SIGCHLD;
+    regs.rsi = 0;
+    regs.rdx = 0;
+    regs.r10 = 0;
+    regs.r8 = 0;
+
+    if(ptrace(PTRACE_SETREGS, server_pid, NULL, &regs) < 0)
+    {
+        output->write(ERROR, "Can't set registers: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    if(ptrace(PTRACE_CONT, server_pid, NULL, NULL) < 0)
+    {
+        output->write(ERROR, "Can't continue fork server: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    /* The server stops with a fork event once the clone exists. */
+    if(waitpid(server_pid, &status, __WALL) < 0)
+    {
+        output->write(ERROR, "waitpid: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    if(WIFSTOPPED(status) == 0 ||
+       ((status >> 8) != (SIGTRAP | (PTRACE_EVENT_FORK << 8)) &&
+        (status >> 8) != (SIGTRAP | (PTRACE_EVENT_CLONE << 8))))
+    {
+        output->write(ERROR, "Fork server did not clone\n");
+        return (-1);
+    }
+
+    if(ptrace(PTRACE_GETEVENTMSG, server_pid, NULL, &msg) < 0)
+    {
+        output->write(ERROR, "Can't get clone pid: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    (*pid) = (pid_t)msg;
+
+    /* The clone starts out stopped and traced, wait for that stop. */
+    if(waitpid((*pid), &status, __WALL) < 0)
+    {
+        output->write(ERROR, "waitpid: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    /* The clone has a copy of the fork stub, put main back and
+      give it the registers the server had on entry to main. */
+    if(ptrace(PTRACE_POKETEXT, (*pid), (void *)server_main, (void *)orig_word) < 0 ||
+       ptrace(PTRACE_SETREGS, (*pid), NULL, &server_regs) < 0)
+    {
+        output->write(ERROR, "Can't restore clone: %s\n", strerror(errno));
+        (void)kill((*pid), SIGKILL);
+        return (-1);
+    }
+
+    /* With block probes in the clone we have to stay attached to catch their traps. The
+       clone's threads and children share or copy it's probes, so we trace them too,
+       and exec shouldn't look like a trap. */
+    if(total_probes > 0)
+    {
+        if(ptrace(PTRACE_SETOPTIONS, (*pid), NULL,
+                  (void *)(PTRACE_O_TRACEEXEC | PTRACE_O_TRACECLONE | PTRACE_O_TRACEFORK |
+                           PTRACE_O_TRACEVFORK | PTRACE_O_EXITKILL)) < 0 ||
+           ptrace(PTRACE_CONT, (*pid), NULL, NULL) < 0)
+        {
+            output->write(ERROR, "Can't continue clone: %s\n", strerror(errno));
+            (void)kill((*pid), SIGKILL);
+            return (-1);
+        }
+    }
+    /* Let the clone run main() with the current test case. */
+    else if(ptrace(PTRACE_DETACH, (*pid), NULL, NULL) < 0)
+    {
+        output->write(ERROR, "Can't detach clone: %s\n", strerror(errno));
+        (void)kill((*pid), SIGKILL);
+        return (-1);
+    }
+
+    /* Let the server finish the syscall and park on the int3 after it. */
+    if(ptrace(PTRACE_CONT, server_pid, NULL, NULL) < 0)
+    {
+        output->write(ERROR, "Can't continue fork server: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    return (wait_for_trap(server_pid, output));
+}
+
+int32_t inject_block_probes(const uint64_t *blocks,
+                            uint64_t total,
+                            uint8_t *trace,
+                            struct output_writter *output)
+{
+    uint64_t i;
+    char path[64];
+    int32_t fd auto_close = 0;
+
+    if(server_pid == 0)
+    {
+        output->write(ERROR, "The fork server is not running\n");
+        return (-1);
+    }
+
+    probe_address = calloc(total, sizeof(uint64_t));
+    probe_orig = calloc(total, sizeof(uint8_t));
+    if(probe_address == NULL || probe_orig == NULL)
+    {
+        output->write(ERROR, "Can't allocate block probes: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    /* Writing through the server's memory file is one syscall per
+      breakpoint instead of a peek and a poke. */
+    (void)snprintf(path, sizeof(path), "/proc/%d/mem", server_pid);
+
+    fd = open(path, O_RDWR);
+    if(fd < 0)
+    {
+        output->write(ERROR, "open: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    const uint8_t trap = TRAP_INST;
+
+    for(i = 0; i < total; i++)
+    {
+        uint8_t orig = 0;
+        uint64_t address = blocks[i] + server_bias;
+
+        /* Leave the word we swap the fork stub in and out of alone. */
+        if(address >= server_main && address < server_main + sizeof(uint64_t))
+            continue;
+
+        if(pread(fd, &orig, 1, (off_t)address) != 1)
+            continue;
+
+        if(pwrite(fd, &trap, 1, (off_t)address) != 1)
+            continue;
+
+        probe_address[total_probes] = address;
+        probe_orig[total_probes] = orig;
+        total_probes++;
+    }
+
+    probe_trace = trace;
+
+    output->write(STD, "Planted %llu block probes\n", total_probes);
+
+    return (0);
+}
+
+/* Put the byte a breakpoint replaced back in process pid. */
+static int32_t remove_probe(pid_t pid, uint64_t index, struct output_writter *output)
+{
+    errno = 0;
+    uint64_t word = (uint64_t)ptrace(PTRACE_PEEKTEXT, pid, (void *)probe_address[index], NULL);
+    if(errno != 0)
+    {
+        output->write(ERROR, "Can't read probe: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    word = (word & TRAP_MASK) | probe_orig[index];
+
+    if(ptrace(PTRACE_POKETEXT, pid, (void *)probe_address[index], (void *)word) < 0)
+    {
+        output->write(ERROR, "Can't remove probe: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    return (0);
+}
+
+static int64_t find_probe(uint64_t address)
+{
+    uint64_t low = 0;
+    uint64_t high = total_probes;
+
+    while(low < high)
+    {
+        uint64_t mid = low + ((high - low) / 2);
+
+        if(probe_address[mid] == address)
+            return ((int64_t)mid);
+
+        if(probe_address[mid] < address)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return (-1);
+}
+
+/* A thread or child the kernel attached us to starts with a SIGSTOP that has
+   no sender, unlike one sent with kill(). */
+static int32_t is_attach_stop(pid_t pid, int32_t sig)
+{
+    siginfo_t info;
+
+    if(sig != SIGSTOP)
+        return (FALSE);
+
+    if(ptrace(PTRACE_GETSIGINFO, pid, NULL, &info) < 0)
+        return (FALSE);
+
+    return ((info.si_code == SI_USER && info.si_pid == 0) ? TRUE : FALSE);
+}
+
+int32_t handle_probe_stop(pid_t pid, int32_t status, struct output_writter *output)
+{
+    int32_t sig = WSTOPSIG(status);
+
+    /* Event stops like exec, fork and clone aren't signals the clone should get. */
+    if((status >> 16) != 0 || is_attach_stop(pid, sig) == TRUE)
+        sig = 0;
+
+    if(sig == SIGTRAP && total_probes > 0)
+    {
+        struct user_regs_struct regs;
+
+        if(ptrace(PTRACE_GETREGS, pid, NULL, &regs) < 0)
+        {
+            output->write(ERROR, "Can't get registers: %s\n", strerror(errno));
+            return (-1);
+        }
+
+        int64_t index = find_probe(regs.rip - TRAP_LEN);
+        if(index >= 0)
+        {
+            /* The probes are one shot, take it out of the server too so no later
+               clone stops here. Only blocks nothing reached before ever trap. */
+            if(remove_probe(pid, (uint64_t)index, output) < 0 ||
+               remove_probe(server_pid, (uint64_t)index, output) < 0)
+                return (-1);
+
+            /* Back up and run the real instruction. */
+            regs.rip -= TRAP_LEN;
+            if(ptrace(PTRACE_SETREGS, pid, NULL, &regs) < 0)
+            {
+                output->write(ERROR, "Can't set registers: %s\n", strerror(errno));
+                return (-1);
+            }
+
+            probe_trace[(uint64_t)index % COVERAGE_MAP_SIZE]++;
+
+            sig = 0;
+        }
+    }
+
+    /* Anything else was meant for the clone, let it have it. */
+    if(ptrace(PTRACE_CONT, pid, NULL, (void *)(uintptr_t)sig) < 0)
+    {
+        output->write(ERROR, "Can't continue clone: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    return (0);
+}
+
+void cleanup_fork_server(void)
+{
+    if(server_pid == 0)
+        return;
+
+    (void)kill(server_pid, SIGKILL);
+    (void)waitpid(server_pid, NULL, __WALL);
+
+    server_pid = 0;
+
+    free(probe_address);
+    free(probe_orig);
+    probe_address = NULL;
+    probe_orig = NULL;
+    total_probes = 0;
+
+    return;
 }
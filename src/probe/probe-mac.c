@@ -18,16 +18,16 @@
 #include "utils/utils.h"
 
 #include <errno.h>
+#include <signal.h>
 #include <mach/mach.h>
 #include <mach/mach_types.h>
 
 static pid_t pid;
 
-static char *const args[] = {NULL, NULL};
-
-static int32_t start_target(char *path)
+static int32_t start_target(char *path, char *input_path)
 {
     int32_t rtrn = 0;
+    char * const args[] = {path, input_path, NULL};
 
     /* Get our PID. */
     pid = getpid();
@@ -75,14 +75,18 @@ static int32_t pause_target(pid_t target_pid)
     return (0);
 }
 
-int32_t start_and_pause_target(char *path, pid_t *target_pid)
+int32_t start_and_pause_target(char *path,
+                               char *input_path,
+                               pid_t *target_pid,
+                               struct output_writter *output)
 {
+    (void)output;
     int32_t rtrn = 0;
 
     pid = fork();
     if(pid == 0)
     {
-        rtrn = start_target(path);
+        rtrn = start_target(path, input_path);
         if(rtrn < 0)
         {
             printf("Can't start target process\n");
@@ -112,9 +116,10 @@ int32_t start_and_pause_target(char *path, pid_t *target_pid)
     }
 }
 
-int32_t inject_fork_server(uint64_t main_address)
+int32_t inject_fork_server(uint64_t main_address, struct output_writter *output)
 {
     (void)main_address;
+    (void)output;
     task_t target_task;
     kern_return_t kr = 0;
 
@@ -130,3 +135,42 @@ int32_t inject_fork_server(uint64_t main_address)
 
     return (0);
 }
+
+int32_t fork_server_clone(pid_t *clone_pid, struct output_writter *output)
+{
+    (void)clone_pid;
+    output->write(ERROR, "The fork server is not supported on this platform yet\n");
+    return (-1);
+}
+
+int32_t inject_block_probes(const uint64_t *blocks,
+                            uint64_t total,
+                            uint8_t *trace,
+                            struct output_writter *output)
+{
+    (void)blocks;
+    (void)total;
+    (void)trace;
+    output->write(ERROR, "Block probes are not supported on this platform yet\n");
+    return (-1);
+}
+
+int32_t handle_probe_stop(pid_t clone_pid, int32_t status, struct output_writter *output)
+{
+    (void)clone_pid;
+    (void)status;
+    output->write(ERROR, "Block probes are not supported on this platform yet\n");
+    return (-1);
+}
+
+void cleanup_fork_server(void)
+{
+    if(pid == 0)
+        return;
+
+    (void)kill(pid, SIGKILL);
+
+    pid = 0;
+
+    return;
+}
@@ -54,20 +54,62 @@ static struct probe_ctx *ctx;
 
 static const char *target_path;
 
-int32_t inject_kernel_probes(struct probe_ctx *probe)
+#ifndef LINUX
+
+/* There is no kcov outside of Linux, smart mode runs without kernel coverage. */
+
+void set_kcov_device(struct kcov_device *device)
 {
-    (void)probe;
+    (void)device;
+
+    return;
+}
+
+int32_t check_kernel_probes(struct output_writter *output)
+{
+    (void)output;
+
+    return (0);
+}
+
+int32_t inject_kernel_probes(struct probe_ctx **probe,
+                             struct memory_allocator *allocator,
+                             struct output_writter *output)
+{
+    (void)allocator;
+    (void)output;
+
+    (*probe) = NULL;
 
     return (0);
 }
 
-int32_t cleanup_kernel_probes(struct probe_ctx *probe)
+int32_t cleanup_kernel_probes(struct probe_ctx **probe, struct memory_allocator *allocator)
+{
+    (void)allocator;
+
+    (*probe) = NULL;
+
+    return (0);
+}
+
+void start_kernel_coverage(struct probe_ctx *probe)
 {
     (void)probe;
 
+    return;
+}
+
+uint32_t collect_kernel_coverage(struct probe_ctx *probe, uint8_t *trace)
+{
+    (void)probe;
+    (void)trace;
+
     return (0);
 }
 
+#endif
+
 #ifdef LINUX
 
 int32_t inject_probes(pid_t pid)
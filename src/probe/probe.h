@@ -18,6 +18,10 @@
 #ifndef PROBE_H
 #define PROBE_H
 
+#include "io/io.h"
+#include "memory/memory.h"
+#include "coverage/coverage.h"
+
 #include <stdint.h>
 #include <unistd.h>
 #include <sys/types.h>
@@ -31,13 +35,123 @@ struct probe_ctx;
 
 extern int32_t inject_probes(pid_t pid);
 
-extern int32_t inject_kernel_probes(struct probe_ctx *probe);
+/* Where the kernel exposes kcov, the environment variable overrides it. */
+#define KCOV_PATH "/sys/kernel/debug/kcov"
+#define KCOV_PATH_ENV "NEXTGEN_KCOV"
+
+/* Number of PCs the kernel can record for one syscall. */
+#define KCOV_COVER_SIZE (64 * 1024)
+
+/**
+ * The calls we make on the kcov device. The real device is used
+ * unless set_kcov_device() swaps in another one, tests use this
+ * to run without a kcov enabled kernel.
+ */
+struct kcov_device
+{
+    int32_t (*open)(const char *path);
+
+    int32_t (*ioctl)(int32_t fd, unsigned long request, unsigned long arg);
+
+    void *(*map)(int32_t fd, uint64_t size);
+
+    void (*unmap)(void *cover, uint64_t size);
+
+    void (*close)(int32_t fd);
+};
+
+/**
+ * Use device for kcov from now on, NULL goes back to the real device.
+ */
+extern void set_kcov_device(struct kcov_device *device);
+
+/**
+ * Check that kernel probes can be used, so smart mode can fail
+ * up front instead of in every child.
+ * @param output An output writter object.
+ * @return Zero if they can be used and negative one if they can't.
+ */
+extern int32_t check_kernel_probes(struct output_writter *output);
+
+/**
+ * Open kcov and start tracing the calling thread into a new coverage buffer.
+ * @param probe Where the new probe context is placed.
+ * @param allocator A memory allocator object.
+ * @param output An output writter object.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t inject_kernel_probes(struct probe_ctx **probe,
+                                    struct memory_allocator *allocator,
+                                    struct output_writter *output);
+
+/**
+ * Stop tracing and free the probe context, probe is set to NULL.
+ */
+extern int32_t cleanup_kernel_probes(struct probe_ctx **probe,
+                                     struct memory_allocator *allocator);
+
+/**
+ * Throw away the coverage collected so far, call this right before the syscall.
+ */
+extern void start_kernel_coverage(struct probe_ctx *probe);
+
+/**
+ * Hash the PCs collected since start_kernel_coverage() into edges
+ * and count their hits in trace.
+ * @param probe The calling thread's probe context.
+ * @param trace A trace map from coverage_create_map().
+ * @return The number of PCs collected.
+ */
+extern uint32_t collect_kernel_coverage(struct probe_ctx *probe, uint8_t *trace);
+
+/**
+ * Start the target executable with input_path as it's only argument
+ * and stop it before it executes any instructions.
+ */
+extern int32_t start_and_pause_target(char *path,
+                                      char *input_path,
+                                      pid_t *pid,
+                                      struct output_writter *output);
+
+/**
+ * Run the paused target up to main_address and park it there,
+ * so that fork_server_clone() can copy it for each test case.
+ */
+extern int32_t inject_fork_server(uint64_t main_address, struct output_writter *output);
 
-extern int32_t cleanup_kernel_probes(struct probe_ctx *probe);
+/**
+ * Clone the fork server and let the clone run main(). The clone is a child
+ * of the calling process and it's PID is placed in pid so it can be waited on.
+ */
+extern int32_t fork_server_clone(pid_t *pid, struct output_writter *output);
 
-extern int32_t start_and_pause_target(char *path, pid_t *pid);
+/**
+ * Plant a one shot breakpoint at each block in the fork server. A clone traps
+ * the first time any clone reaches a block, the block is counted in trace and the
+ * breakpoint is removed for good, so we only pay for blocks that are new.
+ * @param blocks Link time addresses of the blocks, sorted from lowest to highest.
+ * @param total Number of blocks.
+ * @param trace The trace map hits are counted in.
+ * @param output An output writter object.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t inject_block_probes(const uint64_t *blocks,
+                                   uint64_t total,
+                                   uint8_t *trace,
+                                   struct output_writter *output);
+
+/**
+ * Handle a clone stopping while block probes are in, a block probe trap is
+ * recorded and removed and any other signal is passed on to the clone.
+ * @param pid The clone's PID.
+ * @param status The status waitpid() returned for the stop.
+ * @param output An output writter object.
+ * @return Zero once the clone is running again and negative one on failure.
+ */
+extern int32_t handle_probe_stop(pid_t pid, int32_t status, struct output_writter *output);
 
-extern int32_t inject_fork_server(uint64_t main_address);
+/* Kill the fork server. */
+extern void cleanup_fork_server(void);
 
 extern int32_t setup_probe_module(char *exec_path);
 
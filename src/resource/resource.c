@@ -33,7 +33,12 @@
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
 
 /* If the setup variable is equal to zero
    the resource module is not setup. Set this
@@ -47,25 +52,86 @@ static struct mem_pool_shared *dirpath_pool;
 static struct mem_pool_shared *file_pool;
 static struct mem_pool_shared *socket_pool;
 
+/* Below this many free resources a pool counts as low and the replenisher
+   rests REPLENISH_INTERVAL_LOW instead. It never creates resources, the pools
+   only hold what was made at setup. */
+static const uint32_t RESOURCE_WATERMARK = 256;
+
+/* How long the replenisher rests between passes, and how long when a pool is low. */
+static const useconds_t REPLENISH_INTERVAL = 10000;
+static const useconds_t REPLENISH_INTERVAL_LOW = 1000;
+
+/* Checks resources children give back and recreates the dead ones, so
+   children never wait on creating a resource themselves. */
+static pthread_t replenisher;
+
+/* Set to TRUE to stop the replenisher. */
+static int32_t stop_replenisher;
+
+/* The process the replenisher runs in, children forked from it don't have the thread. */
+static pid_t replenisher_pid;
+
+/* Where the replenisher creates new files. */
+static char *resource_root;
+
+/* How many passes the replenisher makes between looking for resources held by dead children. */
+static const uint32_t RECLAIM_PASSES = 100;
+
+/* Number of resources the cache takes from or gives back to a pool at once. */
+#define RESOURCE_MAGAZINE 16
+
+#define RESOURCE_TYPES (RESOURCE_FILEPATH + 1)
+
+/* A thread's cache in front of one pool. Resources are taken from the pool
+   a magazine at a time and given back a magazine at a time, so the pool is
+   touched once per RESOURCE_MAGAZINE resources instead of once for each.
+   Given back resources aren't reused from the cache, they go to the
+   replenisher to be checked like before. */
+struct resource_magazine
+{
+    /* Resources taken from the pool that haven't been handed out yet. */
+    struct memory_block *loaded[RESOURCE_MAGAZINE];
+    uint32_t total_loaded;
+
+    /* Resources given back that are waiting to be retired together. */
+    struct memory_block *spent[RESOURCE_MAGAZINE];
+    uint32_t total_spent;
+};
+
+/* One magazine per resource type. The magazines have no lock, so only the
+   thread that claimed them with claim_resource_cache() uses them. Every other
+   thread takes and gives back resources one at a time straight from the pools. */
+static struct resource_magazine magazines[RESOURCE_TYPES];
+
+/* Points at magazines in the thread that claimed them and is NULL in every
+   other thread, so no thread reads another thread's claim. */
+static pthread_key_t magazine_key;
+
+/* TRUE while a thread owns the magazines. */
+static int32_t magazine_claimed;
+
+/* TRUE once magazine_key exists, only with the cached interface. */
+static int32_t magazine_ready;
+
 /* The resource get functions abstraction/interface.
 If a functions uses this signature and returns the
 right resource they can be used for this interface. */
-static int32_t (*get_desc_interface)(void);
-static int32_t (*get_socket_interface)(void);
-static char *(*get_mountpath_interface)(void);
-static char *(*get_dirpath_interface)(void);
-static char *(*get_filepath_interface)(void);
+static int32_t (*get_desc_interface)(struct resource_handle *);
+static int32_t (*get_socket_interface)(struct resource_handle *);
+static int32_t (*get_mountpath_interface)(struct resource_handle *);
+static int32_t (*get_dirpath_interface)(struct resource_handle *);
+static int32_t (*get_filepath_interface)(struct resource_handle *);
 
 /* The resource free functions abstraction/interface.
 If a functions uses this signature and returns the
 right resource they can be used for this interface. */
-static int32_t (*free_desc_interface)(int32_t *);
-static int32_t (*free_socket_interface)(int32_t *);
-static int32_t (*free_mountpath_interface)(char **);
-static int32_t (*free_dirpath_interface)(char **);
-static int32_t (*free_filepath_interface)(char **);
+static int32_t (*free_desc_interface)(struct resource_handle *);
+static int32_t (*free_socket_interface)(struct resource_handle *);
+static int32_t (*free_mountpath_interface)(struct resource_handle *);
+static int32_t (*free_dirpath_interface)(struct resource_handle *);
+static int32_t (*free_filepath_interface)(struct resource_handle *);
 
-static char *get_dirpath_nocached(void)
+static int32_t get_dirpath_nocached(struct resource_handle *handle)
 {
     int32_t rtrn = 0;
     char *path = NULL;
@@ -77,20 +143,24 @@ static char *get_dirpath_nocached(void)
     if(output == NULL)
     {
         printf("Failed to get console writter\n");
-        return (NULL);
+        return (-1);
     }
 
     rtrn = create_random_directory("/tmp", &path, output);
     if(rtrn < 0)
     {
         output->write(ERROR, "Can't create directory");
-        return (NULL);
+        return (-1);
     }
 
-    return (path);
+    handle->type = RESOURCE_DIRPATH;
+    handle->slot = RESOURCE_NO_SLOT;
+    handle->path = path;
+
+    return (0);
 }
 
-static char *get_filepath_nocached(void)
+static int32_t get_filepath_nocached(struct resource_handle *handle)
 {
     char *path = NULL;
     int32_t rtrn = 0;
@@ -105,43 +175,50 @@ static char *get_filepath_nocached(void)
     if(output == NULL)
     {
         printf("Failed to get console writter\n");
-        return (NULL);
+        return (-1);
     }
 
     allocator = get_default_allocator();
     if(allocator == NULL)
     {
         output->write(ERROR, "Failed to get default memory allocator\n");
-        return (NULL);
+        return (-1);
     }
 
     random = get_default_random_generator(allocator, output);
     if(random == NULL)
     {
         output->write(ERROR, "Failed to get random number generator\n");
-        return (NULL);
+        return (-1);
     }
 
     rtrn = create_random_file("/tmp", ".txt", &path, &size, random, allocator, output);
     if(rtrn < 0)
     {
         output->write(ERROR, "Can't create random file\n");
-        return (NULL);
+        return (-1);
     }
 
     (void)size;
 
-    return (path);
+    handle->type = RESOURCE_FILEPATH;
+    handle->slot = RESOURCE_NO_SLOT;
+    handle->path = path;
+
+    return (0);
 }
 
-static char *get_mountpath_nocached(void)
+static int32_t get_mountpath_nocached(struct resource_handle *handle)
 {
-    char *path = NULL;
+    /* Mount paths aren't implemented yet. */
+    handle->type = RESOURCE_MOUNTPATH;
+    handle->slot = RESOURCE_NO_SLOT;
+    handle->path = NULL;
 
-    return (path);
+    return (-1);
 }
 
-static int32_t get_socket_nocached(void)
+static int32_t get_socket_nocached(struct resource_handle *handle)
 {
     int32_t rtrn = 0;
     uint32_t num = 0;
@@ -196,10 +273,14 @@ static int32_t get_socket_nocached(void)
             return (-1);
     }
 
-    return (sock);
+    handle->type = RESOURCE_SOCKET;
+    handle->slot = RESOURCE_NO_SLOT;
+    handle->fd = sock;
+
+    return (0);
 }
 
-static int32_t get_desc_nocached(void)
+static int32_t get_desc_nocached(struct resource_handle *handle)
 {
     int32_t fd = 0;
     int32_t rtrn = 0;
@@ -248,12 +329,16 @@ static int32_t get_desc_nocached(void)
         return (-1);
     }
 
-    return (fd);
+    handle->type = RESOURCE_DESC;
+    handle->slot = RESOURCE_NO_SLOT;
+    handle->fd = fd;
+
+    return (0);
 }
 
-static int32_t free_filepath_nocached(char **path)
+static int32_t free_filepath_nocached(struct resource_handle *handle)
 {
-    if((*path) == NULL)
+    if(handle->path == NULL)
         return (-1);
 
     int32_t rtrn = 0;
@@ -277,7 +362,7 @@ static int32_t free_filepath_nocached(char **path)
     }
 
     /* Remove the file. */
-    rtrn = unlink((*path));
+    rtrn = unlink(handle->path);
     if(rtrn < 0)
     {
         output->write(ERROR, "Can't remove file: %s\n", strerror(errno));
@@ -285,25 +370,25 @@ static int32_t free_filepath_nocached(char **path)
     }
 
     /* Now free the memory used for the file path. */
-    allocator->free((void **)path);
+    allocator->free((void **)&handle->path);
 
     return (0);
 }
 
-static int32_t free_mountpath_nocached(char **path)
+static int32_t free_mountpath_nocached(struct resource_handle *handle)
 {
-    if((*path) == NULL)
+    if(handle->path == NULL)
         return (-1);
 
     /* Implement later. */
-    (void)(*path);
+    (void)handle->path;
 
     return (0);
 }
 
-static int32_t free_dirpath_nocached(char **path)
+static int32_t free_dirpath_nocached(struct resource_handle *handle)
 {
-    if((*path) == NULL)
+    if(handle->path == NULL)
         return (-1);
 
     int32_t rtrn = 0;
@@ -326,270 +411,421 @@ static int32_t free_dirpath_nocached(char **path)
         return (-1);
     }
 
-    rtrn = delete_directory((*path));
+    rtrn = delete_directory(handle->path);
     if(rtrn < 0)
     {
         output->write(ERROR, "Can't delete directory");
         return (-1);
     }
 
-    allocator->free((void **)path);
+    allocator->free((void **)&handle->path);
 
     return (0);
 }
 
-static int32_t free_socket_nocached(int32_t *socket_fd)
+static int32_t free_socket_nocached(struct resource_handle *handle)
 {
-    close((*socket_fd));
+    close(handle->fd);
 
     return (0);
 }
 
-static int32_t free_desc_nocached(int32_t *fd)
+static int32_t free_desc_nocached(struct resource_handle *handle)
 {
-    close((*fd));
+    close(handle->fd);
 
     return (0);
 }
 
-static int32_t free_filepath_cached(char **path)
+/* Return the magazine for type if the calling thread owns the cache, else NULL. */
+static struct resource_magazine *get_magazine(enum resource_type type)
 {
-    /* Declare a memory block pointer. */
-    struct memory_block *m_blk = NULL;
+    struct resource_magazine *owned = NULL;
 
-    /* Loop and find the resource */
-    NX_SLIST_FOREACH(m_blk, &file_pool->allocated_list)
-    {
-        /* Get resource pointer. */
-        struct resource_ctx *resource = (struct resource_ctx *)m_blk->ptr;
+    if(magazine_ready != TRUE)
+        return (NULL);
 
-        /* Get the filepath pointer. */
-        char *filepath = (char *)resource->ptr;
+    owned = pthread_getspecific(magazine_key);
+    if(owned == NULL)
+        return (NULL);
 
-        /* If the filepaths match, free the memory block.*/
-        if(memcmp((*path), filepath, strlen(filepath)) == 0)
-        {
-            mem_free_shared_block(m_blk, file_pool);
-            break;
-        }
+    return (&owned[type]);
+}
+
+/* Run in a forked child. Only the thread that called fork() is left, and the
+   resources in the magazines still belong to the parent. */
+static void drop_resource_cache(void)
+{
+    if(magazine_ready != TRUE)
+        return;
+
+    (void)pthread_setspecific(magazine_key, NULL);
+
+    memset(magazines, 0, sizeof(magazines));
+
+    atomic_store_int32(&magazine_claimed, FALSE);
+
+    return;
+}
+
+int32_t claim_resource_cache(void)
+{
+    if(magazine_ready != TRUE)
+        return (-1);
+
+    /* Only one thread at a time can own the magazines. */
+    if(atomic_cas_int32(&magazine_claimed, FALSE, TRUE) == false)
+        return (-1);
+
+    if(pthread_setspecific(magazine_key, magazines) != 0)
+    {
+        printf("Can't claim resource cache\n");
+        atomic_store_int32(&magazine_claimed, FALSE);
+        return (-1);
     }
 
     return (0);
 }
 
-static int32_t free_mountpath_cached(char **path)
+/* Retire every spent resource in magazine to pool with one trip to the pool. */
+static void drain_magazine(struct mem_pool_shared *pool, struct resource_magazine *magazine)
 {
-    /* Declare a memory block pointer. */
-    struct memory_block *m_blk = NULL;
+    uint32_t i;
 
-    /* Loop and find the resource */
-    NX_SLIST_FOREACH(m_blk, &mount_pool->allocated_list)
+    if(magazine->total_spent == 0)
+        return;
+
+    /* Clear the owner first so the replenisher doesn't reclaim them a second time. */
+    for(i = 0; i < magazine->total_spent; i++)
     {
-        /* Get resource pointer. */
-        struct resource_ctx *resource = (struct resource_ctx *)m_blk->ptr;
+        struct resource_ctx *resource = (struct resource_ctx *)magazine->spent[i]->ptr;
+
+        atomic_store_int32(&resource->owner, 0);
+    }
+
+    mem_retire_shared_blocks(magazine->spent, magazine->total_spent, pool);
 
-        /* Get the mountpath pointer. */
-        char *dirpath = (char *)resource->ptr;
+    magazine->total_spent = 0;
 
-        /* If the dirpaths match, free the memory block.*/
-        if(strcmp((*path), dirpath) == 0)
+    return;
+}
+
+/* Fill magazine from pool, waiting if the pool is empty. */
+static int32_t load_magazine(struct mem_pool_shared *pool, struct resource_magazine *magazine)
+{
+    uint32_t i;
+    int32_t pid = (int32_t)getpid();
+
+    magazine->total_loaded = mem_get_shared_blocks(pool, magazine->loaded, RESOURCE_MAGAZINE);
+    if(magazine->total_loaded == 0)
+    {
+        /* Give back what we are sitting on before we wait, or we
+           could end up waiting on our own resources. */
+        drain_magazine(pool, magazine);
+
+        magazine->loaded[0] = mem_get_shared_block(pool);
+        if(magazine->loaded[0] == NULL)
         {
-            mem_free_shared_block(m_blk, mount_pool);
-            break;
+            printf("Can't get shared block\n");
+            return (-1);
         }
+
+        magazine->total_loaded = 1;
+    }
+
+    /* Mark the resources as ours so they are found if we die holding them. */
+    for(i = 0; i < magazine->total_loaded; i++)
+    {
+        struct resource_ctx *resource = (struct resource_ctx *)magazine->loaded[i]->ptr;
+
+        atomic_store_int32(&resource->owner, pid);
     }
 
     return (0);
 }
 
-static int32_t free_dirpath_cached(char **path)
+/* A pooled descriptor. The number is only valid in processes forked after it
+   was opened, a child may close it or reuse the number so we keep enough to
+   recognise and reopen the file. The fd has to stay first, the desc and socket
+   code reads it with *(int32_t *)resource->ptr. */
+struct pooled_desc
 {
-    /* Declare a memory block pointer. */
-    struct memory_block *m_blk = NULL;
+    int32_t fd;
+    const char padding[4];
+    dev_t dev;
+    ino_t ino;
+    char path[PATH_MAX + 1];
+};
+
+/* Make sure desc is open in this process and still names the pooled file.
+   A child's close() or a descriptor it opened over the number is only seen
+   here, the replenisher's copy of the table isn't touched by either. */
+static int32_t check_own_desc(struct pooled_desc *desc)
+{
+    struct stat sb;
 
-    /* Loop and find the resource */
-    NX_SLIST_FOREACH(m_blk, &dirpath_pool->allocated_list)
-    {
-        /* Get resource pointer. */
-        struct resource_ctx *resource = (struct resource_ctx *)m_blk->ptr;
+    if(fstat(desc->fd, &sb) == 0 && sb.st_dev == desc->dev && sb.st_ino == desc->ino)
+        return (0);
 
-        /* Get the dirpath pointer. */
-        char *dirpath = (char *)resource->ptr;
+    int32_t fd = open(desc->path, O_RDWR);
+    if(fd < 0)
+        return (-1);
 
-        /* If the dirpaths match, free the memory block.*/
-        if(strcmp((*path), dirpath) == 0)
+    if(fd != desc->fd)
+    {
+        if(dup2(fd, desc->fd) < 0)
         {
-            mem_free_shared_block(m_blk, dirpath_pool);
-            break;
+            close(fd);
+            return (-1);
         }
+
+        close(fd);
     }
 
     return (0);
 }
 
-static int32_t free_socket_cached(int32_t *sock_fd)
+/* Same for a pooled socket, there is no file to reopen so connect a new one. */
+static int32_t check_own_socket(int32_t sock)
 {
-    /* Declare a memory block pointer. */
-    struct memory_block *m_blk = NULL;
+    struct stat sb;
+    int32_t error = 0;
+    int32_t new_sock = 0;
+    socklen_t length = sizeof(error);
 
-    /* Loop and find the resource */
-    NX_SLIST_FOREACH(m_blk, &socket_pool->allocated_list)
-    {
-        /* Get resource pointer. */
-        struct resource_ctx *resource = (struct resource_ctx *)m_blk->ptr;
+    if(fstat(sock, &sb) == 0 && S_ISSOCK(sb.st_mode) &&
+       getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0)
+        return (0);
 
-        /* Get the socket pointer. */
-        int32_t *sock = (int32_t *)resource->ptr;
+    if(connect_ipv6(&new_sock) < 0)
+        return (-1);
 
-        /* If the descriptors match, free the memory block.*/
-        if((*sock) == (*sock_fd))
+    if(new_sock != sock)
+    {
+        if(dup2(new_sock, sock) < 0)
         {
-            mem_free_shared_block(m_blk, socket_pool);
-            break;
+            close(new_sock);
+            return (-1);
         }
+
+        close(new_sock);
     }
 
     return (0);
 }
 
-static int32_t free_desc_cached(int32_t *fd)
+static int32_t check_own_resource(enum resource_type type, struct resource_ctx *resource)
 {
-    /* Declare a memory block pointer. */
-    struct memory_block *m_blk = NULL;
-
-    /* Loop and find the resource */
-    NX_SLIST_FOREACH(m_blk, &desc_pool->allocated_list)
+    switch(type)
     {
-        /* Get resource pointer. */
-        struct resource_ctx *resource = (struct resource_ctx *)m_blk->ptr;
+        case RESOURCE_DESC:
+            return (check_own_desc((struct pooled_desc *)resource->ptr));
 
-        /* Get the descriptor pointer. */
-        int32_t *desc = (int32_t *)resource->ptr;
+        case RESOURCE_SOCKET:
+            return (check_own_socket(*(int32_t *)resource->ptr));
 
-        /* If the descriptors match, free the memory block.*/
-        if((*fd) == (*desc))
-        {
-            mem_free_shared_block(m_blk, desc_pool);
+        /* Paths aren't per process, the replenisher already checked them. */
+        case RESOURCE_MOUNTPATH:
+        case RESOURCE_DIRPATH:
+        case RESOURCE_FILEPATH:
             break;
-        }
     }
 
     return (0);
 }
 
-static char *get_dirpath_cached(void)
+/* Take a resource from pool and point handle at it. The thread that owns the
+   cache takes it from it's magazine, every other thread goes to the pool. */
+static int32_t get_cached_resource(struct mem_pool_shared *pool,
+                                   enum resource_type type,
+                                   struct resource_handle *handle)
 {
-    char *path = NULL;
+    uint32_t i;
+    int32_t rtrn = 0;
     struct memory_block *m_blk = NULL;
+    struct resource_ctx *resource = NULL;
+    struct resource_magazine *magazine = NULL;
 
-    /* Grab a shared memory block from the dirpath pool. */
-    m_blk = mem_get_shared_block(dirpath_pool);
-    if(m_blk == NULL)
+    if(pool == NULL)
     {
-        printf("Can't get shared block\n");
-        return NULL;
+        printf("Resource pool is not setup\n");
+        return (-1);
     }
 
-    /* Get resource pointer. */
-    struct resource_ctx *resource = (struct resource_ctx *)m_blk->ptr;
+    magazine = get_magazine(type);
 
-    /* Set fd to the descriptor we grabbed from the pool. */
-    path = (char *)resource->ptr;
+    /* A resource we can't repair in this process is retired and we try the
+       next one, the replenisher puts it back once it's checked it. */
+    for(i = 0; i < RESOURCE_MAGAZINE; i++)
+    {
+        if(magazine == NULL)
+        {
+            m_blk = mem_get_shared_block(pool);
+            if(m_blk == NULL)
+            {
+                printf("Can't get shared block\n");
+                return (-1);
+            }
 
-    return (path);
-}
+            resource = (struct resource_ctx *)m_blk->ptr;
 
-static char *get_filepath_cached(void)
-{
-    char *path = NULL;
-    struct memory_block *m_blk = NULL;
+            /* Mark the resource as ours so it's found if we die holding it. */
+            atomic_store_int32(&resource->owner, (int32_t)getpid());
+        }
+        else
+        {
+            /* Only go to the shared pool when the magazine is empty. */
+            if(magazine->total_loaded == 0)
+            {
+                rtrn = load_magazine(pool, magazine);
+                if(rtrn < 0)
+                {
+                    printf("Can't load resource magazine\n");
+                    return (-1);
+                }
+            }
+
+            magazine->total_loaded--;
+            m_blk = magazine->loaded[magazine->total_loaded];
+
+            resource = (struct resource_ctx *)m_blk->ptr;
+        }
+
+        if(check_own_resource(type, resource) == 0)
+            break;
+
+        atomic_store_int32(&resource->owner, 0);
+
+        mem_retire_shared_block(m_blk, pool);
+
+        m_blk = NULL;
+    }
 
-    /* Grab a shared memory block from the file pool. */
-    m_blk = mem_get_shared_block(file_pool);
     if(m_blk == NULL)
     {
-        printf("Can't get shared block\n");
-        return (NULL);
+        printf("Can't get a usable resource\n");
+        return (-1);
     }
 
-    /* Get resource pointer. */
-    struct resource_ctx *resource = (struct resource_ctx *)m_blk->ptr;
+    handle->type = type;
+    handle->slot = m_blk->index;
 
-    /* Set fd to the descriptor we grabbed from the pool. */
-    path = (char *)resource->ptr;
+    switch(type)
+    {
+        case RESOURCE_DESC:
+        case RESOURCE_SOCKET:
+            handle->fd = *(int32_t *)resource->ptr;
+            break;
 
-    return (path);
+        case RESOURCE_MOUNTPATH:
+        case RESOURCE_DIRPATH:
+        case RESOURCE_FILEPATH:
+            handle->path = (char *)resource->ptr;
+            break;
+    }
 
+    return (0);
 }
 
-static char *get_mountpath_cached(void)
+/* Give the resource in handle back, the handle knows it's slot so there's
+   nothing to search for. With the cache the resource waits in the magazine
+   until a full magazine is retired to pool, either way it isn't handed out
+   again until the replenisher has checked it. */
+static int32_t free_cached_resource(struct mem_pool_shared *pool,
+                                    enum resource_type type,
+                                    struct resource_handle *handle)
 {
-    char *path = NULL;
     struct memory_block *m_blk = NULL;
+    struct resource_magazine *magazine = NULL;
 
-    /* Grab a shared memory block from the mountpath pool. */
-    m_blk = mem_get_shared_block(mount_pool);
-    if(m_blk == NULL)
+    if(pool == NULL)
+    {
+        printf("Resource pool is not setup\n");
+        return (-1);
+    }
+
+    if(handle->type != type || handle->slot >= pool->block_count)
     {
-        printf("Can't get shared block\n");
-        return NULL;
+        printf("Resource handle is not from this pool\n");
+        return (-1);
     }
 
-    /* Get resource pointer. */
-    struct resource_ctx *resource = (struct resource_ctx *)m_blk->ptr;
+    m_blk = &pool->blocks[handle->slot];
 
-    path = (char *)resource->ptr;
+    magazine = get_magazine(type);
+    if(magazine == NULL)
+    {
+        /* Clear the owner first so the replenisher doesn't reclaim it a second time. */
+        atomic_store_int32(&((struct resource_ctx *)m_blk->ptr)->owner, 0);
 
-    return (path);
+        mem_retire_shared_block(m_blk, pool);
+    }
+    else
+    {
+        magazine->spent[magazine->total_spent] = m_blk;
+        magazine->total_spent++;
+
+        if(magazine->total_spent == RESOURCE_MAGAZINE)
+            drain_magazine(pool, magazine);
+    }
+
+    /* Make a second free of the same handle an error instead of a double free. */
+    handle->slot = RESOURCE_NO_SLOT;
+
+    return (0);
 }
 
-static int32_t get_socket_cached(void)
+static int32_t free_filepath_cached(struct resource_handle *handle)
 {
-    int32_t *sock = NULL;
-    struct memory_block *m_blk = NULL;
+    return (free_cached_resource(file_pool, RESOURCE_FILEPATH, handle));
+}
 
-    /* Grab a shared memory block from the socket pool. */
-    m_blk = mem_get_shared_block(socket_pool);
-    if(m_blk == NULL)
-    {
-        printf("Can't get shared block\n");
-        return (-1);
-    }
+static int32_t free_mountpath_cached(struct resource_handle *handle)
+{
+    return (free_cached_resource(mount_pool, RESOURCE_MOUNTPATH, handle));
+}
 
-    /* Get resource pointer. */
-    struct resource_ctx *resource = (struct resource_ctx *)m_blk->ptr;
+static int32_t free_dirpath_cached(struct resource_handle *handle)
+{
+    return (free_cached_resource(dirpath_pool, RESOURCE_DIRPATH, handle));
+}
 
-    /* Set fd to the descriptor we grabbed from the pool. */
-    sock = (int32_t *)resource->ptr;
+static int32_t free_socket_cached(struct resource_handle *handle)
+{
+    return (free_cached_resource(socket_pool, RESOURCE_SOCKET, handle));
+}
 
-    return ((*sock));
+static int32_t free_desc_cached(struct resource_handle *handle)
+{
+    return (free_cached_resource(desc_pool, RESOURCE_DESC, handle));
 }
 
-static int32_t get_desc_cached(void)
+static int32_t get_dirpath_cached(struct resource_handle *handle)
 {
-    int32_t *fd = NULL;
-    struct memory_block *m_blk = NULL;
+    return (get_cached_resource(dirpath_pool, RESOURCE_DIRPATH, handle));
+}
 
-    /* Grab a shared memory block from the decriptor pool. */
-    m_blk = mem_get_shared_block(desc_pool);
-    if(m_blk == NULL)
-    {
-        printf("Can't get shared block\n");
-        return (-1);
-    }
+static int32_t get_filepath_cached(struct resource_handle *handle)
+{
+    return (get_cached_resource(file_pool, RESOURCE_FILEPATH, handle));
+}
 
-    /* Get resource pointer. */
-    struct resource_ctx *resource = (struct resource_ctx *)m_blk->ptr;
+static int32_t get_mountpath_cached(struct resource_handle *handle)
+{
+    return (get_cached_resource(mount_pool, RESOURCE_MOUNTPATH, handle));
+}
 
-    /* Set fd to the descriptor we grabbed from the pool. */
-    fd = (int32_t *)resource->ptr;
+static int32_t get_socket_cached(struct resource_handle *handle)
+{
+    return (get_cached_resource(socket_pool, RESOURCE_SOCKET, handle));
+}
 
-    return (*fd);
+static int32_t get_desc_cached(struct resource_handle *handle)
+{
+    return (get_cached_resource(desc_pool, RESOURCE_DESC, handle));
 }
 
-/* The resource free_* functions are inefficient and should be replaced
- with a more efficent implementation. */
-int32_t get_desc(void)
+int32_t get_desc(struct resource_handle *handle)
 {
     if(setup == 0)
     {
@@ -597,10 +833,10 @@ int32_t get_desc(void)
         return (-1);
     }
 
-    return (get_desc_interface());
+    return (get_desc_interface(handle));
 }
 
-int32_t free_desc(int32_t *fd)
+int32_t free_desc(struct resource_handle *handle)
 {
     if(setup == 0)
     {
@@ -608,10 +844,10 @@ int32_t free_desc(int32_t *fd)
         return (-1);
     }
 
-    return (free_desc_interface(fd));
+    return (free_desc_interface(handle));
 }
 
-int32_t get_socket(void)
+int32_t get_socket(struct resource_handle *handle)
 {
     if(setup == 0)
     {
@@ -619,10 +855,10 @@ int32_t get_socket(void)
         return (-1);
     }
 
-    return (get_socket_interface());
+    return (get_socket_interface(handle));
 }
 
-int32_t free_socket(int32_t *sock_fd)
+int32_t free_socket(struct resource_handle *handle)
 {
     if(setup == 0)
     {
@@ -630,21 +866,21 @@ int32_t free_socket(int32_t *sock_fd)
         return (-1);
     }
 
-    return (free_socket_interface(sock_fd));
+    return (free_socket_interface(handle));
 }
 
-char *get_mountpath(void)
+int32_t get_mountpath(struct resource_handle *handle)
 {
     if(setup == 0)
     {
         printf("Setup resource module first\n");
-        return (NULL);
+        return (-1);
     }
 
-    return (get_mountpath_interface());
+    return (get_mountpath_interface(handle));
 }
 
-int32_t free_mountpath(char **path)
+int32_t free_mountpath(struct resource_handle *handle)
 {
     if(setup == 0)
     {
@@ -652,21 +888,21 @@ int32_t free_mountpath(char **path)
         return (-1);
     }
 
-    return (free_mountpath_interface(path));
+    return (free_mountpath_interface(handle));
 }
 
-char *get_dirpath(void)
+int32_t get_dirpath(struct resource_handle *handle)
 {
     if(setup == 0)
     {
         printf("Setup resource module first\n");
-        return (NULL);
+        return (-1);
     }
 
-    return (get_dirpath_interface());
+    return (get_dirpath_interface(handle));
 }
 
-int32_t free_dirpath(char **path)
+int32_t free_dirpath(struct resource_handle *handle)
 {
     if(setup == 0)
     {
@@ -674,21 +910,21 @@ int32_t free_dirpath(char **path)
         return (-1);
     }
 
-    return (free_dirpath_interface(path));
+    return (free_dirpath_interface(handle));
 }
 
-char *get_filepath(void)
+int32_t get_filepath(struct resource_handle *handle)
 {
     if(setup == 0)
     {
         printf("Setup resource module first\n");
-        return (NULL);
+        return (-1);
     }
 
-    return (get_filepath_interface());
+    return (get_filepath_interface(handle));
 }
 
-int32_t free_filepath(char **path)
+int32_t free_filepath(struct resource_handle *handle)
 {
     if(setup == 0)
     {
@@ -696,33 +932,26 @@ int32_t free_filepath(char **path)
         return (-1);
     }
 
-    return (free_filepath_interface(path));
+    return (free_filepath_interface(handle));
 }
 
-static int32_t init_resource_ctx(struct resource_ctx **resource, uint32_t size)
-{
-    struct memory_allocator *allocator = NULL;
-    allocator = get_default_allocator();
-    if(allocator == NULL)
-    {
-        printf("Failed to get default memory allocator\n");
-        return (-1);
-    }
+/* Size of a pool block holding a resource context and size bytes of resource. */
+#define resource_block_size(size) ((uint32_t)(sizeof(struct resource_ctx) + (size)))
 
-    /* Allocate a resource context struct as shared memory. */
-    (*resource) = allocator->shared(sizeof(struct resource_ctx));
-    if((*resource) == NULL)
+/* Set up the resource context at the start of m_blk's payload, the resource
+   itself follows the context in the same block so nothing else is mapped. */
+static int32_t init_resource_ctx(struct resource_ctx **resource, struct memory_block *m_blk)
+{
+    if(m_blk->ptr == NULL)
     {
-        printf("Can't allocate resource context\n");
+        printf("Memory block has no payload\n");
         return (-1);
     }
 
-    (*resource)->ptr = allocator->shared(size);
-    if((*resource)->ptr == NULL)
-    {
-        printf("Can't alloc resource pointer\n");
-        return (-1);
-    }
+    (*resource) = (struct resource_ctx *)m_blk->ptr;
+    (*resource)->m_blk = m_blk;
+    (*resource)->ptr = (char *)m_blk->ptr + sizeof(struct resource_ctx);
+    (*resource)->owner = 0;
 
     return (0);
 }
@@ -759,7 +988,7 @@ static struct mem_pool_shared *create_fd_pool(char *path)
         return (NULL);
     }
 
-    pool = mem_create_shared_pool(sizeof(int32_t *), POOL_SIZE);
+    pool = mem_create_shared_pool(resource_block_size(sizeof(struct pooled_desc)), POOL_SIZE);
     if(pool == NULL)
     {
         printf("Can't allocate descriptor memory pool\n");
@@ -767,7 +996,7 @@ static struct mem_pool_shared *create_fd_pool(char *path)
     }
 
     /* Create a bunch of file descriptors and stick them into the resource pool. */
-    init_shared_pool(&pool, m_blk)
+    init_shared_pool(pool, m_blk)
     {
         uint64_t size = 0;
 
@@ -778,7 +1007,7 @@ static struct mem_pool_shared *create_fd_pool(char *path)
         char *file_path auto_free = NULL;
 
         /* Create a resource context. */
-        rtrn = init_resource_ctx(&resource, sizeof(int32_t));
+        rtrn = init_resource_ctx(&resource, m_blk);
         if(rtrn < 0)
         {
             printf("Can't initialize resource context\n");
@@ -802,12 +1031,21 @@ static struct mem_pool_shared *create_fd_pool(char *path)
             return (NULL);
         }
 
-        /* Move fd to shared memory. */
-        memmove(resource->ptr, &fd, sizeof(int32_t));
+        struct stat sb;
+        struct pooled_desc *desc = (struct pooled_desc *)resource->ptr;
+
+        if(fstat(fd, &sb) < 0)
+        {
+            printf("fstat: %s\n", strerror(errno));
+            return (NULL);
+        }
 
-        resource->m_blk = m_blk;
+        /* Move fd and what identifies it's file to shared memory. */
+        desc->fd = fd;
+        desc->dev = sb.st_dev;
+        desc->ino = sb.st_ino;
+        (void)strncpy(desc->path, file_path, PATH_MAX);
 
-        m_blk->ptr = resource;
     }
 
     return (pool);
@@ -846,7 +1084,7 @@ static struct mem_pool_shared *create_file_pool(char *path)
     }
 
     /* Create shared memory pool. */
-    pool = mem_create_shared_pool(sizeof(char *), POOL_SIZE);
+    pool = mem_create_shared_pool(resource_block_size(PATH_MAX + 1), POOL_SIZE);
     if(pool == NULL)
     {
         printf("Can't allocate file path memory pool\n");
@@ -854,7 +1092,7 @@ static struct mem_pool_shared *create_file_pool(char *path)
     }
 
     /* Initialize shared pool with file paths. */
-    init_shared_pool(&pool, m_blk)
+    init_shared_pool(pool, m_blk)
     {
         uint64_t file_size = 0;
 
@@ -863,7 +1101,7 @@ static struct mem_pool_shared *create_file_pool(char *path)
         struct resource_ctx *resource = NULL;
 
         /* Initialize resource context. */
-        rtrn = init_resource_ctx(&resource, PATH_MAX + 1);
+        rtrn = init_resource_ctx(&resource, m_blk);
         if(rtrn < 0)
         {
             printf("Initialize resource context\n");
@@ -881,11 +1119,6 @@ static struct mem_pool_shared *create_file_pool(char *path)
         /* Move file path to shared memory. */
         memmove(resource->ptr, file_path, strlen(file_path));
 
-        /* Set memory block pointer. */
-        resource->m_blk = m_blk;
-
-        /* Set resource pointer. */
-        m_blk->ptr = resource;
     }
 
     return (pool);
@@ -943,7 +1176,6 @@ static struct mem_pool_shared *create_file_pool(char *path)
 static struct mem_pool_shared *create_dirpath_pool(char *path)
 {
     struct mem_pool_shared *pool = NULL;
-    struct memory_allocator *allocator = NULL;
     struct output_writter *output = NULL;
 
     output = get_console_writter();
@@ -953,24 +1185,17 @@ static struct mem_pool_shared *create_dirpath_pool(char *path)
         return (NULL);
     }
 
-    pool = mem_create_shared_pool(sizeof(char *), POOL_SIZE);
+    pool = mem_create_shared_pool(resource_block_size(PATH_MAX + 1), POOL_SIZE);
     if(pool == NULL)
     {
         printf("Can't allocate dir path memory pool\n");
         return (NULL);
     }
 
-    allocator = get_default_allocator();
-    if(allocator == NULL)
-    {
-        printf("Failed to get default memory allocator\n");
-        return (NULL);
-    }
-
     int32_t rtrn = 0;
     struct memory_block *m_blk = NULL;
 
-    NX_SLIST_FOREACH(m_blk, &pool->free_list)
+    init_shared_pool(pool, m_blk)
     {
         /* Temp variable that we define with auto_clean so that we
         don't have to worry about calling free. */
@@ -980,17 +1205,10 @@ static struct mem_pool_shared *create_dirpath_pool(char *path)
         char *dir_path = NULL;
         struct resource_ctx *resource = NULL;
 
-        resource = allocator->shared(sizeof(struct resource_ctx));
-        if(resource == NULL)
-        {
-            printf("Can't alloc resource object\n");
-            return (NULL);
-        }
-
-        resource->ptr = allocator->shared(PATH_MAX + 1);
-        if(resource->ptr == NULL)
+        rtrn = init_resource_ctx(&resource, m_blk);
+        if(rtrn < 0)
         {
-            printf("Can't alloc resource pointer\n");
+            printf("Can't initialize resource context\n");
             return (NULL);
         }
 
@@ -1012,9 +1230,6 @@ static struct mem_pool_shared *create_dirpath_pool(char *path)
 
         memmove(resource->ptr, dir_path, strlen(dir_path));
 
-        resource->m_blk = m_blk;
-
-        m_blk->ptr = resource;
     }
 
     return (pool);
@@ -1025,17 +1240,9 @@ static int32_t clean_allocated_file_list(struct mem_pool_shared *pool)
     int32_t rtrn = 0;
 
     struct memory_block *m_blk = NULL;
-    struct memory_allocator *allocator = NULL;
-
-    allocator = get_default_allocator();
-    if(allocator == NULL)
-    {
-        printf("Failed to get default memory allocator\n");
-        return (-1);
-    }
 
     /* Loop and grab all the file paths in the allocated list. */
-    NX_SLIST_FOREACH(m_blk, &pool->allocated_list)
+    mem_foreach_allocated_block(pool, m_blk)
     {
         struct resource_ctx *resource = (struct resource_ctx *)m_blk->ptr;
 
@@ -1045,10 +1252,6 @@ static int32_t clean_allocated_file_list(struct mem_pool_shared *pool)
             printf("Can't remove temp file\n");
             return (-1);
         }
-
-        allocator->free_shared((void **)&resource->ptr, PATH_MAX + 1);
-        allocator->free_shared((void **)&m_blk->ptr, sizeof(struct resource_ctx));
-        allocator->free_shared((void **)&m_blk, sizeof(struct memory_block));
     }
 
     return (0);
@@ -1064,7 +1267,7 @@ static int32_t clean_allocated_file_list(struct mem_pool_shared *pool)
     printf("free_list: %p\n", (void *)&pool->free_list);
     printf("allocated_list: %p\n", (void *)&pool->allocated_list);
 
-    NX_SLIST_FOREACH(m_blk, &pool->free_list)
+    init_shared_pool(pool, m_blk)
     {
         struct resource_ctx *resource = (struct resource_ctx *)m_blk->ptr;
 
@@ -1093,17 +1296,11 @@ static int32_t clean_file_pool(struct mem_pool_shared *pool)
         return (-1);
     }
 
-    /* Lock the spinlock. */
-    nx_spinlock_lock(&pool->lock);
-
-    if(CK_SLIST_EMPTY(&pool->allocated_list) != TRUE)
+    rtrn = clean_allocated_file_list(pool);
+    if(rtrn < 0)
     {
-        rtrn = clean_allocated_file_list(pool);
-        if(rtrn < 0)
-        {
-            printf("Can't clean allocated file list\n");
-            return (-1);
-        }
+        printf("Can't clean allocated file list\n");
+        return (-1);
     }
 
     /*if(CK_SLIST_EMPTY(&pool->free_list) != TRUE)
@@ -1116,8 +1313,6 @@ static int32_t clean_file_pool(struct mem_pool_shared *pool)
         }
     } */
 
-    nx_spinlock_unlock(&pool->lock);
-
     mem_clean_shared_pool(pool);
 
     return (0);
@@ -1127,7 +1322,7 @@ static struct mem_pool_shared *create_socket_pool(void)
 {
     struct mem_pool_shared *pool = NULL;
 
-    pool = mem_create_shared_pool(sizeof(int32_t), POOL_SIZE);
+    pool = mem_create_shared_pool(resource_block_size(sizeof(int32_t)), POOL_SIZE);
     if(pool == NULL)
     {
         printf("Can't allocate socket memory pool\n");
@@ -1146,14 +1341,14 @@ static struct mem_pool_shared *create_socket_pool(void)
     int32_t rtrn = 0;
     struct memory_block *m_blk = NULL;
 
-    NX_SLIST_FOREACH(m_blk, &pool->free_list)
+    init_shared_pool(pool, m_blk)
     {
         int32_t *sock = NULL;
 
         struct resource_ctx *resource = NULL;
 
         /* Initialize resource context. */
-        rtrn = init_resource_ctx(&resource, sizeof(int32_t));
+        rtrn = init_resource_ctx(&resource, m_blk);
         if(rtrn < 0)
         {
             printf("Initialize resource context\n");
@@ -1177,14 +1372,356 @@ static struct mem_pool_shared *create_socket_pool(void)
 
         memmove(resource->ptr, sock, sizeof(int32_t));
 
-        resource->m_blk = m_blk;
-
-        m_blk->ptr = resource;
     }
 
     return (pool);
 }
 
+/* Swap a new file in behind the pooled descriptor number, children forked
+   from now on find it at the same number and older ones reopen it by path. */
+static int32_t replace_desc(struct pooled_desc *desc,
+                            struct random_generator *random,
+                            struct memory_allocator *allocator,
+                            struct output_writter *output)
+{
+    uint64_t size = 0;
+    char *path auto_free = NULL;
+
+    if(create_random_file(resource_root, ".txt", &path, &size, random, allocator, output) < 0)
+    {
+        output->write(ERROR, "Can't create random file\n");
+        return (-1);
+    }
+
+    int32_t new_fd = open(path, O_RDWR);
+    if(new_fd < 0)
+    {
+        output->write(ERROR, "open: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    struct stat sb;
+
+    if(fstat(new_fd, &sb) < 0 || dup2(new_fd, desc->fd) < 0)
+    {
+        output->write(ERROR, "Can't replace descriptor: %s\n", strerror(errno));
+        close(new_fd);
+        return (-1);
+    }
+
+    close(new_fd);
+
+    desc->dev = sb.st_dev;
+    desc->ino = sb.st_ino;
+    (void)strncpy(desc->path, path, PATH_MAX);
+
+    return (0);
+}
+
+/* A child's close() only closes it's own copy of a descriptor, but an unlink
+   or truncate of the file behind it is seen by everyone. */
+static int32_t check_desc(struct resource_ctx *resource,
+                          struct random_generator *random,
+                          struct memory_allocator *allocator,
+                          struct output_writter *output)
+{
+    struct stat sb;
+    struct pooled_desc *desc = (struct pooled_desc *)resource->ptr;
+    int32_t fd = desc->fd;
+
+    if(fcntl(fd, F_GETFD) < 0 || fstat(fd, &sb) < 0 || S_ISREG(sb.st_mode) == 0 ||
+       sb.st_nlink == 0 || sb.st_size == 0)
+        return (replace_desc(desc, random, allocator, output));
+
+    /* The offset is shared with the children, start the next one at the top. */
+    (void)lseek(fd, 0, SEEK_SET);
+
+    return (0);
+}
+
+static int32_t check_socket(struct resource_ctx *resource,
+                            struct random_generator *random,
+                            struct memory_allocator *allocator,
+                            struct output_writter *output)
+{
+    int32_t error = 0;
+    int32_t new_sock = 0;
+    socklen_t length = sizeof(error);
+    int32_t sock = *(int32_t *)resource->ptr;
+
+    (void)random;
+    (void)allocator;
+
+    if(getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0)
+        return (0);
+
+    if(connect_ipv6(&new_sock) < 0)
+    {
+        output->write(ERROR, "Can't create socket\n");
+        return (-1);
+    }
+
+    if(dup2(new_sock, sock) < 0)
+    {
+        output->write(ERROR, "dup2: %s\n", strerror(errno));
+        close(new_sock);
+        return (-1);
+    }
+
+    close(new_sock);
+
+    return (0);
+}
+
+static int32_t check_filepath(struct resource_ctx *resource,
+                              struct random_generator *random,
+                              struct memory_allocator *allocator,
+                              struct output_writter *output)
+{
+    struct stat sb;
+    uint64_t size = 0;
+    char *path auto_free = NULL;
+
+    if(lstat((char *)resource->ptr, &sb) == 0 && S_ISREG(sb.st_mode) != 0 && sb.st_size > 0)
+        return (0);
+
+    /* The file is gone or was swapped for something else, point the slot at a new one. */
+    if(create_random_file(resource_root, ".txt", &path, &size, random, allocator, output) < 0)
+    {
+        output->write(ERROR, "Can't create random file\n");
+        return (-1);
+    }
+
+    memset(resource->ptr, 0, PATH_MAX + 1);
+    memcpy(resource->ptr, path, strlen(path));
+
+    return (0);
+}
+
+/* Directory paths are only names, there is nothing behind them to check. */
+static int32_t check_dirpath(struct resource_ctx *resource,
+                             struct random_generator *random,
+                             struct memory_allocator *allocator,
+                             struct output_writter *output)
+{
+    (void)resource;
+    (void)random;
+    (void)allocator;
+    (void)output;
+
+    return (0);
+}
+
+/* Check every resource given back to pool and make it available again.
+   Returns TRUE if the pool is below the watermark. */
+static int32_t replenish_pool(struct mem_pool_shared *pool,
+                              int32_t (*check)(struct resource_ctx *,
+                                               struct random_generator *,
+                                               struct memory_allocator *,
+                                               struct output_writter *),
+                              struct random_generator *random,
+                              struct memory_allocator *allocator,
+                              struct output_writter *output)
+{
+    struct memory_block *m_blk = NULL;
+
+    if(pool == NULL)
+        return (FALSE);
+
+    while((m_blk = mem_get_retired_block(pool)) != NULL)
+    {
+        /* A resource we couldn't recreate still goes back, the syscall
+           using it fails and that's a test case too. */
+        if(check((struct resource_ctx *)m_blk->ptr, random, allocator, output) < 0)
+            output->write(ERROR, "Can't recreate resource\n");
+
+        mem_free_shared_block(m_blk, pool);
+    }
+
+    if(atomic_load_uint32(&pool->free_count) < RESOURCE_WATERMARK)
+        return (TRUE);
+
+    return (FALSE);
+}
+
+/* Take back the resources of children that died holding them, a child killed
+   for hanging never gets to flush it's magazines. A PID that was reused by a
+   new process just means we find them later. */
+static void reclaim_pool(struct mem_pool_shared *pool)
+{
+    struct memory_block *m_blk = NULL;
+
+    if(pool == NULL)
+        return;
+
+    mem_foreach_allocated_block(pool, m_blk)
+    {
+        struct resource_ctx *resource = (struct resource_ctx *)m_blk->ptr;
+        int32_t owner = atomic_load_int32(&resource->owner);
+
+        /* Zero means the block was just taken and the owner isn't set yet. */
+        if(owner == 0)
+            continue;
+
+        if(kill((pid_t)owner, 0) == 0 || errno != ESRCH)
+            continue;
+
+        atomic_store_int32(&resource->owner, 0);
+
+        mem_retire_shared_block(m_blk, pool);
+    }
+
+    return;
+}
+
+static void *replenish_resources(void *arg)
+{
+    uint32_t pass = 0;
+    int32_t low = FALSE;
+    struct output_writter *output = NULL;
+    struct memory_allocator *allocator = NULL;
+    struct random_generator *random = NULL;
+
+    (void)arg;
+
+    output = get_console_writter();
+    allocator = get_default_allocator();
+    if(output == NULL || allocator == NULL)
+        return (NULL);
+
+    random = get_default_random_generator(allocator, output);
+    if(random == NULL)
+    {
+        output->write(ERROR, "Failed to get random number generator\n");
+        return (NULL);
+    }
+
+    while(atomic_load_int32(&stop_replenisher) != TRUE)
+    {
+        low = FALSE;
+
+        /* Walking every block is slow so only look for dead children now and then. */
+        pass++;
+        if(pass % RECLAIM_PASSES == 0)
+        {
+            reclaim_pool(desc_pool);
+            reclaim_pool(socket_pool);
+            reclaim_pool(file_pool);
+            reclaim_pool(dirpath_pool);
+        }
+
+        low |= replenish_pool(desc_pool, &check_desc, random, allocator, output);
+        low |= replenish_pool(socket_pool, &check_socket, random, allocator, output);
+        low |= replenish_pool(file_pool, &check_filepath, random, allocator, output);
+        low |= replenish_pool(dirpath_pool, &check_dirpath, random, allocator, output);
+
+        /* Children waiting on an empty pool are woken by the frees above,
+           but a low pool means they are coming back fast so don't rest long. */
+        (void)usleep((low == TRUE) ? REPLENISH_INTERVAL_LOW : REPLENISH_INTERVAL);
+    }
+
+    return (NULL);
+}
+
+static int32_t start_replenisher(char *path)
+{
+    resource_root = strdup(path);
+    if(resource_root == NULL)
+    {
+        printf("Can't copy resource path: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    atomic_store_int32(&stop_replenisher, FALSE);
+
+    if(pthread_create(&replenisher, NULL, &replenish_resources, NULL) != 0)
+    {
+        printf("Can't start resource replenisher\n");
+        free(resource_root);
+        resource_root = NULL;
+        return (-1);
+    }
+
+    replenisher_pid = getpid();
+
+    return (0);
+}
+
+static struct mem_pool_shared *get_resource_pool(enum resource_type type)
+{
+    switch(type)
+    {
+        case RESOURCE_DESC:
+            return (desc_pool);
+
+        case RESOURCE_SOCKET:
+            return (socket_pool);
+
+        case RESOURCE_MOUNTPATH:
+            return (mount_pool);
+
+        case RESOURCE_DIRPATH:
+            return (dirpath_pool);
+
+        case RESOURCE_FILEPATH:
+            return (file_pool);
+    }
+
+    return (NULL);
+}
+
+void flush_resource_cache(void)
+{
+    uint32_t i;
+    struct resource_magazine *magazine = magazines;
+
+    /* Another thread's magazines aren't ours to touch, if that thread
+       dies holding them the replenisher takes them back. */
+    if(get_magazine(RESOURCE_DESC) == NULL)
+        return;
+
+    /* From here on this thread goes straight to the pools too. */
+    (void)pthread_setspecific(magazine_key, NULL);
+
+    for(i = 0; i < RESOURCE_TYPES; i++)
+    {
+        struct mem_pool_shared *pool = get_resource_pool((enum resource_type)i);
+        if(pool == NULL)
+            continue;
+
+        drain_magazine(pool, &magazine[i]);
+
+        /* Resources we never handed out go back through the replenisher too. */
+        memcpy(magazine[i].spent, magazine[i].loaded,
+               magazine[i].total_loaded * sizeof(struct memory_block *));
+        magazine[i].total_spent = magazine[i].total_loaded;
+        magazine[i].total_loaded = 0;
+
+        drain_magazine(pool, &magazine[i]);
+    }
+
+    /* Another thread can claim the magazines now that they are empty. */
+    atomic_store_int32(&magazine_claimed, FALSE);
+
+    return;
+}
+
+static void stop_replenishing(void)
+{
+    /* Only the process that started the replenisher has it. */
+    if(resource_root == NULL || replenisher_pid != getpid())
+        return;
+
+    atomic_store_int32(&stop_replenisher, TRUE);
+
+    (void)pthread_join(replenisher, NULL);
+
+    free(resource_root);
+    resource_root = NULL;
+
+    return;
+}
+
 static int32_t cleanup_resource_pools(void)
 {
     int32_t rtrn = 0;
@@ -1203,6 +1740,9 @@ int32_t cleanup_resource_module(void)
 {
     int32_t rtrn = 0;
 
+    /* Stop the replenisher before the pools go away under it. */
+    stop_replenishing();
+
     rtrn = cleanup_resource_pools();
     if(rtrn < 0)
     {
@@ -1341,6 +1881,32 @@ int32_t setup_resource_module(enum rsrc_gen_type type, char *path)
                 return (-1);
             }
 
+            /* Keep the pools stocked with live resources from here on. */
+            rtrn = start_replenisher(path);
+            if(rtrn < 0)
+            {
+                printf("Can't start resource replenisher\n");
+                return (-1);
+            }
+
+            rtrn = pthread_key_create(&magazine_key, NULL);
+            if(rtrn != 0)
+            {
+                printf("Can't create resource cache key: %s\n", strerror(rtrn));
+                return (-1);
+            }
+
+            magazine_ready = TRUE;
+
+            /* A child forked by the thread that owns the cache must not
+               hand out the resources in it's copy of the magazines. */
+            rtrn = pthread_atfork(NULL, NULL, &drop_resource_cache);
+            if(rtrn != 0)
+            {
+                printf("Can't register fork handler: %s\n", strerror(rtrn));
+                return (-1);
+            }
+
             setup_cached_interface();
 
             break;
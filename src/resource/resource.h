@@ -30,30 +30,68 @@ struct resource_ctx
     struct memory_block *m_blk;
 
     void *ptr;
+
+    /* PID of the process holding the resource, zero while it's in the pool. */
+    int32_t owner;
+};
+
+/* The kinds of resource the resource module hands out. */
+enum resource_type
+{
+    RESOURCE_DESC,
+    RESOURCE_SOCKET,
+    RESOURCE_MOUNTPATH,
+    RESOURCE_DIRPATH,
+    RESOURCE_FILEPATH
+};
+
+/* Slot of a resource that wasn't taken from a pool. */
+#define RESOURCE_NO_SLOT UINT32_MAX
+
+/**
+ * A resource handed out by the resource module. The handle remembers the pool
+ * slot the resource came from, so giving it back doesn't have to search the
+ * pool for it. Only the free function of the same type can release it.
+ */
+struct resource_handle
+{
+    enum resource_type type;
+
+    /* The resource's slot in it's pool, RESOURCE_NO_SLOT if it isn't pooled. */
+    uint32_t slot;
+
+    union
+    {
+        /* RESOURCE_DESC and RESOURCE_SOCKET. */
+        int32_t fd;
+
+        /* RESOURCE_MOUNTPATH, RESOURCE_DIRPATH and RESOURCE_FILEPATH. */
+        char *path;
+    };
 };
 
 struct desc_generator
 {
-    int32_t (*get_desc)(void);
-    int32_t (*free_desc)(int32_t *);
+    int32_t (*get_desc)(struct resource_handle *);
+    int32_t (*free_desc)(struct resource_handle *);
 };
 
 struct socket_generator
 {
-    int32_t (*get_socket)(void);
-    int32_t (*free_socket)(int32_t *);
+    int32_t (*get_socket)(struct resource_handle *);
+    int32_t (*free_socket)(struct resource_handle *);
 };
 
 struct dirpath_generator
 {
-    char *(*get_dirpath)(void);
-    int32_t (*free_dirpath)(char **);
+    int32_t (*get_dirpath)(struct resource_handle *);
+    int32_t (*free_dirpath)(struct resource_handle *);
 };
 
 struct filepath_generator
 {
-    char *(*get_filepath)(void);
-    int32_t (*free_filepath)(char **);
+    int32_t (*get_filepath)(struct resource_handle *);
+    int32_t (*free_filepath)(struct resource_handle *);
 };
 
 struct resource_generator
@@ -66,28 +104,49 @@ struct resource_generator
 
 extern struct desc_generator *get_default_desc_generator(struct memory_allocator *,
                                                          struct output_writter *);
-DEPRECATED extern int32_t get_socket(void);
 
-DEPRECATED extern int32_t free_socket(int32_t *sock_fd);
+/* The get_* functions fill in handle and return zero on success and negative one
+   on failure. The free_* functions take the handle the matching get_* filled in. */
+
+DEPRECATED extern int32_t get_socket(struct resource_handle *handle);
+
+DEPRECATED extern int32_t free_socket(struct resource_handle *handle);
 
-DEPRECATED extern int32_t get_desc(void);
+DEPRECATED extern int32_t get_desc(struct resource_handle *handle);
 
-DEPRECATED extern int32_t free_desc(int32_t *fd);
+DEPRECATED extern int32_t free_desc(struct resource_handle *handle);
 
-DEPRECATED extern char *get_mountpath(void);
+DEPRECATED extern int32_t get_mountpath(struct resource_handle *handle);
 
-DEPRECATED extern int32_t free_mountpath(char **path);
+DEPRECATED extern int32_t free_mountpath(struct resource_handle *handle);
 
-DEPRECATED extern char *get_dirpath(void);
+DEPRECATED extern int32_t get_dirpath(struct resource_handle *handle);
 
-DEPRECATED extern int32_t free_dirpath(char **path);
+DEPRECATED extern int32_t free_dirpath(struct resource_handle *handle);
 
-DEPRECATED extern char *get_filepath(void);
+DEPRECATED extern int32_t get_filepath(struct resource_handle *handle);
 
-DEPRECATED extern int32_t free_filepath(char **path);
+DEPRECATED extern int32_t free_filepath(struct resource_handle *handle);
 
 DEPRECATED extern int32_t setup_resource_module(enum rsrc_gen_type type, char *path);
 
 DEPRECATED extern int32_t cleanup_resource_module(void);
 
+/**
+ * Make the calling thread the owner of this process's resource cache. The owner
+ * takes and gives back pooled resources a magazine at a time, other threads still
+ * work but go to the pools one resource at a time. Call it from the one thread
+ * in a process that does most of the getting and freeing.
+ * @return Zero on success and negative one if resources aren't cached or another
+ * thread owns the cache, resources still work either way.
+ */
+extern int32_t claim_resource_cache(void);
+
+/**
+ * Give every resource in the resource cache back to the pools and give up the
+ * cache. Does nothing unless the calling thread owns the cache. The replenisher
+ * takes back the resources of children that die without calling it.
+ */
+extern void flush_resource_cache(void);
+
 #endif
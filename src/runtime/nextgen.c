@@ -30,6 +30,8 @@
 #include "memory/memory.h"
 #include "plugins/plugin.h"
 #include "resource/resource.h"
+#include "syscall/select.h"
+#include "syscall/syscall.h"
 
 #include <errno.h>
 #include <getopt.h>
@@ -48,9 +50,15 @@ struct fuzzer_config
     char *input_path;
     char *output_path;
     char *args;
+    char *enable;
+    char *disable;
+    char *groups;
+    char *weights;
     int32_t smart_mode;
     enum crypto_method method;
     enum fuzz_mode mode;
+    int32_t persistent_mode;
+    uint32_t jobs;
     const char padding[4];
 };
 
@@ -69,6 +77,12 @@ static struct option longopts[] = {{"in", required_argument, NULL, 'i'},
                                    {"syscall", 0, NULL, 's'},
                                    {"help", 0, NULL, 'h'},
                                    {"dumb", 0, NULL, 'd'},
+                                   {"persistent", 0, NULL, 'r'},
+                                   {"jobs", required_argument, NULL, 'j'},
+                                   {"weights", required_argument, NULL, 'w'},
+                                   {"enable", required_argument, NULL, 'E'},
+                                   {"disable", required_argument, NULL, 'D'},
+                                   {"group", required_argument, NULL, 'g'},
                                    {"verbose", 0, NULL, 'v'},
                                    {NULL, 0, NULL, 0}};
 
@@ -88,6 +102,17 @@ static void display_help_banner(void)
         STD,
         "To use dumb mode just pass --dumb with any of the above commands.\n");
 
+    output(STD, "Pass --jobs N to run N fuzzing processes instead of one per core.\n");
+
+    output(STD, "Pass --weights read=4,open=0.5 in syscall mode to change how often "
+                "syscalls are picked, a weight of zero turns a syscall off.\n");
+
+    output(STD, "Pass --group fs,net,ipc,mm,proc or --enable read,write to only fuzz "
+                "those syscalls, and --disable name,... to skip some.\n");
+
+    output(STD, "If the target is built with the nextgen harness pass --persistent "
+                "in file mode to keep the target running between test cases.\n");
+
     return;
 }
 
@@ -243,6 +268,23 @@ static int32_t set_fuzz_mode(struct fuzzer_config *config, enum fuzz_mode mode)
     return (0);
 }
 
+static int32_t set_jobs(struct fuzzer_config *config, char *jobs)
+{
+    char *end = NULL;
+
+    errno = 0;
+    unsigned long count = strtoul(jobs, &end, 10);
+    if(errno != 0 || end == jobs || (*end) != '\0' || count > UINT32_MAX)
+    {
+        output(ERROR, "Invalid job count: %s\n", jobs);
+        return (-1);
+    }
+
+    config->jobs = (uint32_t)count;
+
+    return (0);
+}
+
 static int32_t set_crypto_method(struct fuzzer_config *config, enum crypto_method method)
 {
     switch((int32_t)method)
@@ -409,6 +451,64 @@ struct fuzzer_config *parse_cmd_line(int32_t argc, char *argv[],
                 config->smart_mode = FALSE;
                 break;
 
+            /* Set the number of child processes, zero means one per core. */
+            case 'j':
+                rtrn = set_jobs(config, optarg);
+                if(rtrn < 0)
+                {
+                    output->write(ERROR, "Can't set job count\n");
+                    allocator->free((void **)&config);
+                    return (NULL);
+                }
+                break;
+
+            /* Starting weights for the syscall selector. */
+            case 'w':
+                rtrn = asprintf(&config->weights, "%s", optarg);
+                if(rtrn < 0)
+                {
+                    output->write(ERROR, "asprintf: %s\n", strerror(errno));
+                    allocator->free((void **)&config);
+                    return (NULL);
+                }
+                break;
+
+            /* Syscalls and groups of syscalls to limit the run to or leave out. */
+            case 'E':
+                rtrn = asprintf(&config->enable, "%s", optarg);
+                if(rtrn < 0)
+                {
+                    output->write(ERROR, "asprintf: %s\n", strerror(errno));
+                    allocator->free((void **)&config);
+                    return (NULL);
+                }
+                break;
+
+            case 'D':
+                rtrn = asprintf(&config->disable, "%s", optarg);
+                if(rtrn < 0)
+                {
+                    output->write(ERROR, "asprintf: %s\n", strerror(errno));
+                    allocator->free((void **)&config);
+                    return (NULL);
+                }
+                break;
+
+            case 'g':
+                rtrn = asprintf(&config->groups, "%s", optarg);
+                if(rtrn < 0)
+                {
+                    output->write(ERROR, "asprintf: %s\n", strerror(errno));
+                    allocator->free((void **)&config);
+                    return (NULL);
+                }
+                break;
+
+            /* The target loops over test cases using file/harness.h. */
+            case 'r':
+                config->persistent_mode = TRUE;
+                break;
+
             case 'v':
                 /* Have the IO module dump output to stdout. */
                 set_verbosity(TRUE);
@@ -473,5 +573,17 @@ struct fuzzer_config *parse_cmd_line(int32_t argc, char *argv[],
         }
     }
 
+    /* Hand the options to the modules they belong to, they are
+       used when the module is setup. */
+    set_persistent_mode(config->persistent_mode);
+    set_syscall_jobs(config->jobs);
+
+    struct syscall_selection selection = {.enable = config->enable,
+                                          .disable = config->disable,
+                                          .groups = config->groups,
+                                          .weights = config->weights};
+
+    set_syscall_selection(&selection);
+
     return (config);
 }
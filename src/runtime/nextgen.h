@@ -62,11 +62,6 @@ struct shared_map
     /* The port that the ipv4 socket server is on. The ipv6 port is ipv4 + 1. */
     uint32_t socket_server_port;
 
-    /* Counter for the number of fuzz test perform. */
-    uint32_t test_counter;
-
-    const char padding[4];
-
     /* The epoch object used for coordinating
       reclamation of shared memory objects.  */
     epoch_ctx epoch;
@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+/* The argument slots every syscall is called with, unused ones point at a zero. */
+#define DISPATCH_ARGS(X) X(0) X(1) X(2) X(3) X(4) X(5)
+
+/* Select the address to load argument n from without a branch. A pointer argument
+   is the address stored in the slot, so we load the slot itself. A value argument
+   is loaded from where the slot points. */
+#define DISPATCH_LOAD(n) \
+    uint64_t mask##n = (uint64_t)0 - ((ptr_args >> (n)) & 1); \
+    uint64_t arg##n = *(const uint64_t *)(uintptr_t) \
+        ((((uintptr_t)&array[(n)]) & mask##n) | (((uintptr_t)array[(n)]) & ~mask##n));
+
+#if defined(LINUX) && defined(__x86_64__)
+
+/* Issue the syscall instruction directly, instead of going through libc's variadic syscall(). */
+static inline int64_t raw_syscall(int64_t number, uint64_t arg0, uint64_t arg1, uint64_t arg2,
+                                  uint64_t arg3, uint64_t arg4, uint64_t arg5)
+{
+    int64_t ret = 0;
+    register uint64_t r10 __asm__("r10") = arg3;
+    register uint64_t r8 __asm__("r8") = arg4;
+    register uint64_t r9 __asm__("r9") = arg5;
+
+    __asm__ volatile("syscall"
+                     : "=a"(ret)
+                     : "a"(number), "D"(arg0), "S"(arg1), "d"(arg2), "r"(r10), "r"(r8), "r"(r9)
+                     : "rcx", "r11", "memory");
+
+    /* The kernel returns -errno, turn that into what syscall() would return. */
+    if(ret < 0 && ret > -4096)
+    {
+        errno = (int)-ret;
+        return (-1);
+    }
+
+    return (ret);
+}
+
+#else
+
+/* The BSDs and Mac OSX report errors through the carry flag, let libc deal with it. */
+static inline int64_t raw_syscall(int64_t number, uint64_t arg0, uint64_t arg1, uint64_t arg2,
+                                  uint64_t arg3, uint64_t arg4, uint64_t arg5)
+{
+    return ((int64_t)syscall((int)number, arg0, arg1, arg2, arg3, arg4, arg5));
+}
+
+#endif
+
+/**
+ * Call a syscall with generated arguments, whatever mix of pointer and value
+ * arguments it takes.
+ * @param symbol The syscall number.
+ * @param ptr_args Bit n is set if argument n is passed as a pointer, see ARG_PTR().
+ * @param array The argument array, all six slots must point at valid memory.
+ * @return The syscall's return value.
+ */
+static inline int32_t dispatch_syscall(int32_t symbol, uint32_t ptr_args, uint64_t **array)
+{
+    DISPATCH_ARGS(DISPATCH_LOAD)
+
+    return ((int32_t)raw_syscall(symbol, arg0, arg1, arg2, arg3, arg4, arg5));
+}
+
+#endif
@@ -24,14 +24,21 @@
 
 #include <stdbool.h>
 
-enum test_id { V_ID, P_ID, VP_ID, VPV_ID, PV_ID, PVV_ID,
-               PP_ID, VPVVPV_ID, VPVP_ID,
-               VVPV_ID };
-
 enum syscall_status { ON, OFF };
 
 enum argnums { FIRST_ARG, SECOND_ARG, THIRD_ARG, FOURTH_ARG, FIFTH_ARG, SIXTH_ARG};
 
+/* Mark an argument as passed by pointer in an entry's ptr_args, e.g.
+   .ptr_args = ARG_PTR(FIRST_ARG) | ARG_PTR(THIRD_ARG). */
+#define ARG_PTR(arg) (1U << (arg))
+
+/* Subsystems a syscall can belong to, --group limits a run to some of them. */
+enum syscall_group { GROUP_FS, GROUP_NET, GROUP_IPC, GROUP_MM, GROUP_PROC, GROUP_TOTAL };
+
+/* Put an entry in a group in it's groups mask, e.g.
+   .groups = SYSCALL_GROUP(GROUP_FS) | SYSCALL_GROUP(GROUP_NET). */
+#define SYSCALL_GROUP(group) (1U << (group))
+
 struct syscall_entry
 {
     const char *syscall_name;
@@ -53,11 +60,23 @@ struct syscall_entry
 
     int32_t (*get_arg_array[7])(uint64_t **, struct child_ctx *);
 
-    int32_t (*test_syscall)(int32_t, uint64_t **);
+    /* Bit n is set when argument n is passed as a pointer instead of a value. */
+    const uint32_t ptr_args;
+
+    /* The resource type (FILE_DESC, SOCKET) the syscall returns on success, later
+      syscalls in the same program can use it. Only used when returns_resource is true. */
+    const int32_t ret_type;
+
+    const bool returns_resource;
+
+    const char padding3[3];
 
-    enum test_id id;
+    /* The syscall_group bits the syscall is in. */
+    const uint32_t groups;
 
-    const char padding3[4];
+    /* Longest a need_alarm syscall may block in microseconds, zero for the default.
+      The timeout used shrinks toward the syscall's observed latency. */
+    const uint32_t timeout_us;
 };
 
 #endif
@@ -25,6 +25,8 @@ struct syscall_entry entry_fchdir = {
     .status = ON,
     .requires_root = NX_NO,
     .need_alarm = NX_NO,
+    .groups = SYSCALL_GROUP(GROUP_FS),
+    .ptr_args = 0,
 
     .arg_type_array[FIRST_ARG] = FILE_DESC,
     .get_arg_array[FIRST_ARG] = &generate_fd
@@ -25,6 +25,8 @@ struct syscall_entry entry_link = {
     .status = ON,
     .requires_root = NX_NO,
     .need_alarm = NX_NO,
+    .groups = SYSCALL_GROUP(GROUP_FS),
+    .ptr_args = ARG_PTR(FIRST_ARG) | ARG_PTR(SECOND_ARG),
 
     .arg_type_array[FIRST_ARG] = FILE_PATH,
     .get_arg_array[FIRST_ARG] = &generate_path,
@@ -25,6 +25,8 @@ struct syscall_entry entry_mount = {
     .status = ON,
     .requires_root = NX_YES,
     .need_alarm = NX_NO,
+    .groups = SYSCALL_GROUP(GROUP_FS),
+    .ptr_args = ARG_PTR(FIRST_ARG) | ARG_PTR(SECOND_ARG) | ARG_PTR(FOURTH_ARG),
 
     .arg_type_array[FIRST_ARG] = MOUNT_TYPE,
     .get_arg_array[FIRST_ARG] = &generate_mount_type,
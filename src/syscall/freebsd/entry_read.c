@@ -25,6 +25,9 @@ struct syscall_entry entry_read = {
     .status = ON,
     .requires_root = NX_NO,
     .need_alarm = NX_YES,
+    .groups = SYSCALL_GROUP(GROUP_FS),
+    .ptr_args = ARG_PTR(SECOND_ARG),
+    .timeout_us = 100000,
 
     .arg_type_array[FIRST_ARG] = FILE_DESC,
     .get_arg_array[FIRST_ARG] = &generate_fd,
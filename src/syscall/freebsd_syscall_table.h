@@ -21,24 +21,29 @@
 #include "syscall_list.h"
 #include "syscall_table.h"
 
+static struct syscall_entry *const freebsd_entries[] = {
+
+    &entry_read,
+    &entry_write,
+    &entry_open,
+    &entry_close,
+    &entry_wait4,
+    &entry_link,
+    &entry_unlink,
+    &entry_chdir,
+    &entry_fchdir,
+    &entry_mknod,
+    &entry_getfsstat,
+    &entry_lseek,
+    &entry_setuid,
+    &entry_ptrace,
+    &entry_recvmsg
+};
+
 struct syscall_table freebsd_syscall_table = {
-    
-    .total_syscalls = 15,
-    .sys_entry[0] = &entry_read,
-    .sys_entry[1] = &entry_write,
-    .sys_entry[2] = &entry_open,
-    .sys_entry[3] = &entry_close,
-    .sys_entry[4] = &entry_wait4,
-    .sys_entry[5] = &entry_link,
-    .sys_entry[6] = &entry_unlink,
-    .sys_entry[7] = &entry_chdir,
-    .sys_entry[8] = &entry_fchdir,
-    .sys_entry[9] = &entry_mknod,
-    .sys_entry[10] = &entry_getfsstat,
-    .sys_entry[11] = &entry_lseek,
-    .sys_entry[12] = &entry_setuid,
-    .sys_entry[13] = &entry_ptrace,
-    .sys_entry[14] = &entry_recvmsg
+
+    .total_syscalls = sizeof(freebsd_entries) / sizeof(freebsd_entries[0]),
+    .sys_entry = freebsd_entries
 };
 
 #endif
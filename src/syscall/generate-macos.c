@@ -32,7 +32,7 @@ int32_t generate_mount_flags(uint64_t **flag, struct child_ctx *child)
     int32_t flags[] = {MNT_RDONLY, MNT_NOEXEC,      MNT_NOSUID,  MNT_NODEV,
                        MNT_UNION,  MNT_SYNCHRONOUS, MNT_CPROTECT};
 
-    (*flag) = mem_alloc(sizeof(int32_t));
+    (*flag) = generate_alloc(sizeof(int32_t));
     if((*flag) == NULL)
     {
         output(ERROR, "Can't alloc mount flags\n");
@@ -64,7 +64,7 @@ int32_t generate_unmount_flags(uint64_t **flag, struct child_ctx *child)
     int32_t flags[] = {MNT_RDONLY, MNT_NOEXEC, MNT_NOSUID, MNT_NODEV,
                        MNT_UNION, MNT_SYNCHRONOUS, MNT_CPROTECT};
 
-    (*flag) = mem_alloc(sizeof(uint64_t));
+    (*flag) = generate_alloc(sizeof(uint64_t));
     if((*flag) == NULL)
     {
         output(ERROR, "Can't alloc mount flags\n");
@@ -95,7 +95,7 @@ int32_t generate_request(uint64_t **flag, struct child_ctx *child)
     int32_t request[] = {PT_TRACE_ME, PT_DENY_ATTACH, PT_CONTINUE,  PT_STEP,
                          PT_KILL,     PT_ATTACH,      PT_ATTACHEXC, PT_DETACH};
 
-    (*flag) = mem_alloc(sizeof(int32_t));
+    (*flag) = generate_alloc(sizeof(int32_t));
     if((*flag) == NULL)
     {
         output(ERROR, "Can't alloc mount flags\n");
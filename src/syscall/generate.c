@@ -47,25 +47,44 @@
 
 #endif
 
+/* The arena arguments are allocated from, it belongs to the test case being generated. */
+static struct mem_arena *arena;
+
+void set_generate_arena(struct mem_arena *new_arena)
+{
+    arena = new_arena;
+
+    return;
+}
+
+void *generate_alloc(uint64_t nbytes)
+{
+    if(arena == NULL)
+        return (mem_alloc(nbytes));
+
+    return (mem_arena_alloc(arena, nbytes));
+}
+
 int32_t generate_fd(uint64_t **fd, struct child_ctx *child)
 {
     /* Allocate the descriptor. */
-    (*fd) = mem_alloc(sizeof(int32_t));
+    (*fd) = generate_alloc(sizeof(int32_t));
     if((*fd) == NULL)
     {
         output(ERROR, "Can't allocate a descriptor\n");
         return (-1);
     }
 
+    struct resource_handle *handle = get_arg_handle(child);
+
     /* Get a file descriptor from the descriptor pool. */
-    int32_t desc = get_desc();
-    if(desc < 0)
+    if(get_desc(handle) < 0)
     {
         output(ERROR, "Can't get file descriptor\n");
         return (-1);
     }
 
-    memmove((*fd), &desc, sizeof(int32_t));
+    memmove((*fd), &handle->fd, sizeof(int32_t));
 
     //printf("OG_DESC: %d\n", (int32_t)(**fd));
 
@@ -77,23 +96,22 @@ int32_t generate_fd(uint64_t **fd, struct child_ctx *child)
 
 int32_t generate_socket(uint64_t **sock, struct child_ctx *child)
 {
-    (*sock) = mem_alloc(sizeof(int32_t));
+    (*sock) = generate_alloc(sizeof(int32_t));
     if((*sock) == NULL)
     {
         output(ERROR, "Can't allocate socket\n");
         return (-1);
     }
 
-    int32_t sock_fd = 0;
+    struct resource_handle *handle = get_arg_handle(child);
 
-    sock_fd = get_socket();
-    if(sock_fd < 0)
+    if(get_socket(handle) < 0)
     {
         output(ERROR, "Can't get socket\n");
         return (-1);
     }
 
-    memmove((*sock), &sock_fd, sizeof(int32_t));
+    memmove((*sock), &handle->fd, sizeof(int32_t));
 
     set_arg_size(child, sizeof(int32_t));
 
@@ -176,7 +194,7 @@ int32_t generate_length(uint64_t **length, struct child_ctx *child)
         last_arg = get_current_arg(child) - 1;
 
     /* Allocate the length buffer */
-    (*length) = mem_alloc(sizeof(uint64_t));
+    (*length) = generate_alloc(sizeof(uint64_t));
     if((*length) == NULL)
     {
         output(ERROR, "Can't alloc length\n");
@@ -203,13 +221,16 @@ int32_t generate_length(uint64_t **length, struct child_ctx *child)
 
 int32_t generate_path(uint64_t **path, struct child_ctx *child)
 {
-    (*path) = (uint64_t *)get_filepath();
-    if((*path) == NULL)
+    struct resource_handle *handle = get_arg_handle(child);
+
+    if(get_filepath(handle) < 0)
     {
         output(ERROR, "Can't get file path\n");
         return (-1);
     }
 
+    (*path) = (uint64_t *)handle->path;
+
     //printf("OG_PATH: %s\n", (char *)(**path));
 
     set_arg_size(child, strlen((char *)(*path)));
@@ -229,7 +250,7 @@ int32_t generate_open_flag(uint64_t **flag, struct child_ctx *child)
         return (-1);
     }
 
-    (*flag) = mem_alloc(12);
+    (*flag) = generate_alloc(12);
     if((*flag) == NULL)
     {
         output(ERROR, "Can't alloc flag\n");
@@ -292,7 +313,7 @@ int32_t generate_mode(uint64_t **mode, struct child_ctx *child)
         return (-1);
     }
 
-    *mode = mem_alloc(12);
+    *mode = generate_alloc(12);
     if(*mode == NULL)
     {
         output(ERROR, "Can't alloc mode\n");
@@ -397,7 +418,7 @@ int32_t generate_mode(uint64_t **mode, struct child_ctx *child)
 
 int32_t generate_fs_stat(uint64_t **stat, struct child_ctx *child)
 {
-    struct statfs *stat_buf = mem_alloc(sizeof(struct statfs));
+    struct statfs *stat_buf = generate_alloc(sizeof(struct statfs));
     if(stat_buf == NULL)
     {
         output(ERROR, "Can't alloc stat\n");
@@ -419,7 +440,7 @@ int32_t generate_fs_stat_flag(uint64_t **flag, struct child_ctx *child)
     int32_t rtrn = 0;
     uint32_t number = 0;
 
-    *flag = mem_alloc(12);
+    *flag = generate_alloc(12);
     if(*flag == NULL)
     {
         output(ERROR, "Can't alloc flag\n");
@@ -457,7 +478,7 @@ int32_t generate_fs_stat_flag(uint64_t **flag, struct child_ctx *child)
 
 int32_t generate_pid(uint64_t **pid, struct child_ctx *child)
 {
-    (*pid) = mem_alloc(sizeof(unsigned long));
+    (*pid) = generate_alloc(sizeof(unsigned long));
     if((*pid) == NULL)
     {
         output(STD, "Can't alloc pid\n");
@@ -476,7 +497,7 @@ int32_t generate_int(uint64_t **integer, struct child_ctx *child)
     uint32_t number;
     int32_t rtrn = 0;
 
-    *integer = mem_alloc(sizeof(uint64_t));
+    *integer = generate_alloc(sizeof(uint64_t));
     if(*integer == NULL)
     {
         output(ERROR, "Can't alloc int\n");
@@ -501,7 +522,7 @@ int32_t generate_rusage(uint64_t **usage, struct child_ctx *child)
 {
     struct rusage *buf = NULL;
 
-    buf = mem_alloc(sizeof(struct rusage));
+    buf = generate_alloc(sizeof(struct rusage));
     if(buf == NULL)
     {
         output(ERROR, "Can't alloc rusage\n");
@@ -520,7 +541,7 @@ int32_t generate_wait_option(uint64_t **option, struct child_ctx *child)
     int32_t rtrn = 0;
     uint32_t number = 0;
 
-    (*option) = mem_alloc(sizeof(unsigned long));
+    (*option) = generate_alloc(sizeof(unsigned long));
     if((*option) == NULL)
     {
         output(ERROR, "Can't alloc option\n");
@@ -559,10 +580,10 @@ int32_t generate_whence(uint64_t **whence, struct child_ctx *child)
     int32_t rtrn = 0;
     uint32_t number = 0;
 
-    (*whence) = mem_alloc(sizeof(uint64_t));
+    (*whence) = generate_alloc(sizeof(uint64_t));
     if((*whence) == NULL)
     {
-        output(ERROR, "mem_alloc\n");
+        output(ERROR, "Can't alloc whence\n");
         return (-1);
     }
 
@@ -628,10 +649,10 @@ int32_t generate_offset(uint64_t **offset, struct child_ctx *child)
 {
     int32_t rtrn = 0;
 
-    (*offset) = mem_alloc(sizeof(uint64_t));
+    (*offset) = generate_alloc(sizeof(uint64_t));
     if((*offset) == NULL)
     {
-        output(ERROR, "mem_alloc\n");
+        output(ERROR, "Can't alloc offset\n");
         return (-1);
     }
 
@@ -664,13 +685,16 @@ int32_t generate_mount_type(uint64_t **type, struct child_ctx *child)
 
 int32_t generate_dirpath(uint64_t **dirpath, struct child_ctx *child)
 {
-    (*dirpath) = (uint64_t *)get_dirpath();
-    if((*dirpath) == NULL)
+    struct resource_handle *handle = get_arg_handle(child);
+
+    if(get_dirpath(handle) < 0)
     {
         output(ERROR, "Can't get directory path\n");
         return (-1);
     }
 
+    (*dirpath) = (uint64_t *)handle->path;
+
     set_arg_size(child, strlen((char *)(*dirpath)));
 
     return (0);
@@ -681,7 +705,7 @@ int32_t generate_recv_flags(uint64_t **flag, struct child_ctx *child)
     int32_t rtrn = 0;
     uint32_t number = 0;
 
-    (*flag) = mem_alloc(sizeof(uint32_t));
+    (*flag) = generate_alloc(sizeof(uint32_t));
     if((*flag) == NULL)
     {
         output(ERROR, "Can't alloc mount flags\n");
@@ -721,7 +745,7 @@ int32_t generate_recv_flags(uint64_t **flag, struct child_ctx *child)
 
 int32_t generate_dev(uint64_t **dev, struct child_ctx *child)
 {
-    (*dev) = mem_alloc(sizeof(dev_t));
+    (*dev) = generate_alloc(sizeof(dev_t));
     if((*dev) == NULL)
     {
         output(ERROR, "Can't alloc dev\n");
@@ -747,7 +771,7 @@ int32_t generate_dev(uint64_t **dev, struct child_ctx *child)
 
 int32_t generate_message(uint64_t **msg, struct child_ctx *child)
 {
-    (*msg) = mem_alloc(sizeof(struct msghdr));
+    (*msg) = generate_alloc(sizeof(struct msghdr));
     if((*msg) == NULL)
     {
         output(ERROR, "Can't alloc message header\n");
@@ -759,7 +783,7 @@ int32_t generate_message(uint64_t **msg, struct child_ctx *child)
     char *data = NULL;
     int32_t rtrn = 0;
 
-    data = mem_alloc(64);
+    data = generate_alloc(64);
     if(data == NULL)
     {
         output(ERROR, "Can't allocate data\n");
@@ -800,7 +824,7 @@ int32_t generate_send_flags(uint64_t **flag, struct child_ctx *child)
     uint32_t number = 0;
     int32_t send_flags[] = {MSG_OOB, MSG_DONTROUTE};
 
-    (*flag) = mem_alloc(sizeof(uint64_t));
+    (*flag) = generate_alloc(sizeof(uint64_t));
     if((*flag) == NULL)
     {
         output(ERROR, "Can't allocate send flags\n");
@@ -840,7 +864,7 @@ int32_t generate_sockaddr(uint64_t **addr, struct child_ctx *child)
     struct sockaddr_in in;
     uint32_t port = 0;
 
-    (*addr) = mem_alloc(sizeof(struct sockaddr_in));
+    (*addr) = generate_alloc(sizeof(struct sockaddr_in));
     if((*addr) == NULL)
     {
         output(ERROR, "Can't allocate sockaddr\n");
@@ -875,7 +899,7 @@ int32_t generate_socklen(uint64_t **len, struct child_ctx *child)
         last_arg = get_current_arg(child) - 1;
 
     /* Allocate the length buffer */
-    (*len) = mem_alloc(sizeof(socklen_t));
+    (*len) = generate_alloc(sizeof(socklen_t));
     if((*len) == NULL)
     {
         output(ERROR, "Can't alloc length\n");
@@ -905,7 +929,7 @@ int32_t generate_amode(uint64_t **amode, struct child_ctx *child)
     int32_t rtrn = 0;
     uint32_t number = 0;
 
-    (*amode) = mem_alloc(sizeof(uint32_t));
+    (*amode) = generate_alloc(sizeof(uint32_t));
     if((*amode) == NULL)
     {
         output(ERROR, "Can't allocate amode\n");
@@ -966,7 +990,7 @@ int32_t generate_chflags(uint64_t **flag, struct child_ctx *child)
     int32_t rtrn = 0;
     uint32_t number = 0;
 
-    (*flag) = mem_alloc(sizeof(uint32_t));
+    (*flag) = generate_alloc(sizeof(uint32_t));
     if((*flag) == NULL)
     {
         output(ERROR, "Can't allocate flag\n");
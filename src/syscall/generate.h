@@ -22,6 +22,22 @@
 
 #include <stdint.h>
 
+struct mem_arena;
+
+/**
+ * Make the generators allocate from arena until the next call, so everything
+ * a test case allocates can be dropped with one mem_arena_reset().
+ * @param arena The arena to allocate from, NULL to use the heap.
+ */
+extern void set_generate_arena(struct mem_arena *arena);
+
+/**
+ * Allocate memory for a generated argument.
+ * @param nbytes Number of bytes to allocate.
+ * @return A pointer on success and NULL on failure.
+ */
+extern void *generate_alloc(uint64_t nbytes);
+
 extern int32_t generate_fd(uint64_t **fd, struct child_ctx *ctx);
 
 extern int32_t generate_socket(uint64_t **sock, struct child_ctx *ctx);
@@ -0,0 +1,50 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+/* Generated by tools/entrygen/entrygen.py, edit tools/entrygen/linux.annotations instead. */
+
+#include "syscall_list.h"
+
+#ifdef SYS_accept
+
+/* long sys_accept(int fd, struct sockaddr __user *upeer_sockaddr, int __user *upeer_addrlen); */
+struct syscall_entry entry_accept = {
+
+    .syscall_name = "accept",
+    .syscall_symbol = SYS_accept,
+    .total_args = 3,
+    .status = ON,
+    .requires_root = NX_NO,
+    .need_alarm = NX_YES,
+    .timeout_us = 100000,
+    .ret_type = SOCKET,
+    .returns_resource = true,
+    .groups = SYSCALL_GROUP(GROUP_NET),
+    .ptr_args = ARG_PTR(SECOND_ARG) | ARG_PTR(THIRD_ARG),
+
+    /* int fd */
+    .arg_type_array[FIRST_ARG] = SOCKET,
+    .get_arg_array[FIRST_ARG] = &generate_socket,
+
+    /* struct sockaddr __user *upeer_sockaddr */
+    .arg_type_array[SECOND_ARG] = SOCKADDR,
+    .get_arg_array[SECOND_ARG] = &generate_sockaddr,
+
+    /* int __user *upeer_addrlen */
+    .arg_type_array[THIRD_ARG] = VOID_BUF,
+    .get_arg_array[THIRD_ARG] = &generate_buf
+};
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+/* Generated by tools/entrygen/entrygen.py, edit tools/entrygen/linux.annotations instead. */
+
+#include "syscall_list.h"
+
+#ifdef SYS_add_key
+
+/* long sys_add_key(const char __user *_type, const char __user *_description, const void __user *_payload, size_t plen, key_serial_t destringid); */
+struct syscall_entry entry_add_key = {
+
+    .syscall_name = "add_key",
+    .syscall_symbol = SYS_add_key,
+    .total_args = 5,
+    .status = ON,
+    .requires_root = NX_NO,
+    .need_alarm = NX_NO,
+    .groups = SYSCALL_GROUP(GROUP_IPC),
+    .ptr_args = ARG_PTR(FIRST_ARG) | ARG_PTR(SECOND_ARG) | ARG_PTR(THIRD_ARG),
+
+    /* const char __user *_type */
+    .arg_type_array[FIRST_ARG] = VOID_BUF,
+    .get_arg_array[FIRST_ARG] = &generate_buf,
+
+    /* const char __user *_description */
+    .arg_type_array[SECOND_ARG] = VOID_BUF,
+    .get_arg_array[SECOND_ARG] = &generate_buf,
+
+    /* const void __user *_payload */
+    .arg_type_array[THIRD_ARG] = VOID_BUF,
+    .get_arg_array[THIRD_ARG] = &generate_buf,
+
+    /* size_t plen */
+    .arg_type_array[FOURTH_ARG] = SIZE,
+    .get_arg_array[FOURTH_ARG] = &generate_length,
+
+    /* key_serial_t destringid */
+    .arg_type_array[FIFTH_ARG] = INT,
+    .get_arg_array[FIFTH_ARG] = &generate_int
+};
+
+#endif
@@ -0,0 +1,47 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+/* Generated by tools/entrygen/entrygen.py, edit tools/entrygen/linux.annotations instead. */
+
+#include "syscall_list.h"
+
+#ifdef SYS_bind
+
+/* long sys_bind(int fd, struct sockaddr __user *umyaddr, int addrlen); */
+struct syscall_entry entry_bind = {
+
+    .syscall_name = "bind",
+    .syscall_symbol = SYS_bind,
+    .total_args = 3,
+    .status = ON,
+    .requires_root = NX_NO,
+    .need_alarm = NX_NO,
+    .groups = SYSCALL_GROUP(GROUP_NET),
+    .ptr_args = ARG_PTR(SECOND_ARG),
+
+    /* int fd */
+    .arg_type_array[FIRST_ARG] = SOCKET,
+    .get_arg_array[FIRST_ARG] = &generate_socket,
+
+    /* struct sockaddr __user *umyaddr */
+    .arg_type_array[SECOND_ARG] = SOCKADDR,
+    .get_arg_array[SECOND_ARG] = &generate_sockaddr,
+
+    /* int addrlen */
+    .arg_type_array[THIRD_ARG] = SOCKLEN,
+    .get_arg_array[THIRD_ARG] = &generate_socklen
+};
+
+#endif
@@ -0,0 +1,46 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+/* Generated by tools/entrygen/entrygen.py, edit tools/entrygen/linux.annotations instead. */
+
+#include "syscall_list.h"
+
+#ifdef SYS_bpf
+
+/* long sys_bpf(int cmd, union bpf_attr __user *attr, unsigned int size); */
+struct syscall_entry entry_bpf = {
+
+    .syscall_name = "bpf",
+    .syscall_symbol = SYS_bpf,
+    .total_args = 3,
+    .status = ON,
+    .requires_root = NX_YES,
+    .need_alarm = NX_NO,
+    .ptr_args = ARG_PTR(SECOND_ARG),
+
+    /* int cmd */
+    .arg_type_array[FIRST_ARG] = INT,
+    .get_arg_array[FIRST_ARG] = &generate_int,
+
+    /* union bpf_attr __user *attr */
+    .arg_type_array[SECOND_ARG] = VOID_BUF,
+    .get_arg_array[SECOND_ARG] = &generate_buf,
+
+    /* unsigned int size */
+    .arg_type_array[THIRD_ARG] = INT,
+    .get_arg_array[THIRD_ARG] = &generate_int
+};
+
+#endif
@@ -0,0 +1,39 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+/* Generated by tools/entrygen/entrygen.py, edit tools/entrygen/linux.annotations instead. */
+
+#include "syscall_list.h"
+
+#ifdef SYS_brk
+
+/* long sys_brk(unsigned long brk); */
+struct syscall_entry entry_brk = {
+
+    .syscall_name = "brk",
+    .syscall_symbol = SYS_brk,
+    .total_args = 1,
+    .status = OFF,
+    .requires_root = NX_NO,
+    .need_alarm = NX_NO,
+    .groups = SYSCALL_GROUP(GROUP_MM),
+    .ptr_args = 0,
+
+    /* unsigned long brk */
+    .arg_type_array[FIRST_ARG] = INT,
+    .get_arg_array[FIRST_ARG] = &generate_int
+};
+
+#endif
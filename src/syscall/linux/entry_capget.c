@@ -0,0 +1,43 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+/* Generated by tools/entrygen/entrygen.py, edit tools/entrygen/linux.annotations instead. */
+
+#include "syscall_list.h"
+
+#ifdef SYS_capget
+
+/* long sys_capget(cap_user_header_t header, cap_user_data_t dataptr); */
+struct syscall_entry entry_capget = {
+
+    .syscall_name = "capget",
+    .syscall_symbol = SYS_capget,
+    .total_args = 2,
+    .status = ON,
+    .requires_root = NX_NO,
+    .need_alarm = NX_NO,
+    .groups = SYSCALL_GROUP(GROUP_PROC),
+    .ptr_args = 0,
+
+    /* cap_user_header_t header */
+    .arg_type_array[FIRST_ARG] = INT,
+    .get_arg_array[FIRST_ARG] = &generate_int,
+
+    /* cap_user_data_t dataptr */
+    .arg_type_array[SECOND_ARG] = INT,
+    .get_arg_array[SECOND_ARG] = &generate_int
+};
+
+#endif
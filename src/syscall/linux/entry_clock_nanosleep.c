@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+/* Generated by tools/entrygen/entrygen.py, edit tools/entrygen/linux.annotations instead. */
+
+#include "syscall_list.h"
+
+#ifdef SYS_clock_nanosleep
+
+/* long sys_clock_nanosleep(clockid_t which_clock, int flags, const struct __kernel_timespec __user *rqtp, struct __kernel_timespec __user *rmtp); */
+struct syscall_entry entry_clock_nanosleep = {
+
+    .syscall_name = "clock_nanosleep",
+    .syscall_symbol = SYS_clock_nanosleep,
+    .total_args = 4,
+    .status = ON,
+    .requires_root = NX_NO,
+    .need_alarm = NX_YES,
+    .timeout_us = 100000,
+    .ptr_args = ARG_PTR(THIRD_ARG) | ARG_PTR(FOURTH_ARG),
+
+    /* clockid_t which_clock */
+    .arg_type_array[FIRST_ARG] = INT,
+    .get_arg_array[FIRST_ARG] = &generate_int,
+
+    /* int flags */
+    .arg_type_array[SECOND_ARG] = INT,
+    .get_arg_array[SECOND_ARG] = &generate_int,
+
+    /* const struct __kernel_timespec __user *rqtp */
+    .arg_type_array[THIRD_ARG] = VOID_BUF,
+    .get_arg_array[THIRD_ARG] = &generate_buf,
+
+    /* struct __kernel_timespec __user *rmtp */
+    .arg_type_array[FOURTH_ARG] = VOID_BUF,
+    .get_arg_array[FOURTH_ARG] = &generate_buf
+};
+
+#endif
@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+/* Generated by tools/entrygen/entrygen.py, edit tools/entrygen/linux.annotations instead. */
+
+#include "syscall_list.h"
+
+#ifdef SYS_copy_file_range
+
+/* long sys_copy_file_range(int fd_in, loff_t __user *off_in, int fd_out, loff_t __user *off_out, size_t len, unsigned int flags); */
+struct syscall_entry entry_copy_file_range = {
+
+    .syscall_name = "copy_file_range",
+    .syscall_symbol = SYS_copy_file_range,
+    .total_args = 6,
+    .status = ON,
+    .requires_root = NX_NO,
+    .need_alarm = NX_YES,
+    .timeout_us = 100000,
+    .groups = SYSCALL_GROUP(GROUP_FS),
+    .ptr_args = ARG_PTR(SECOND_ARG) | ARG_PTR(FOURTH_ARG),
+
+    /* int fd_in */
+    .arg_type_array[FIRST_ARG] = FILE_DESC,
+    .get_arg_array[FIRST_ARG] = &generate_fd,
+
+    /* loff_t __user *off_in */
+    .arg_type_array[SECOND_ARG] = VOID_BUF,
+    .get_arg_array[SECOND_ARG] = &generate_buf,
+
+    /* int fd_out */
+    .arg_type_array[THIRD_ARG] = FILE_DESC,
+    .get_arg_array[THIRD_ARG] = &generate_fd,
+
+    /* loff_t __user *off_out */
+    .arg_type_array[FOURTH_ARG] = VOID_BUF,
+    .get_arg_array[FOURTH_ARG] = &generate_buf,
+
+    /* size_t len */
+    .arg_type_array[FIFTH_ARG] = SIZE,
+    .get_arg_array[FIFTH_ARG] = &generate_length,
+
+    /* unsigned int flags */
+    .arg_type_array[SIXTH_ARG] = INT,
+    .get_arg_array[SIXTH_ARG] = &generate_int
+};
+
+#endif
@@ -0,0 +1,42 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+/* Generated by tools/entrygen/entrygen.py, edit tools/entrygen/linux.annotations instead. */
+
+#include "syscall_list.h"
+
+#ifdef SYS_delete_module
+
+/* long sys_delete_module(const char __user *name_user, unsigned int flags); */
+struct syscall_entry entry_delete_module = {
+
+    .syscall_name = "delete_module",
+    .syscall_symbol = SYS_delete_module,
+    .total_args = 2,
+    .status = OFF,
+    .requires_root = NX_YES,
+    .need_alarm = NX_NO,
+    .ptr_args = ARG_PTR(FIRST_ARG),
+
+    /* const char __user *name_user */
+    .arg_type_array[FIRST_ARG] = VOID_BUF,
+    .get_arg_array[FIRST_ARG] = &generate_buf,
+
+    /* unsigned int flags */
+    .arg_type_array[SECOND_ARG] = INT,
+    .get_arg_array[SECOND_ARG] = &generate_int
+};
+
+#endif
@@ -0,0 +1,49 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+/* Generated by tools/entrygen/entrygen.py, edit tools/entrygen/linux.annotations instead. */
+
+#include "syscall_list.h"
+
+#ifdef SYS_dup3
+
+/* long sys_dup3(unsigned int oldfd, unsigned int newfd, int flags); */
+struct syscall_entry entry_dup3 = {
+
+    .syscall_name = "dup3",
+    .syscall_symbol = SYS_dup3,
+    .total_args = 3,
+    .status = ON,
+    .requires_root = NX_NO,
+    .need_alarm = NX_NO,
+    .ret_type = FILE_DESC,
+    .returns_resource = true,
+    .groups = SYSCALL_GROUP(GROUP_FS),
+    .ptr_args = 0,
+
+    /* unsigned int oldfd */
+    .arg_type_array[FIRST_ARG] = FILE_DESC,
+    .get_arg_array[FIRST_ARG] = &generate_fd,
+
+    /* unsigned int newfd */
+    .arg_type_array[SECOND_ARG] = FILE_DESC,
+    .get_arg_array[SECOND_ARG] = &generate_fd,
+
+    /* int flags */
+    .arg_type_array[THIRD_ARG] = INT,
+    .get_arg_array[THIRD_ARG] = &generate_int
+};
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+/* Generated by tools/entrygen/entrygen.py, edit tools/entrygen/linux.annotations instead. */
+
+#include "syscall_list.h"
+
+#ifdef SYS_epoll_ctl
+
+/* long sys_epoll_ctl(int epfd, int op, int fd, struct epoll_event __user *event); */
+struct syscall_entry entry_epoll_ctl = {
+
+    .syscall_name = "epoll_ctl",
+    .syscall_symbol = SYS_epoll_ctl,
+    .total_args = 4,
+    .status = ON,
+    .requires_root = NX_NO,
+    .need_alarm = NX_NO,
+    .ptr_args = ARG_PTR(FOURTH_ARG),
+
+    /* int epfd */
+    .arg_type_array[FIRST_ARG] = FILE_DESC,
+    .get_arg_array[FIRST_ARG] = &generate_fd,
+
+    /* int op */
+    .arg_type_array[SECOND_ARG] = INT,
+    .get_arg_array[SECOND_ARG] = &generate_int,
+
+    /* int fd */
+    .arg_type_array[THIRD_ARG] = FILE_DESC,
+    .get_arg_array[THIRD_ARG] = &generate_fd,
+
+    /* struct epoll_event __user *event */
+    .arg_type_array[FOURTH_ARG] = VOID_BUF,
+    .get_arg_array[FOURTH_ARG] = &generate_buf
+};
+
+#endif
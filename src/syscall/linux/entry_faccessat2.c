@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+/* Generated by tools/entrygen/entrygen.py, edit tools/entrygen/linux.annotations instead. */
+
+#include "syscall_list.h"
+
+#ifdef SYS_faccessat2
+
+/* long sys_faccessat2(int dfd, const char __user *filename, int mode, int flags); */
+struct syscall_entry entry_faccessat2 = {
+
+    .syscall_name = "faccessat2",
+    .syscall_symbol = SYS_faccessat2,
+    .total_args = 4,
+    .status = ON,
+    .requires_root = NX_NO,
+    .need_alarm = NX_NO,
+    .groups = SYSCALL_GROUP(GROUP_FS),
+    .ptr_args = ARG_PTR(SECOND_ARG),
+
+    /* int dfd */
+    .arg_type_array[FIRST_ARG] = FILE_DESC,
+    .get_arg_array[FIRST_ARG] = &generate_fd,
+
+    /* const char __user *filename */
+    .arg_type_array[SECOND_ARG] = FILE_PATH,
+    .get_arg_array[SECOND_ARG] = &generate_path,
+
+    /* int mode */
+    .arg_type_array[THIRD_ARG] = AMODE,
+    .get_arg_array[THIRD_ARG] = &generate_amode,
+
+    /* int flags */
+    .arg_type_array[FOURTH_ARG] = INT,
+    .get_arg_array[FOURTH_ARG] = &generate_int
+};
+
+#endif
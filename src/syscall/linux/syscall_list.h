@@ -1,25 +1,23 @@
-
-
 /**
- * Copyright (c) 2015, Harrison Bowden, Secure Labs, Minneapolis, MN
- * 
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
  * Permission to use, copy, modify, and/or distribute this software for any purpose
- * with or without fee is hereby granted, provided that the above copyright notice 
+ * with or without fee is hereby granted, provided that the above copyright notice
  * and this permission notice appear in all copies.
- * 
- * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH 
- * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY 
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
  * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
- * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, 
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
  * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
  * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  **/
 
+/* Generated by tools/entrygen/entrygen.py, edit tools/entrygen/linux.annotations instead. */
+
 #ifndef SYSCALL_LIST_H
 #define SYSCALL_LIST_H
 
-#define SYS_creat 0
-
 #include "../arg_types.h"
 #include "../entry.h"
 #include "../generate.h"
@@ -29,8 +27,339 @@
 /* Linux's system call list. This file declares all the syscalls entries
 on the Linux platform. These syscall entries tell us how to fuzz each syscall on the system.  */
 
-/* Skip the fork syscall because it can't be called from syscall().  */
-
 extern struct syscall_entry entry_read;
+extern struct syscall_entry entry_write;
+extern struct syscall_entry entry_open;
+extern struct syscall_entry entry_close;
+extern struct syscall_entry entry_stat;
+extern struct syscall_entry entry_fstat;
+extern struct syscall_entry entry_lstat;
+extern struct syscall_entry entry_poll;
+extern struct syscall_entry entry_lseek;
+extern struct syscall_entry entry_mmap;
+extern struct syscall_entry entry_mprotect;
+extern struct syscall_entry entry_munmap;
+extern struct syscall_entry entry_brk;
+extern struct syscall_entry entry_rt_sigaction;
+extern struct syscall_entry entry_rt_sigprocmask;
+extern struct syscall_entry entry_ioctl;
+extern struct syscall_entry entry_pread64;
+extern struct syscall_entry entry_pwrite64;
+extern struct syscall_entry entry_readv;
+extern struct syscall_entry entry_writev;
+extern struct syscall_entry entry_access;
+extern struct syscall_entry entry_pipe;
+extern struct syscall_entry entry_select;
+extern struct syscall_entry entry_sched_yield;
+extern struct syscall_entry entry_mremap;
+extern struct syscall_entry entry_msync;
+extern struct syscall_entry entry_mincore;
+extern struct syscall_entry entry_madvise;
+extern struct syscall_entry entry_shmget;
+extern struct syscall_entry entry_shmat;
+extern struct syscall_entry entry_shmctl;
+extern struct syscall_entry entry_dup;
+extern struct syscall_entry entry_dup2;
+extern struct syscall_entry entry_pause;
+extern struct syscall_entry entry_nanosleep;
+extern struct syscall_entry entry_getitimer;
+extern struct syscall_entry entry_alarm;
+extern struct syscall_entry entry_setitimer;
+extern struct syscall_entry entry_getpid;
+extern struct syscall_entry entry_sendfile;
+extern struct syscall_entry entry_socket;
+extern struct syscall_entry entry_connect;
+extern struct syscall_entry entry_accept;
+extern struct syscall_entry entry_sendto;
+extern struct syscall_entry entry_recvfrom;
+extern struct syscall_entry entry_sendmsg;
+extern struct syscall_entry entry_recvmsg;
+extern struct syscall_entry entry_shutdown;
+extern struct syscall_entry entry_bind;
+extern struct syscall_entry entry_listen;
+extern struct syscall_entry entry_getsockname;
+extern struct syscall_entry entry_getpeername;
+extern struct syscall_entry entry_socketpair;
+extern struct syscall_entry entry_setsockopt;
+extern struct syscall_entry entry_getsockopt;
+extern struct syscall_entry entry_wait4;
+extern struct syscall_entry entry_kill;
+extern struct syscall_entry entry_uname;
+extern struct syscall_entry entry_semget;
+extern struct syscall_entry entry_semop;
+extern struct syscall_entry entry_semctl;
+extern struct syscall_entry entry_shmdt;
+extern struct syscall_entry entry_msgget;
+extern struct syscall_entry entry_msgsnd;
+extern struct syscall_entry entry_msgrcv;
+extern struct syscall_entry entry_msgctl;
+extern struct syscall_entry entry_fcntl;
+extern struct syscall_entry entry_flock;
+extern struct syscall_entry entry_fsync;
+extern struct syscall_entry entry_fdatasync;
+extern struct syscall_entry entry_truncate;
+extern struct syscall_entry entry_ftruncate;
+extern struct syscall_entry entry_getdents;
+extern struct syscall_entry entry_getcwd;
+extern struct syscall_entry entry_chdir;
+extern struct syscall_entry entry_fchdir;
+extern struct syscall_entry entry_rename;
+extern struct syscall_entry entry_mkdir;
+extern struct syscall_entry entry_rmdir;
+extern struct syscall_entry entry_creat;
+extern struct syscall_entry entry_link;
+extern struct syscall_entry entry_unlink;
+extern struct syscall_entry entry_symlink;
+extern struct syscall_entry entry_readlink;
+extern struct syscall_entry entry_chmod;
+extern struct syscall_entry entry_fchmod;
+extern struct syscall_entry entry_chown;
+extern struct syscall_entry entry_fchown;
+extern struct syscall_entry entry_lchown;
+extern struct syscall_entry entry_umask;
+extern struct syscall_entry entry_gettimeofday;
+extern struct syscall_entry entry_getrlimit;
+extern struct syscall_entry entry_getrusage;
+extern struct syscall_entry entry_sysinfo;
+extern struct syscall_entry entry_times;
+extern struct syscall_entry entry_ptrace;
+extern struct syscall_entry entry_getuid;
+extern struct syscall_entry entry_syslog;
+extern struct syscall_entry entry_getgid;
+extern struct syscall_entry entry_setuid;
+extern struct syscall_entry entry_setgid;
+extern struct syscall_entry entry_geteuid;
+extern struct syscall_entry entry_getegid;
+extern struct syscall_entry entry_setpgid;
+extern struct syscall_entry entry_getppid;
+extern struct syscall_entry entry_getpgrp;
+extern struct syscall_entry entry_setsid;
+extern struct syscall_entry entry_setreuid;
+extern struct syscall_entry entry_setregid;
+extern struct syscall_entry entry_getgroups;
+extern struct syscall_entry entry_setgroups;
+extern struct syscall_entry entry_setresuid;
+extern struct syscall_entry entry_getresuid;
+extern struct syscall_entry entry_setresgid;
+extern struct syscall_entry entry_getresgid;
+extern struct syscall_entry entry_getpgid;
+extern struct syscall_entry entry_setfsuid;
+extern struct syscall_entry entry_setfsgid;
+extern struct syscall_entry entry_getsid;
+extern struct syscall_entry entry_capget;
+extern struct syscall_entry entry_capset;
+extern struct syscall_entry entry_rt_sigpending;
+extern struct syscall_entry entry_rt_sigtimedwait;
+extern struct syscall_entry entry_rt_sigqueueinfo;
+extern struct syscall_entry entry_rt_sigsuspend;
+extern struct syscall_entry entry_sigaltstack;
+extern struct syscall_entry entry_utime;
+extern struct syscall_entry entry_mknod;
+extern struct syscall_entry entry_personality;
+extern struct syscall_entry entry_ustat;
+extern struct syscall_entry entry_statfs;
+extern struct syscall_entry entry_fstatfs;
+extern struct syscall_entry entry_sysfs;
+extern struct syscall_entry entry_getpriority;
+extern struct syscall_entry entry_setpriority;
+extern struct syscall_entry entry_sched_setparam;
+extern struct syscall_entry entry_sched_getparam;
+extern struct syscall_entry entry_sched_setscheduler;
+extern struct syscall_entry entry_sched_getscheduler;
+extern struct syscall_entry entry_sched_get_priority_max;
+extern struct syscall_entry entry_sched_get_priority_min;
+extern struct syscall_entry entry_sched_rr_get_interval;
+extern struct syscall_entry entry_mlock;
+extern struct syscall_entry entry_munlock;
+extern struct syscall_entry entry_mlockall;
+extern struct syscall_entry entry_munlockall;
+extern struct syscall_entry entry_vhangup;
+extern struct syscall_entry entry_modify_ldt;
+extern struct syscall_entry entry_pivot_root;
+extern struct syscall_entry entry_prctl;
+extern struct syscall_entry entry_adjtimex;
+extern struct syscall_entry entry_setrlimit;
+extern struct syscall_entry entry_chroot;
+extern struct syscall_entry entry_sync;
+extern struct syscall_entry entry_acct;
+extern struct syscall_entry entry_settimeofday;
+extern struct syscall_entry entry_mount;
+extern struct syscall_entry entry_umount2;
+extern struct syscall_entry entry_swapon;
+extern struct syscall_entry entry_swapoff;
+extern struct syscall_entry entry_reboot;
+extern struct syscall_entry entry_sethostname;
+extern struct syscall_entry entry_setdomainname;
+extern struct syscall_entry entry_iopl;
+extern struct syscall_entry entry_ioperm;
+extern struct syscall_entry entry_init_module;
+extern struct syscall_entry entry_delete_module;
+extern struct syscall_entry entry_quotactl;
+extern struct syscall_entry entry_gettid;
+extern struct syscall_entry entry_readahead;
+extern struct syscall_entry entry_setxattr;
+extern struct syscall_entry entry_lsetxattr;
+extern struct syscall_entry entry_fsetxattr;
+extern struct syscall_entry entry_getxattr;
+extern struct syscall_entry entry_lgetxattr;
+extern struct syscall_entry entry_fgetxattr;
+extern struct syscall_entry entry_listxattr;
+extern struct syscall_entry entry_llistxattr;
+extern struct syscall_entry entry_flistxattr;
+extern struct syscall_entry entry_removexattr;
+extern struct syscall_entry entry_lremovexattr;
+extern struct syscall_entry entry_fremovexattr;
+extern struct syscall_entry entry_tkill;
+extern struct syscall_entry entry_time;
+extern struct syscall_entry entry_futex;
+extern struct syscall_entry entry_sched_setaffinity;
+extern struct syscall_entry entry_sched_getaffinity;
+extern struct syscall_entry entry_io_setup;
+extern struct syscall_entry entry_io_destroy;
+extern struct syscall_entry entry_io_getevents;
+extern struct syscall_entry entry_io_submit;
+extern struct syscall_entry entry_io_cancel;
+extern struct syscall_entry entry_epoll_create;
+extern struct syscall_entry entry_remap_file_pages;
+extern struct syscall_entry entry_getdents64;
+extern struct syscall_entry entry_restart_syscall;
+extern struct syscall_entry entry_semtimedop;
+extern struct syscall_entry entry_fadvise64;
+extern struct syscall_entry entry_timer_create;
+extern struct syscall_entry entry_timer_settime;
+extern struct syscall_entry entry_timer_gettime;
+extern struct syscall_entry entry_timer_getoverrun;
+extern struct syscall_entry entry_timer_delete;
+extern struct syscall_entry entry_clock_settime;
+extern struct syscall_entry entry_clock_gettime;
+extern struct syscall_entry entry_clock_getres;
+extern struct syscall_entry entry_clock_nanosleep;
+extern struct syscall_entry entry_epoll_wait;
+extern struct syscall_entry entry_epoll_ctl;
+extern struct syscall_entry entry_tgkill;
+extern struct syscall_entry entry_utimes;
+extern struct syscall_entry entry_mbind;
+extern struct syscall_entry entry_set_mempolicy;
+extern struct syscall_entry entry_get_mempolicy;
+extern struct syscall_entry entry_mq_open;
+extern struct syscall_entry entry_mq_unlink;
+extern struct syscall_entry entry_mq_timedsend;
+extern struct syscall_entry entry_mq_timedreceive;
+extern struct syscall_entry entry_mq_notify;
+extern struct syscall_entry entry_mq_getsetattr;
+extern struct syscall_entry entry_kexec_load;
+extern struct syscall_entry entry_waitid;
+extern struct syscall_entry entry_add_key;
+extern struct syscall_entry entry_request_key;
+extern struct syscall_entry entry_keyctl;
+extern struct syscall_entry entry_ioprio_set;
+extern struct syscall_entry entry_ioprio_get;
+extern struct syscall_entry entry_inotify_init;
+extern struct syscall_entry entry_inotify_add_watch;
+extern struct syscall_entry entry_inotify_rm_watch;
+extern struct syscall_entry entry_migrate_pages;
+extern struct syscall_entry entry_openat;
+extern struct syscall_entry entry_mkdirat;
+extern struct syscall_entry entry_mknodat;
+extern struct syscall_entry entry_fchownat;
+extern struct syscall_entry entry_futimesat;
+extern struct syscall_entry entry_newfstatat;
+extern struct syscall_entry entry_unlinkat;
+extern struct syscall_entry entry_renameat;
+extern struct syscall_entry entry_linkat;
+extern struct syscall_entry entry_symlinkat;
+extern struct syscall_entry entry_readlinkat;
+extern struct syscall_entry entry_fchmodat;
+extern struct syscall_entry entry_faccessat;
+extern struct syscall_entry entry_pselect6;
+extern struct syscall_entry entry_ppoll;
+extern struct syscall_entry entry_unshare;
+extern struct syscall_entry entry_set_robust_list;
+extern struct syscall_entry entry_get_robust_list;
+extern struct syscall_entry entry_splice;
+extern struct syscall_entry entry_tee;
+extern struct syscall_entry entry_sync_file_range;
+extern struct syscall_entry entry_vmsplice;
+extern struct syscall_entry entry_move_pages;
+extern struct syscall_entry entry_utimensat;
+extern struct syscall_entry entry_epoll_pwait;
+extern struct syscall_entry entry_signalfd;
+extern struct syscall_entry entry_timerfd_create;
+extern struct syscall_entry entry_eventfd;
+extern struct syscall_entry entry_fallocate;
+extern struct syscall_entry entry_timerfd_settime;
+extern struct syscall_entry entry_timerfd_gettime;
+extern struct syscall_entry entry_accept4;
+extern struct syscall_entry entry_signalfd4;
+extern struct syscall_entry entry_eventfd2;
+extern struct syscall_entry entry_epoll_create1;
+extern struct syscall_entry entry_dup3;
+extern struct syscall_entry entry_pipe2;
+extern struct syscall_entry entry_inotify_init1;
+extern struct syscall_entry entry_preadv;
+extern struct syscall_entry entry_pwritev;
+extern struct syscall_entry entry_rt_tgsigqueueinfo;
+extern struct syscall_entry entry_perf_event_open;
+extern struct syscall_entry entry_recvmmsg;
+extern struct syscall_entry entry_fanotify_init;
+extern struct syscall_entry entry_fanotify_mark;
+extern struct syscall_entry entry_prlimit64;
+extern struct syscall_entry entry_name_to_handle_at;
+extern struct syscall_entry entry_open_by_handle_at;
+extern struct syscall_entry entry_clock_adjtime;
+extern struct syscall_entry entry_syncfs;
+extern struct syscall_entry entry_sendmmsg;
+extern struct syscall_entry entry_setns;
+extern struct syscall_entry entry_getcpu;
+extern struct syscall_entry entry_process_vm_readv;
+extern struct syscall_entry entry_process_vm_writev;
+extern struct syscall_entry entry_kcmp;
+extern struct syscall_entry entry_finit_module;
+extern struct syscall_entry entry_sched_setattr;
+extern struct syscall_entry entry_sched_getattr;
+extern struct syscall_entry entry_renameat2;
+extern struct syscall_entry entry_seccomp;
+extern struct syscall_entry entry_getrandom;
+extern struct syscall_entry entry_memfd_create;
+extern struct syscall_entry entry_kexec_file_load;
+extern struct syscall_entry entry_bpf;
+extern struct syscall_entry entry_userfaultfd;
+extern struct syscall_entry entry_membarrier;
+extern struct syscall_entry entry_mlock2;
+extern struct syscall_entry entry_copy_file_range;
+extern struct syscall_entry entry_preadv2;
+extern struct syscall_entry entry_pwritev2;
+extern struct syscall_entry entry_pkey_mprotect;
+extern struct syscall_entry entry_pkey_alloc;
+extern struct syscall_entry entry_pkey_free;
+extern struct syscall_entry entry_statx;
+extern struct syscall_entry entry_io_pgetevents;
+extern struct syscall_entry entry_rseq;
+extern struct syscall_entry entry_pidfd_send_signal;
+extern struct syscall_entry entry_io_uring_setup;
+extern struct syscall_entry entry_io_uring_enter;
+extern struct syscall_entry entry_io_uring_register;
+extern struct syscall_entry entry_open_tree;
+extern struct syscall_entry entry_move_mount;
+extern struct syscall_entry entry_fsopen;
+extern struct syscall_entry entry_fsconfig;
+extern struct syscall_entry entry_fsmount;
+extern struct syscall_entry entry_fspick;
+extern struct syscall_entry entry_pidfd_open;
+extern struct syscall_entry entry_close_range;
+extern struct syscall_entry entry_openat2;
+extern struct syscall_entry entry_pidfd_getfd;
+extern struct syscall_entry entry_faccessat2;
+extern struct syscall_entry entry_process_madvise;
+extern struct syscall_entry entry_epoll_pwait2;
+extern struct syscall_entry entry_mount_setattr;
+extern struct syscall_entry entry_quotactl_fd;
+extern struct syscall_entry entry_landlock_create_ruleset;
+extern struct syscall_entry entry_landlock_add_rule;
+extern struct syscall_entry entry_landlock_restrict_self;
+extern struct syscall_entry entry_memfd_secret;
+extern struct syscall_entry entry_process_mrelease;
+extern struct syscall_entry entry_futex_waitv;
+extern struct syscall_entry entry_set_mempolicy_home_node;
 
 #endif
@@ -1,5 +1,3 @@
-
-
 /**
  * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
  *
@@ -15,16 +13,1026 @@
  * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  **/
 
+/* Generated by tools/entrygen/entrygen.py, edit tools/entrygen/linux.annotations instead. */
+
 #ifndef LINUX_SYSCALL_TABLE_H
 #define LINUX_SYSCALL_TABLE_H
 
 #include "syscall_list.h"
 #include "syscall_table.h"
 
+/* Entries in syscall number order, syscalls the libc headers
+  don't know about are left out so the table stays dense. */
+static struct syscall_entry *const linux_entries[] = {
+
+#ifdef SYS_read
+    &entry_read,
+#endif
+#ifdef SYS_write
+    &entry_write,
+#endif
+#ifdef SYS_open
+    &entry_open,
+#endif
+#ifdef SYS_close
+    &entry_close,
+#endif
+#ifdef SYS_stat
+    &entry_stat,
+#endif
+#ifdef SYS_fstat
+    &entry_fstat,
+#endif
+#ifdef SYS_lstat
+    &entry_lstat,
+#endif
+#ifdef SYS_poll
+    &entry_poll,
+#endif
+#ifdef SYS_lseek
+    &entry_lseek,
+#endif
+#ifdef SYS_mmap
+    &entry_mmap,
+#endif
+#ifdef SYS_mprotect
+    &entry_mprotect,
+#endif
+#ifdef SYS_munmap
+    &entry_munmap,
+#endif
+#ifdef SYS_brk
+    &entry_brk,
+#endif
+#ifdef SYS_rt_sigaction
+    &entry_rt_sigaction,
+#endif
+#ifdef SYS_rt_sigprocmask
+    &entry_rt_sigprocmask,
+#endif
+#ifdef SYS_ioctl
+    &entry_ioctl,
+#endif
+#ifdef SYS_pread64
+    &entry_pread64,
+#endif
+#ifdef SYS_pwrite64
+    &entry_pwrite64,
+#endif
+#ifdef SYS_readv
+    &entry_readv,
+#endif
+#ifdef SYS_writev
+    &entry_writev,
+#endif
+#ifdef SYS_access
+    &entry_access,
+#endif
+#ifdef SYS_pipe
+    &entry_pipe,
+#endif
+#ifdef SYS_select
+    &entry_select,
+#endif
+#ifdef SYS_sched_yield
+    &entry_sched_yield,
+#endif
+#ifdef SYS_mremap
+    &entry_mremap,
+#endif
+#ifdef SYS_msync
+    &entry_msync,
+#endif
+#ifdef SYS_mincore
+    &entry_mincore,
+#endif
+#ifdef SYS_madvise
+    &entry_madvise,
+#endif
+#ifdef SYS_shmget
+    &entry_shmget,
+#endif
+#ifdef SYS_shmat
+    &entry_shmat,
+#endif
+#ifdef SYS_shmctl
+    &entry_shmctl,
+#endif
+#ifdef SYS_dup
+    &entry_dup,
+#endif
+#ifdef SYS_dup2
+    &entry_dup2,
+#endif
+#ifdef SYS_pause
+    &entry_pause,
+#endif
+#ifdef SYS_nanosleep
+    &entry_nanosleep,
+#endif
+#ifdef SYS_getitimer
+    &entry_getitimer,
+#endif
+#ifdef SYS_alarm
+    &entry_alarm,
+#endif
+#ifdef SYS_setitimer
+    &entry_setitimer,
+#endif
+#ifdef SYS_getpid
+    &entry_getpid,
+#endif
+#ifdef SYS_sendfile
+    &entry_sendfile,
+#endif
+#ifdef SYS_socket
+    &entry_socket,
+#endif
+#ifdef SYS_connect
+    &entry_connect,
+#endif
+#ifdef SYS_accept
+    &entry_accept,
+#endif
+#ifdef SYS_sendto
+    &entry_sendto,
+#endif
+#ifdef SYS_recvfrom
+    &entry_recvfrom,
+#endif
+#ifdef SYS_sendmsg
+    &entry_sendmsg,
+#endif
+#ifdef SYS_recvmsg
+    &entry_recvmsg,
+#endif
+#ifdef SYS_shutdown
+    &entry_shutdown,
+#endif
+#ifdef SYS_bind
+    &entry_bind,
+#endif
+#ifdef SYS_listen
+    &entry_listen,
+#endif
+#ifdef SYS_getsockname
+    &entry_getsockname,
+#endif
+#ifdef SYS_getpeername
+    &entry_getpeername,
+#endif
+#ifdef SYS_socketpair
+    &entry_socketpair,
+#endif
+#ifdef SYS_setsockopt
+    &entry_setsockopt,
+#endif
+#ifdef SYS_getsockopt
+    &entry_getsockopt,
+#endif
+#ifdef SYS_wait4
+    &entry_wait4,
+#endif
+#ifdef SYS_kill
+    &entry_kill,
+#endif
+#ifdef SYS_uname
+    &entry_uname,
+#endif
+#ifdef SYS_semget
+    &entry_semget,
+#endif
+#ifdef SYS_semop
+    &entry_semop,
+#endif
+#ifdef SYS_semctl
+    &entry_semctl,
+#endif
+#ifdef SYS_shmdt
+    &entry_shmdt,
+#endif
+#ifdef SYS_msgget
+    &entry_msgget,
+#endif
+#ifdef SYS_msgsnd
+    &entry_msgsnd,
+#endif
+#ifdef SYS_msgrcv
+    &entry_msgrcv,
+#endif
+#ifdef SYS_msgctl
+    &entry_msgctl,
+#endif
+#ifdef SYS_fcntl
+    &entry_fcntl,
+#endif
+#ifdef SYS_flock
+    &entry_flock,
+#endif
+#ifdef SYS_fsync
+    &entry_fsync,
+#endif
+#ifdef SYS_fdatasync
+    &entry_fdatasync,
+#endif
+#ifdef SYS_truncate
+    &entry_truncate,
+#endif
+#ifdef SYS_ftruncate
+    &entry_ftruncate,
+#endif
+#ifdef SYS_getdents
+    &entry_getdents,
+#endif
+#ifdef SYS_getcwd
+    &entry_getcwd,
+#endif
+#ifdef SYS_chdir
+    &entry_chdir,
+#endif
+#ifdef SYS_fchdir
+    &entry_fchdir,
+#endif
+#ifdef SYS_rename
+    &entry_rename,
+#endif
+#ifdef SYS_mkdir
+    &entry_mkdir,
+#endif
+#ifdef SYS_rmdir
+    &entry_rmdir,
+#endif
+#ifdef SYS_creat
+    &entry_creat,
+#endif
+#ifdef SYS_link
+    &entry_link,
+#endif
+#ifdef SYS_unlink
+    &entry_unlink,
+#endif
+#ifdef SYS_symlink
+    &entry_symlink,
+#endif
+#ifdef SYS_readlink
+    &entry_readlink,
+#endif
+#ifdef SYS_chmod
+    &entry_chmod,
+#endif
+#ifdef SYS_fchmod
+    &entry_fchmod,
+#endif
+#ifdef SYS_chown
+    &entry_chown,
+#endif
+#ifdef SYS_fchown
+    &entry_fchown,
+#endif
+#ifdef SYS_lchown
+    &entry_lchown,
+#endif
+#ifdef SYS_umask
+    &entry_umask,
+#endif
+#ifdef SYS_gettimeofday
+    &entry_gettimeofday,
+#endif
+#ifdef SYS_getrlimit
+    &entry_getrlimit,
+#endif
+#ifdef SYS_getrusage
+    &entry_getrusage,
+#endif
+#ifdef SYS_sysinfo
+    &entry_sysinfo,
+#endif
+#ifdef SYS_times
+    &entry_times,
+#endif
+#ifdef SYS_ptrace
+    &entry_ptrace,
+#endif
+#ifdef SYS_getuid
+    &entry_getuid,
+#endif
+#ifdef SYS_syslog
+    &entry_syslog,
+#endif
+#ifdef SYS_getgid
+    &entry_getgid,
+#endif
+#ifdef SYS_setuid
+    &entry_setuid,
+#endif
+#ifdef SYS_setgid
+    &entry_setgid,
+#endif
+#ifdef SYS_geteuid
+    &entry_geteuid,
+#endif
+#ifdef SYS_getegid
+    &entry_getegid,
+#endif
+#ifdef SYS_setpgid
+    &entry_setpgid,
+#endif
+#ifdef SYS_getppid
+    &entry_getppid,
+#endif
+#ifdef SYS_getpgrp
+    &entry_getpgrp,
+#endif
+#ifdef SYS_setsid
+    &entry_setsid,
+#endif
+#ifdef SYS_setreuid
+    &entry_setreuid,
+#endif
+#ifdef SYS_setregid
+    &entry_setregid,
+#endif
+#ifdef SYS_getgroups
+    &entry_getgroups,
+#endif
+#ifdef SYS_setgroups
+    &entry_setgroups,
+#endif
+#ifdef SYS_setresuid
+    &entry_setresuid,
+#endif
+#ifdef SYS_getresuid
+    &entry_getresuid,
+#endif
+#ifdef SYS_setresgid
+    &entry_setresgid,
+#endif
+#ifdef SYS_getresgid
+    &entry_getresgid,
+#endif
+#ifdef SYS_getpgid
+    &entry_getpgid,
+#endif
+#ifdef SYS_setfsuid
+    &entry_setfsuid,
+#endif
+#ifdef SYS_setfsgid
+    &entry_setfsgid,
+#endif
+#ifdef SYS_getsid
+    &entry_getsid,
+#endif
+#ifdef SYS_capget
+    &entry_capget,
+#endif
+#ifdef SYS_capset
+    &entry_capset,
+#endif
+#ifdef SYS_rt_sigpending
+    &entry_rt_sigpending,
+#endif
+#ifdef SYS_rt_sigtimedwait
+    &entry_rt_sigtimedwait,
+#endif
+#ifdef SYS_rt_sigqueueinfo
+    &entry_rt_sigqueueinfo,
+#endif
+#ifdef SYS_rt_sigsuspend
+    &entry_rt_sigsuspend,
+#endif
+#ifdef SYS_sigaltstack
+    &entry_sigaltstack,
+#endif
+#ifdef SYS_utime
+    &entry_utime,
+#endif
+#ifdef SYS_mknod
+    &entry_mknod,
+#endif
+#ifdef SYS_personality
+    &entry_personality,
+#endif
+#ifdef SYS_ustat
+    &entry_ustat,
+#endif
+#ifdef SYS_statfs
+    &entry_statfs,
+#endif
+#ifdef SYS_fstatfs
+    &entry_fstatfs,
+#endif
+#ifdef SYS_sysfs
+    &entry_sysfs,
+#endif
+#ifdef SYS_getpriority
+    &entry_getpriority,
+#endif
+#ifdef SYS_setpriority
+    &entry_setpriority,
+#endif
+#ifdef SYS_sched_setparam
+    &entry_sched_setparam,
+#endif
+#ifdef SYS_sched_getparam
+    &entry_sched_getparam,
+#endif
+#ifdef SYS_sched_setscheduler
+    &entry_sched_setscheduler,
+#endif
+#ifdef SYS_sched_getscheduler
+    &entry_sched_getscheduler,
+#endif
+#ifdef SYS_sched_get_priority_max
+    &entry_sched_get_priority_max,
+#endif
+#ifdef SYS_sched_get_priority_min
+    &entry_sched_get_priority_min,
+#endif
+#ifdef SYS_sched_rr_get_interval
+    &entry_sched_rr_get_interval,
+#endif
+#ifdef SYS_mlock
+    &entry_mlock,
+#endif
+#ifdef SYS_munlock
+    &entry_munlock,
+#endif
+#ifdef SYS_mlockall
+    &entry_mlockall,
+#endif
+#ifdef SYS_munlockall
+    &entry_munlockall,
+#endif
+#ifdef SYS_vhangup
+    &entry_vhangup,
+#endif
+#ifdef SYS_modify_ldt
+    &entry_modify_ldt,
+#endif
+#ifdef SYS_pivot_root
+    &entry_pivot_root,
+#endif
+#ifdef SYS_prctl
+    &entry_prctl,
+#endif
+#ifdef SYS_adjtimex
+    &entry_adjtimex,
+#endif
+#ifdef SYS_setrlimit
+    &entry_setrlimit,
+#endif
+#ifdef SYS_chroot
+    &entry_chroot,
+#endif
+#ifdef SYS_sync
+    &entry_sync,
+#endif
+#ifdef SYS_acct
+    &entry_acct,
+#endif
+#ifdef SYS_settimeofday
+    &entry_settimeofday,
+#endif
+#ifdef SYS_mount
+    &entry_mount,
+#endif
+#ifdef SYS_umount2
+    &entry_umount2,
+#endif
+#ifdef SYS_swapon
+    &entry_swapon,
+#endif
+#ifdef SYS_swapoff
+    &entry_swapoff,
+#endif
+#ifdef SYS_reboot
+    &entry_reboot,
+#endif
+#ifdef SYS_sethostname
+    &entry_sethostname,
+#endif
+#ifdef SYS_setdomainname
+    &entry_setdomainname,
+#endif
+#ifdef SYS_iopl
+    &entry_iopl,
+#endif
+#ifdef SYS_ioperm
+    &entry_ioperm,
+#endif
+#ifdef SYS_init_module
+    &entry_init_module,
+#endif
+#ifdef SYS_delete_module
+    &entry_delete_module,
+#endif
+#ifdef SYS_quotactl
+    &entry_quotactl,
+#endif
+#ifdef SYS_gettid
+    &entry_gettid,
+#endif
+#ifdef SYS_readahead
+    &entry_readahead,
+#endif
+#ifdef SYS_setxattr
+    &entry_setxattr,
+#endif
+#ifdef SYS_lsetxattr
+    &entry_lsetxattr,
+#endif
+#ifdef SYS_fsetxattr
+    &entry_fsetxattr,
+#endif
+#ifdef SYS_getxattr
+    &entry_getxattr,
+#endif
+#ifdef SYS_lgetxattr
+    &entry_lgetxattr,
+#endif
+#ifdef SYS_fgetxattr
+    &entry_fgetxattr,
+#endif
+#ifdef SYS_listxattr
+    &entry_listxattr,
+#endif
+#ifdef SYS_llistxattr
+    &entry_llistxattr,
+#endif
+#ifdef SYS_flistxattr
+    &entry_flistxattr,
+#endif
+#ifdef SYS_removexattr
+    &entry_removexattr,
+#endif
+#ifdef SYS_lremovexattr
+    &entry_lremovexattr,
+#endif
+#ifdef SYS_fremovexattr
+    &entry_fremovexattr,
+#endif
+#ifdef SYS_tkill
+    &entry_tkill,
+#endif
+#ifdef SYS_time
+    &entry_time,
+#endif
+#ifdef SYS_futex
+    &entry_futex,
+#endif
+#ifdef SYS_sched_setaffinity
+    &entry_sched_setaffinity,
+#endif
+#ifdef SYS_sched_getaffinity
+    &entry_sched_getaffinity,
+#endif
+#ifdef SYS_io_setup
+    &entry_io_setup,
+#endif
+#ifdef SYS_io_destroy
+    &entry_io_destroy,
+#endif
+#ifdef SYS_io_getevents
+    &entry_io_getevents,
+#endif
+#ifdef SYS_io_submit
+    &entry_io_submit,
+#endif
+#ifdef SYS_io_cancel
+    &entry_io_cancel,
+#endif
+#ifdef SYS_epoll_create
+    &entry_epoll_create,
+#endif
+#ifdef SYS_remap_file_pages
+    &entry_remap_file_pages,
+#endif
+#ifdef SYS_getdents64
+    &entry_getdents64,
+#endif
+#ifdef SYS_restart_syscall
+    &entry_restart_syscall,
+#endif
+#ifdef SYS_semtimedop
+    &entry_semtimedop,
+#endif
+#ifdef SYS_fadvise64
+    &entry_fadvise64,
+#endif
+#ifdef SYS_timer_create
+    &entry_timer_create,
+#endif
+#ifdef SYS_timer_settime
+    &entry_timer_settime,
+#endif
+#ifdef SYS_timer_gettime
+    &entry_timer_gettime,
+#endif
+#ifdef SYS_timer_getoverrun
+    &entry_timer_getoverrun,
+#endif
+#ifdef SYS_timer_delete
+    &entry_timer_delete,
+#endif
+#ifdef SYS_clock_settime
+    &entry_clock_settime,
+#endif
+#ifdef SYS_clock_gettime
+    &entry_clock_gettime,
+#endif
+#ifdef SYS_clock_getres
+    &entry_clock_getres,
+#endif
+#ifdef SYS_clock_nanosleep
+    &entry_clock_nanosleep,
+#endif
+#ifdef SYS_epoll_wait
+    &entry_epoll_wait,
+#endif
+#ifdef SYS_epoll_ctl
+    &entry_epoll_ctl,
+#endif
+#ifdef SYS_tgkill
+    &entry_tgkill,
+#endif
+#ifdef SYS_utimes
+    &entry_utimes,
+#endif
+#ifdef SYS_mbind
+    &entry_mbind,
+#endif
+#ifdef SYS_set_mempolicy
+    &entry_set_mempolicy,
+#endif
+#ifdef SYS_get_mempolicy
+    &entry_get_mempolicy,
+#endif
+#ifdef SYS_mq_open
+    &entry_mq_open,
+#endif
+#ifdef SYS_mq_unlink
+    &entry_mq_unlink,
+#endif
+#ifdef SYS_mq_timedsend
+    &entry_mq_timedsend,
+#endif
+#ifdef SYS_mq_timedreceive
+    &entry_mq_timedreceive,
+#endif
+#ifdef SYS_mq_notify
+    &entry_mq_notify,
+#endif
+#ifdef SYS_mq_getsetattr
+    &entry_mq_getsetattr,
+#endif
+#ifdef SYS_kexec_load
+    &entry_kexec_load,
+#endif
+#ifdef SYS_waitid
+    &entry_waitid,
+#endif
+#ifdef SYS_add_key
+    &entry_add_key,
+#endif
+#ifdef SYS_request_key
+    &entry_request_key,
+#endif
+#ifdef SYS_keyctl
+    &entry_keyctl,
+#endif
+#ifdef SYS_ioprio_set
+    &entry_ioprio_set,
+#endif
+#ifdef SYS_ioprio_get
+    &entry_ioprio_get,
+#endif
+#ifdef SYS_inotify_init
+    &entry_inotify_init,
+#endif
+#ifdef SYS_inotify_add_watch
+    &entry_inotify_add_watch,
+#endif
+#ifdef SYS_inotify_rm_watch
+    &entry_inotify_rm_watch,
+#endif
+#ifdef SYS_migrate_pages
+    &entry_migrate_pages,
+#endif
+#ifdef SYS_openat
+    &entry_openat,
+#endif
+#ifdef SYS_mkdirat
+    &entry_mkdirat,
+#endif
+#ifdef SYS_mknodat
+    &entry_mknodat,
+#endif
+#ifdef SYS_fchownat
+    &entry_fchownat,
+#endif
+#ifdef SYS_futimesat
+    &entry_futimesat,
+#endif
+#ifdef SYS_newfstatat
+    &entry_newfstatat,
+#endif
+#ifdef SYS_unlinkat
+    &entry_unlinkat,
+#endif
+#ifdef SYS_renameat
+    &entry_renameat,
+#endif
+#ifdef SYS_linkat
+    &entry_linkat,
+#endif
+#ifdef SYS_symlinkat
+    &entry_symlinkat,
+#endif
+#ifdef SYS_readlinkat
+    &entry_readlinkat,
+#endif
+#ifdef SYS_fchmodat
+    &entry_fchmodat,
+#endif
+#ifdef SYS_faccessat
+    &entry_faccessat,
+#endif
+#ifdef SYS_pselect6
+    &entry_pselect6,
+#endif
+#ifdef SYS_ppoll
+    &entry_ppoll,
+#endif
+#ifdef SYS_unshare
+    &entry_unshare,
+#endif
+#ifdef SYS_set_robust_list
+    &entry_set_robust_list,
+#endif
+#ifdef SYS_get_robust_list
+    &entry_get_robust_list,
+#endif
+#ifdef SYS_splice
+    &entry_splice,
+#endif
+#ifdef SYS_tee
+    &entry_tee,
+#endif
+#ifdef SYS_sync_file_range
+    &entry_sync_file_range,
+#endif
+#ifdef SYS_vmsplice
+    &entry_vmsplice,
+#endif
+#ifdef SYS_move_pages
+    &entry_move_pages,
+#endif
+#ifdef SYS_utimensat
+    &entry_utimensat,
+#endif
+#ifdef SYS_epoll_pwait
+    &entry_epoll_pwait,
+#endif
+#ifdef SYS_signalfd
+    &entry_signalfd,
+#endif
+#ifdef SYS_timerfd_create
+    &entry_timerfd_create,
+#endif
+#ifdef SYS_eventfd
+    &entry_eventfd,
+#endif
+#ifdef SYS_fallocate
+    &entry_fallocate,
+#endif
+#ifdef SYS_timerfd_settime
+    &entry_timerfd_settime,
+#endif
+#ifdef SYS_timerfd_gettime
+    &entry_timerfd_gettime,
+#endif
+#ifdef SYS_accept4
+    &entry_accept4,
+#endif
+#ifdef SYS_signalfd4
+    &entry_signalfd4,
+#endif
+#ifdef SYS_eventfd2
+    &entry_eventfd2,
+#endif
+#ifdef SYS_epoll_create1
+    &entry_epoll_create1,
+#endif
+#ifdef SYS_dup3
+    &entry_dup3,
+#endif
+#ifdef SYS_pipe2
+    &entry_pipe2,
+#endif
+#ifdef SYS_inotify_init1
+    &entry_inotify_init1,
+#endif
+#ifdef SYS_preadv
+    &entry_preadv,
+#endif
+#ifdef SYS_pwritev
+    &entry_pwritev,
+#endif
+#ifdef SYS_rt_tgsigqueueinfo
+    &entry_rt_tgsigqueueinfo,
+#endif
+#ifdef SYS_perf_event_open
+    &entry_perf_event_open,
+#endif
+#ifdef SYS_recvmmsg
+    &entry_recvmmsg,
+#endif
+#ifdef SYS_fanotify_init
+    &entry_fanotify_init,
+#endif
+#ifdef SYS_fanotify_mark
+    &entry_fanotify_mark,
+#endif
+#ifdef SYS_prlimit64
+    &entry_prlimit64,
+#endif
+#ifdef SYS_name_to_handle_at
+    &entry_name_to_handle_at,
+#endif
+#ifdef SYS_open_by_handle_at
+    &entry_open_by_handle_at,
+#endif
+#ifdef SYS_clock_adjtime
+    &entry_clock_adjtime,
+#endif
+#ifdef SYS_syncfs
+    &entry_syncfs,
+#endif
+#ifdef SYS_sendmmsg
+    &entry_sendmmsg,
+#endif
+#ifdef SYS_setns
+    &entry_setns,
+#endif
+#ifdef SYS_getcpu
+    &entry_getcpu,
+#endif
+#ifdef SYS_process_vm_readv
+    &entry_process_vm_readv,
+#endif
+#ifdef SYS_process_vm_writev
+    &entry_process_vm_writev,
+#endif
+#ifdef SYS_kcmp
+    &entry_kcmp,
+#endif
+#ifdef SYS_finit_module
+    &entry_finit_module,
+#endif
+#ifdef SYS_sched_setattr
+    &entry_sched_setattr,
+#endif
+#ifdef SYS_sched_getattr
+    &entry_sched_getattr,
+#endif
+#ifdef SYS_renameat2
+    &entry_renameat2,
+#endif
+#ifdef SYS_seccomp
+    &entry_seccomp,
+#endif
+#ifdef SYS_getrandom
+    &entry_getrandom,
+#endif
+#ifdef SYS_memfd_create
+    &entry_memfd_create,
+#endif
+#ifdef SYS_kexec_file_load
+    &entry_kexec_file_load,
+#endif
+#ifdef SYS_bpf
+    &entry_bpf,
+#endif
+#ifdef SYS_userfaultfd
+    &entry_userfaultfd,
+#endif
+#ifdef SYS_membarrier
+    &entry_membarrier,
+#endif
+#ifdef SYS_mlock2
+    &entry_mlock2,
+#endif
+#ifdef SYS_copy_file_range
+    &entry_copy_file_range,
+#endif
+#ifdef SYS_preadv2
+    &entry_preadv2,
+#endif
+#ifdef SYS_pwritev2
+    &entry_pwritev2,
+#endif
+#ifdef SYS_pkey_mprotect
+    &entry_pkey_mprotect,
+#endif
+#ifdef SYS_pkey_alloc
+    &entry_pkey_alloc,
+#endif
+#ifdef SYS_pkey_free
+    &entry_pkey_free,
+#endif
+#ifdef SYS_statx
+    &entry_statx,
+#endif
+#ifdef SYS_io_pgetevents
+    &entry_io_pgetevents,
+#endif
+#ifdef SYS_rseq
+    &entry_rseq,
+#endif
+#ifdef SYS_pidfd_send_signal
+    &entry_pidfd_send_signal,
+#endif
+#ifdef SYS_io_uring_setup
+    &entry_io_uring_setup,
+#endif
+#ifdef SYS_io_uring_enter
+    &entry_io_uring_enter,
+#endif
+#ifdef SYS_io_uring_register
+    &entry_io_uring_register,
+#endif
+#ifdef SYS_open_tree
+    &entry_open_tree,
+#endif
+#ifdef SYS_move_mount
+    &entry_move_mount,
+#endif
+#ifdef SYS_fsopen
+    &entry_fsopen,
+#endif
+#ifdef SYS_fsconfig
+    &entry_fsconfig,
+#endif
+#ifdef SYS_fsmount
+    &entry_fsmount,
+#endif
+#ifdef SYS_fspick
+    &entry_fspick,
+#endif
+#ifdef SYS_pidfd_open
+    &entry_pidfd_open,
+#endif
+#ifdef SYS_close_range
+    &entry_close_range,
+#endif
+#ifdef SYS_openat2
+    &entry_openat2,
+#endif
+#ifdef SYS_pidfd_getfd
+    &entry_pidfd_getfd,
+#endif
+#ifdef SYS_faccessat2
+    &entry_faccessat2,
+#endif
+#ifdef SYS_process_madvise
+    &entry_process_madvise,
+#endif
+#ifdef SYS_epoll_pwait2
+    &entry_epoll_pwait2,
+#endif
+#ifdef SYS_mount_setattr
+    &entry_mount_setattr,
+#endif
+#ifdef SYS_quotactl_fd
+    &entry_quotactl_fd,
+#endif
+#ifdef SYS_landlock_create_ruleset
+    &entry_landlock_create_ruleset,
+#endif
+#ifdef SYS_landlock_add_rule
+    &entry_landlock_add_rule,
+#endif
+#ifdef SYS_landlock_restrict_self
+    &entry_landlock_restrict_self,
+#endif
+#ifdef SYS_memfd_secret
+    &entry_memfd_secret,
+#endif
+#ifdef SYS_process_mrelease
+    &entry_process_mrelease,
+#endif
+#ifdef SYS_futex_waitv
+    &entry_futex_waitv,
+#endif
+#ifdef SYS_set_mempolicy_home_node
+    &entry_set_mempolicy_home_node,
+#endif
+};
+
 struct syscall_table linux_syscall_table = {
 
-    .total_syscalls = 1,
-    .sys_entry[0] = &entry_read,
+    .total_syscalls = sizeof(linux_entries) / sizeof(linux_entries[0]),
+    .sys_entry = linux_entries
 };
 
 #endif
@@ -23,7 +23,10 @@ struct syscall_entry entry_accept = {
     .status = ON,
     .requires_root = NX_NO,
     .need_alarm = NX_NO,
-    .id = VPV_ID,
+    .ret_type = SOCKET,
+    .returns_resource = true,
+    .groups = SYSCALL_GROUP(GROUP_NET),
+    .ptr_args = ARG_PTR(SECOND_ARG),
 
     .arg_type_array[FIRST_ARG] = SOCKET,
     .get_arg_array[FIRST_ARG] = &generate_socket,
@@ -23,7 +23,8 @@ struct syscall_entry entry_getpeername = {
     .status = ON,
     .requires_root = NX_NO,
     .need_alarm = NX_NO,
-    .id = VPV_ID,
+    .groups = SYSCALL_GROUP(GROUP_NET),
+    .ptr_args = ARG_PTR(SECOND_ARG),
 
     .arg_type_array[FIRST_ARG] = SOCKET,
     .get_arg_array[FIRST_ARG] = &generate_socket,
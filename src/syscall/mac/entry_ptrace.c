@@ -25,7 +25,8 @@ struct syscall_entry entry_ptrace = {
     .status = ON,
     .requires_root = NX_YES,
     .need_alarm = NX_NO,
-    .id = VVPV_ID,
+    .groups = SYSCALL_GROUP(GROUP_PROC),
+    .ptr_args = ARG_PTR(THIRD_ARG),
 
     .arg_type_array[FIRST_ARG] = REQUEST,
     .get_arg_array[FIRST_ARG] = &generate_request,
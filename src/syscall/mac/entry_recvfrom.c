@@ -25,7 +25,9 @@ struct syscall_entry entry_recvfrom = {
     .status = ON,
     .requires_root = NX_NO,
     .need_alarm = NX_YES,
-    .id = VPVVPV_ID,
+    .timeout_us = 100000,
+    .groups = SYSCALL_GROUP(GROUP_NET),
+    .ptr_args = ARG_PTR(SECOND_ARG) | ARG_PTR(FIFTH_ARG),
 
     .arg_type_array[FIRST_ARG] = SOCKET,
     .get_arg_array[FIRST_ARG] = &generate_socket,
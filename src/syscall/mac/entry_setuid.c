@@ -25,7 +25,8 @@ struct syscall_entry entry_setuid = {
     .status = ON,
     .requires_root = NX_NO,
     .need_alarm = NX_NO,
-    .id = V_ID,
+    .groups = SYSCALL_GROUP(GROUP_PROC),
+    .ptr_args = 0,
 
     .arg_type_array[FIRST_ARG] = INT,
     .get_arg_array[FIRST_ARG] = &generate_int
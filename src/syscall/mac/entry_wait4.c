@@ -25,7 +25,8 @@ struct syscall_entry entry_wait4 = {
     .status = ON,
     .requires_root = NX_NO,
     .need_alarm = NX_NO,
-    .id = VPVP_ID,
+    .groups = SYSCALL_GROUP(GROUP_PROC),
+    .ptr_args = ARG_PTR(SECOND_ARG) | ARG_PTR(FOURTH_ARG),
 
     .arg_type_array[FIRST_ARG] = PID,
     .get_arg_array[FIRST_ARG] = &generate_pid,
@@ -21,29 +21,35 @@
 #include "syscall_list.h"
 #include "syscall_table.h"
 
+static struct syscall_entry *const mac_osx_entries[] = {
+
+    &entry_read,
+    &entry_write,
+    &entry_open,
+    &entry_close,
+    &entry_wait4,
+    &entry_link,
+    &entry_unlink,
+    &entry_chdir,
+    &entry_fchdir,
+    &entry_mknod,
+    &entry_getfsstat,
+    &entry_setuid,
+    &entry_ptrace,
+    &entry_recvmsg,
+    &entry_sendmsg,
+    &entry_recvfrom,
+    &entry_accept,
+    &entry_getpeername,
+    &entry_getsockname,
+    &entry_access,
+    &entry_chflags
+};
+
 struct syscall_table mac_osx_syscall_table = {
-    .total_syscalls = 21,
-    .sys_entry[0] = &entry_read,
-    .sys_entry[1] = &entry_write,
-    .sys_entry[2] = &entry_open,
-    .sys_entry[3] = &entry_close,
-    .sys_entry[4] = &entry_wait4,
-    .sys_entry[5] = &entry_link,
-    .sys_entry[6] = &entry_unlink,
-    .sys_entry[7] = &entry_chdir,
-    .sys_entry[8] = &entry_fchdir,
-    .sys_entry[9] = &entry_mknod,
-    .sys_entry[10] = &entry_getfsstat,
-    .sys_entry[11] = &entry_setuid,
-    .sys_entry[12] = &entry_ptrace,
-    .sys_entry[13] = &entry_recvmsg,
-    .sys_entry[14] = &entry_sendmsg,
-    .sys_entry[15] = &entry_recvfrom,
-    .sys_entry[16] = &entry_accept,
-    .sys_entry[17] = &entry_getpeername,
-    .sys_entry[18] = &entry_getsockname,
-    .sys_entry[19] = &entry_access,
-    .sys_entry[20] = &entry_chflags,
+
+    .total_syscalls = sizeof(mac_osx_entries) / sizeof(mac_osx_entries[0]),
+    .sys_entry = mac_osx_entries
 };
 
 #endif
@@ -0,0 +1,570 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+#include "select.h"
+#include "entry.h"
+#include "concurrent/concurrent.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Picks between rebuilding the alias table from the latest results. */
+#define REBUILD_INTERVAL 1024
+
+/* Runs a syscall needs before we decide it always fails with EINVAL or ENOSYS. */
+#define SKIP_SAMPLES 64
+
+/* A crash is worth this many new edges. */
+#define CRASH_WORTH 64.0
+
+/* How much a syscall's weight grows per new edge it finds per run,
+   and the most it can grow by. */
+#define YIELD_BOOST 4.0
+#define YIELD_LIMIT 16.0
+
+/* Results for one syscall, only the syscall loop writes these
+   and the counters only go up. */
+struct syscall_stats
+{
+    uint64_t runs;
+    uint64_t errors;
+    uint64_t invalid;
+    uint64_t crashes;
+    uint64_t coverage;
+};
+
+/* The selector's view of one active syscall, only the producer thread touches these. */
+struct syscall_score
+{
+    /* Counters at the last rebuild. */
+    struct syscall_stats seen;
+
+    /* Moving averages over the runs between rebuilds. */
+    double error_rate;
+    double yield;
+};
+
+static struct syscall_table *table;
+
+static const char *group_names[GROUP_TOTAL] = {"fs", "net", "ipc", "mm", "proc"};
+
+/* The user's weights and the syscalls left to run, set in the
+   parent and inherited by every child. */
+static double *base_weight;
+
+static uint32_t *active;
+
+static uint32_t total_active;
+
+static struct syscall_stats *stats;
+
+static struct syscall_score *score;
+
+static double *weight;
+
+static struct alias_table alias;
+
+static uint32_t picks;
+
+int32_t alias_table_init(struct alias_table *alias_table,
+                         uint32_t total,
+                         struct memory_allocator *allocator,
+                         struct output_writter *output)
+{
+    if(total == 0 || total >= ALIAS_SCALE)
+    {
+        output->write(ERROR, "Alias table size out of range: %u\n", total);
+        return (-1);
+    }
+
+    alias_table->total = total;
+    alias_table->prob = allocator->alloc(total * sizeof(uint32_t));
+    alias_table->alias = allocator->alloc(total * sizeof(uint32_t));
+    alias_table->mass = allocator->alloc(total * sizeof(uint64_t));
+    alias_table->work = allocator->alloc(total * sizeof(uint32_t));
+    if(alias_table->prob == NULL || alias_table->alias == NULL ||
+       alias_table->mass == NULL || alias_table->work == NULL)
+    {
+        output->write(ERROR, "Can't allocate alias table\n");
+        alias_table_cleanup(alias_table, allocator);
+        return (-1);
+    }
+
+    /* Until it's built every entry is equally likely. */
+    for(uint32_t i = 0; i < total; i++)
+    {
+        alias_table->prob[i] = ALIAS_SCALE;
+        alias_table->alias[i] = i;
+    }
+
+    return (0);
+}
+
+int32_t alias_table_build(struct alias_table *alias_table, const double *weights)
+{
+    uint32_t i;
+    uint32_t heaviest = 0;
+    double sum = 0.0;
+    uint64_t assigned = 0;
+    uint32_t total = alias_table->total;
+    uint64_t *mass = alias_table->mass;
+    uint64_t full = (uint64_t)total * ALIAS_SCALE;
+
+    for(i = 0; i < total; i++)
+    {
+        sum += weights[i];
+
+        if(weights[i] > weights[heaviest])
+            heaviest = i;
+    }
+
+    if(sum <= 0.0)
+        return (-1);
+
+    /* Work in whole parts so the masses add up to exactly total columns,
+       that way a zero weight can't pick up a column from rounding. */
+    for(i = 0; i < total; i++)
+    {
+        mass[i] = (uint64_t)((weights[i] / sum) * (double)full);
+        assigned += mass[i];
+    }
+
+    mass[heaviest] += full - assigned;
+
+    /* Underfull entries fill the work array from the front and
+       overfull ones from the back. */
+    uint32_t small = 0;
+    uint32_t large = total;
+
+    for(i = 0; i < total; i++)
+    {
+        if(mass[i] < ALIAS_SCALE)
+            alias_table->work[small++] = i;
+        else
+            alias_table->work[--large] = i;
+    }
+
+    /* Top up each underfull column with an overfull entry. */
+    while(small > 0 && large < total)
+    {
+        uint32_t less = alias_table->work[--small];
+        uint32_t more = alias_table->work[large];
+
+        alias_table->prob[less] = (uint32_t)mass[less];
+        alias_table->alias[less] = more;
+
+        mass[more] -= ALIAS_SCALE - mass[less];
+
+        /* It's underfull now, move it over to the small side. */
+        if(mass[more] < ALIAS_SCALE)
+        {
+            large++;
+            alias_table->work[small++] = more;
+        }
+    }
+
+    /* Whatever is left is exactly full. */
+    while(large < total)
+    {
+        uint32_t more = alias_table->work[large++];
+
+        alias_table->prob[more] = ALIAS_SCALE;
+        alias_table->alias[more] = more;
+    }
+
+    while(small > 0)
+    {
+        uint32_t less = alias_table->work[--small];
+
+        alias_table->prob[less] = ALIAS_SCALE;
+        alias_table->alias[less] = less;
+    }
+
+    return (0);
+}
+
+uint32_t alias_table_draw(const struct alias_table *alias_table, uint32_t number)
+{
+    uint32_t column = number / ALIAS_SCALE;
+
+    if(number % ALIAS_SCALE < alias_table->prob[column])
+        return (column);
+
+    return (alias_table->alias[column]);
+}
+
+void alias_table_cleanup(struct alias_table *alias_table, struct memory_allocator *allocator)
+{
+    if(alias_table->prob != NULL)
+        allocator->free((void **)&alias_table->prob);
+
+    if(alias_table->alias != NULL)
+        allocator->free((void **)&alias_table->alias);
+
+    if(alias_table->mass != NULL)
+        allocator->free((void **)&alias_table->mass);
+
+    if(alias_table->work != NULL)
+        allocator->free((void **)&alias_table->work);
+
+    return;
+}
+
+static int32_t find_syscall(const char *name, size_t len, uint32_t *syscall_number)
+{
+    uint32_t i;
+
+    for(i = 0; i < table->total_syscalls; i++)
+    {
+        const char *syscall_name = table->sys_entry[i]->syscall_name;
+
+        if(strncmp(syscall_name, name, len) == 0 && syscall_name[len] == '\0')
+        {
+            (*syscall_number) = i;
+            return (0);
+        }
+    }
+
+    return (-1);
+}
+
+static int32_t find_group(const char *name, size_t len, uint32_t *group)
+{
+    uint32_t i;
+
+    for(i = 0; i < GROUP_TOTAL; i++)
+    {
+        if(strncmp(group_names[i], name, len) == 0 && group_names[i][len] == '\0')
+        {
+            (*group) = i;
+            return (0);
+        }
+    }
+
+    return (-1);
+}
+
+/* Set status on every syscall named in the comma separated list. */
+static int32_t set_status(const char *list, int32_t status, struct output_writter *output)
+{
+    const char *pos = list;
+
+    while((*pos) != '\0')
+    {
+        uint32_t syscall_number = 0;
+        size_t len = strcspn(pos, ",");
+
+        if(find_syscall(pos, len, &syscall_number) < 0)
+        {
+            output->write(ERROR, "Unknown syscall: %.*s\n", (int)len, pos);
+            return (-1);
+        }
+
+        table->sys_entry[syscall_number]->status = status;
+
+        pos += len;
+        if((*pos) == ',')
+            pos++;
+    }
+
+    return (0);
+}
+
+static int32_t parse_groups(const char *list, uint32_t *groups, struct output_writter *output)
+{
+    const char *pos = list;
+
+    (*groups) = 0;
+
+    while((*pos) != '\0')
+    {
+        uint32_t group = 0;
+        size_t len = strcspn(pos, ",");
+
+        if(find_group(pos, len, &group) < 0)
+        {
+            output->write(ERROR, "Unknown syscall group: %.*s\n", (int)len, pos);
+            return (-1);
+        }
+
+        (*groups) |= SYSCALL_GROUP(group);
+
+        pos += len;
+        if((*pos) == ',')
+            pos++;
+    }
+
+    return (0);
+}
+
+static int32_t parse_weights(const char *list, struct output_writter *output)
+{
+    const char *pos = list;
+
+    /* Parse name=weight pairs separated by commas. */
+    while((*pos) != '\0')
+    {
+        char *end = NULL;
+        uint32_t syscall_number = 0;
+        const char *equal = strchr(pos, '=');
+
+        if(equal == NULL || equal == pos)
+        {
+            output->write(ERROR, "Expected name=weight in: %s\n", pos);
+            return (-1);
+        }
+
+        if(find_syscall(pos, (size_t)(equal - pos), &syscall_number) < 0)
+        {
+            output->write(ERROR, "Unknown syscall in weights: %.*s\n", (int)(equal - pos), pos);
+            return (-1);
+        }
+
+        errno = 0;
+        double value = strtod(equal + 1, &end);
+        if(errno != 0 || end == equal + 1 || value < 0.0 || ((*end) != ',' && (*end) != '\0'))
+        {
+            output->write(ERROR, "Invalid weight for %.*s\n", (int)(equal - pos), pos);
+            return (-1);
+        }
+
+        base_weight[syscall_number] = value;
+
+        pos = ((*end) == ',') ? end + 1 : end;
+    }
+
+    return (0);
+}
+
+int32_t setup_syscall_selection(struct syscall_table *syscall_table,
+                                struct syscall_selection *selection,
+                                struct memory_allocator *allocator,
+                                struct output_writter *output)
+{
+    uint32_t i;
+    uint32_t groups = 0;
+    uint32_t total = syscall_table->total_syscalls;
+
+    table = syscall_table;
+
+    base_weight = allocator->alloc(total * sizeof(double));
+    active = allocator->alloc(total * sizeof(uint32_t));
+    if(base_weight == NULL || active == NULL)
+    {
+        output->write(ERROR, "Can't allocate syscall selection\n");
+        return (-1);
+    }
+
+    for(i = 0; i < total; i++)
+        base_weight[i] = 1.0;
+
+    if(selection != NULL)
+    {
+        if(selection->weights != NULL && parse_weights(selection->weights, output) < 0)
+            return (-1);
+
+        if(selection->groups != NULL && parse_groups(selection->groups, &groups, output) < 0)
+            return (-1);
+
+        /* Narrowing the run to some syscalls turns everything else off. */
+        if(selection->enable != NULL || selection->groups != NULL)
+        {
+            for(i = 0; i < total; i++)
+            {
+                if((table->sys_entry[i]->groups & groups) == 0)
+                    table->sys_entry[i]->status = OFF;
+            }
+        }
+
+        /* Enabling a syscall wins over it's default, disabling wins over everything. */
+        if(selection->enable != NULL && set_status(selection->enable, ON, output) < 0)
+            return (-1);
+
+        if(selection->disable != NULL && set_status(selection->disable, OFF, output) < 0)
+            return (-1);
+    }
+
+    /* Pack the syscalls left into the index we pick from, so nothing
+       else ever touches a syscall that's off. */
+    total_active = 0;
+
+    for(i = 0; i < total; i++)
+    {
+        if(table->sys_entry[i]->status == OFF || base_weight[i] == 0.0)
+            continue;
+
+        /* Without root these only ever fail with EPERM. */
+        if(table->sys_entry[i]->requires_root == NX_YES && geteuid() != 0)
+            continue;
+
+        active[total_active++] = i;
+    }
+
+    if(total_active == 0)
+    {
+        output->write(ERROR, "No syscalls left to run\n");
+        return (-1);
+    }
+
+    return (0);
+}
+
+uint32_t get_total_active(void)
+{
+    return (total_active);
+}
+
+int32_t setup_syscall_selector(struct memory_allocator *allocator, struct output_writter *output)
+{
+    uint32_t total = table->total_syscalls;
+
+    stats = allocator->alloc(total * sizeof(struct syscall_stats));
+    score = allocator->alloc(total_active * sizeof(struct syscall_score));
+    weight = allocator->alloc(total_active * sizeof(double));
+    if(stats == NULL || score == NULL || weight == NULL)
+    {
+        output->write(ERROR, "Can't allocate syscall selector\n");
+        return (-1);
+    }
+
+    memset(stats, 0, total * sizeof(struct syscall_stats));
+    memset(score, 0, total_active * sizeof(struct syscall_score));
+
+    if(alias_table_init(&alias, total_active, allocator, output) < 0)
+    {
+        output->write(ERROR, "Can't init alias table\n");
+        return (-1);
+    }
+
+    picks = 0;
+
+    return (0);
+}
+
+/* Fold the results since the last rebuild into each active syscall's weight. */
+static void update_weights(void)
+{
+    uint32_t i;
+
+    for(i = 0; i < total_active; i++)
+    {
+        struct syscall_stats now;
+        struct syscall_score *s = &score[i];
+        uint32_t syscall_number = active[i];
+
+        now.runs = atomic_load_uint64(&stats[syscall_number].runs);
+        now.errors = atomic_load_uint64(&stats[syscall_number].errors);
+        now.invalid = atomic_load_uint64(&stats[syscall_number].invalid);
+        now.crashes = atomic_load_uint64(&stats[syscall_number].crashes);
+        now.coverage = atomic_load_uint64(&stats[syscall_number].coverage);
+
+        /* Not implemented here or we can't build arguments it takes, stop wasting time on it. */
+        if(now.runs >= SKIP_SAMPLES && now.invalid == now.runs)
+        {
+            weight[i] = 0.0;
+            continue;
+        }
+
+        uint64_t runs = now.runs - s->seen.runs;
+        if(runs > 0)
+        {
+            double errors = (double)(now.errors - s->seen.errors) / (double)runs;
+            double found = ((double)(now.coverage - s->seen.coverage) +
+                            CRASH_WORTH * (double)(now.crashes - s->seen.crashes)) / (double)runs;
+
+            s->error_rate = (s->error_rate + errors) / 2.0;
+            s->yield = (s->yield + found) / 2.0;
+            s->seen = now;
+        }
+
+        double boost = YIELD_BOOST * s->yield;
+        if(boost > YIELD_LIMIT)
+            boost = YIELD_LIMIT;
+
+        /* Failing calls still reach error paths, so they keep a quarter of their weight. */
+        weight[i] = base_weight[syscall_number] * (1.0 + boost) * (1.0 - (0.75 * s->error_rate));
+    }
+
+    /* If every syscall is useless keep the old table. */
+    (void)alias_table_build(&alias, weight);
+
+    return;
+}
+
+int32_t select_syscall(struct random_generator *random,
+                       uint32_t *syscall_number,
+                       struct output_writter *output)
+{
+    uint32_t number = 0;
+
+    if(picks % REBUILD_INTERVAL == 0)
+        update_weights();
+
+    picks++;
+
+    int32_t rtrn = random->range((alias.total * ALIAS_SCALE) - 1, &number);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't generate random number\n");
+        return (-1);
+    }
+
+    /* Not every generator stays inside the range. */
+    if(number >= alias.total * ALIAS_SCALE)
+        number %= alias.total * ALIAS_SCALE;
+
+    (*syscall_number) = active[alias_table_draw(&alias, number)];
+
+    return (0);
+}
+
+void record_syscall_result(uint32_t syscall_number, int32_t ret_value, int32_t error)
+{
+    struct syscall_stats *s = &stats[syscall_number];
+
+    /* The syscall loop is the only writer, plain stores are enough. */
+    atomic_store_uint64(&s->runs, s->runs + 1);
+
+    if(ret_value < 0)
+    {
+        atomic_store_uint64(&s->errors, s->errors + 1);
+
+        if(error == EINVAL || error == ENOSYS)
+            atomic_store_uint64(&s->invalid, s->invalid + 1);
+    }
+
+    return;
+}
+
+void record_syscall_crash(uint32_t syscall_number)
+{
+    struct syscall_stats *s = &stats[syscall_number];
+
+    atomic_store_uint64(&s->runs, s->runs + 1);
+    atomic_store_uint64(&s->crashes, s->crashes + 1);
+
+    return;
+}
+
+void record_syscall_coverage(uint32_t syscall_number, uint32_t new_edges)
+{
+    struct syscall_stats *s = &stats[syscall_number];
+
+    atomic_store_uint64(&s->coverage, s->coverage + new_edges);
+
+    return;
+}
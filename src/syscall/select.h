@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+#ifndef SELECT_H
+#define SELECT_H
+
+#include "io/io.h"
+#include "memory/memory.h"
+#include "crypto/crypto.h"
+#include "syscall_table.h"
+
+#include <stdint.h>
+
+/* Each column of an alias table is split in this many parts. */
+#define ALIAS_SCALE 65536
+
+/**
+ * A Walker alias table, picking an index takes one random number and one
+ * compare however many entries there are or however uneven their weights.
+ */
+struct alias_table
+{
+    uint32_t total;
+
+    const char padding[4];
+
+    /* Parts out of ALIAS_SCALE where column i picks i instead of alias[i]. */
+    uint32_t *prob;
+
+    uint32_t *alias;
+
+    /* Scratch space for building the table. */
+    uint64_t *mass;
+    uint32_t *work;
+};
+
+/**
+ * Allocate an alias table for total entries.
+ * @param table The alias table to set up.
+ * @param total The number of entries, less than ALIAS_SCALE.
+ * @param allocator A memory allocator object.
+ * @param output An output writter object.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t alias_table_init(struct alias_table *table,
+                                uint32_t total,
+                                struct memory_allocator *allocator,
+                                struct output_writter *output);
+
+/**
+ * Rebuild the table so entry i is picked in proportion to weights[i]. Entries
+ * with a weight of zero are never picked.
+ * @param table The alias table to rebuild.
+ * @param weights One non negative weight per entry.
+ * @return Zero on success and negative one if every weight is zero, the table
+ * is left as it was.
+ */
+extern int32_t alias_table_build(struct alias_table *table, const double *weights);
+
+/**
+ * Pick an entry.
+ * @param table The alias table to pick from.
+ * @param number A uniform random number below table->total * ALIAS_SCALE.
+ * @return The index of the entry picked.
+ */
+extern uint32_t alias_table_draw(const struct alias_table *table, uint32_t number);
+
+extern void alias_table_cleanup(struct alias_table *table, struct memory_allocator *allocator);
+
+/* Which syscalls the user wants run and how often, every field can be NULL.
+   Each one is a comma separated list. */
+struct syscall_selection
+{
+    /* Syscalls to run, even ones that start turned off. */
+    const char *enable;
+
+    /* Syscalls to never run. */
+    const char *disable;
+
+    /* Groups to limit the run to: fs, net, ipc, mm or proc. */
+    const char *groups;
+
+    /* name=weight pairs like "read=4,open=0.5", syscalls start with a
+      weight of one and a weight of zero turns the syscall off. */
+    const char *weights;
+};
+
+/**
+ * Apply the user's selection to the syscall table and build the index of syscalls
+ * we run. Call in the parent before the children are created. With no enable or
+ * groups list every syscall that is on runs, otherwise only the syscalls enabled or
+ * in one of the groups do. Disabled syscalls never run, and neither do syscalls that
+ * need root when we aren't root.
+ * @param table The syscall table.
+ * @param selection The user's selection, or NULL to run every syscall that is on.
+ * @param allocator A memory allocator object.
+ * @param output An output writter object.
+ * @return Zero on success and negative one on failure or if nothing is left to run.
+ */
+extern int32_t setup_syscall_selection(struct syscall_table *table,
+                                       struct syscall_selection *selection,
+                                       struct memory_allocator *allocator,
+                                       struct output_writter *output);
+
+/* The number of syscalls the selection left to run. */
+extern uint32_t get_total_active(void);
+
+/**
+ * Set up the calling child's syscall selector, call after the fork.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t setup_syscall_selector(struct memory_allocator *allocator, struct output_writter *output);
+
+/**
+ * Pick the next syscall to test. The weights are adjusted every so often from
+ * what the recorded results say, syscalls that find coverage or crash are
+ * picked more and syscalls that keep failing less.
+ * @param random A random generator object.
+ * @param syscall_number Where the syscall picked is placed.
+ * @param output An output writter object.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t select_syscall(struct random_generator *random,
+                              uint32_t *syscall_number,
+                              struct output_writter *output);
+
+/* Record a syscall returning, error is errno when ret_value is negative. */
+extern void record_syscall_result(uint32_t syscall_number, int32_t ret_value, int32_t error);
+
+/* Record a syscall crashing the child. */
+extern void record_syscall_crash(uint32_t syscall_number);
+
+/* Record a syscall reaching new_edges edges nothing reached before. */
+extern void record_syscall_coverage(uint32_t syscall_number, uint32_t new_edges);
+
+#endif
@@ -21,34 +21,60 @@
 #include <signal.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <setjmp.h>
 
+/* Self pipe the SIGCHLD handler writes to so the main loop can sleep until a child exits. */
+static int32_t exit_pipe[2] = {-1, -1};
+
 static void child_exit_handler(int sig)
 {
-    pid_t pid = 0;
-    int32_t status = 0;
-
     (void)sig;
 
-    while((pid = waitpid(-1, &status, WNOHANG)) > 0)
-    {
-        if(WIFEXITED(status))
-        {
-            struct child_ctx *child = NULL;
+    /* Save errno, we may have interrupted something that checks it. */
+    int32_t saved_errno = errno;
 
-            child = get_child_ctx_from_pid(pid);
-            if(child == NULL)
-                return;
+    /* Just wake the main loop, it does the reaping. If the pipe is full the main
+      loop has a wake up pending already so ignore the error. */
+    (void)write(exit_pipe[1], "!", 1);
 
-            set_child_pid(child, EMPTY);
-        }
-    }
+    errno = saved_errno;
 
     return;
 }
 
+int32_t wait_for_child_exit(int32_t timeout, struct output_writter *output)
+{
+    char buf[64];
+    struct pollfd pfd;
+
+    pfd.fd = exit_pipe[0];
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    /* Sleep until the SIGCHLD handler writes to the pipe or we time out. */
+    int32_t rtrn = poll(&pfd, 1, timeout);
+    if(rtrn < 0)
+    {
+        /* Interrupted by a signal, let the caller check if it should stop. */
+        if(errno == EINTR)
+            return (0);
+
+        output->write(ERROR, "poll: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    /* Drain the pipe so one wake up covers every exit so far. */
+    while(rtrn > 0 && read(exit_pipe[0], buf, sizeof(buf)) > 0)
+        continue;
+
+    return (0);
+}
+
 static void ctrlc_handler(int sig)
 {
     (void)sig;
@@ -90,12 +116,34 @@ int32_t setup_signal_handler(struct output_writter *output)
         return (-1);
     }
 
+    /* Create the pipe the SIGCHLD handler wakes the main loop with. Both ends are
+      non blocking so the handler can never block and we can drain the pipe. */
+    if(exit_pipe[0] == -1)
+    {
+        rtrn = pipe(exit_pipe);
+        if(rtrn < 0)
+        {
+            output->write(ERROR, "Can't create exit pipe: %s\n", strerror(errno));
+            return (-1);
+        }
+
+        if(fcntl(exit_pipe[0], F_SETFL, O_NONBLOCK) < 0 ||
+           fcntl(exit_pipe[1], F_SETFL, O_NONBLOCK) < 0)
+        {
+            output->write(ERROR, "Can't set exit pipe non blocking: %s\n", strerror(errno));
+            return (-1);
+        }
+    }
+
     struct sigaction sa;
     memset(&sa, 0, sizeof(struct sigaction));
 
     /* Set the child exit handler. */
     sa.sa_handler = &child_exit_handler;
 
+    /* Only wake up for exits and don't interrupt the main loop's other syscalls. */
+    sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+
     /* Block every signal during the handler */
     sigfillset(&sa.sa_mask);
 
@@ -116,13 +164,20 @@ static void child_signal_handler(int sig, siginfo_t *info, void *context)
       this caste if we begin using context in this function. */
     (void)context;
 
-    /* Grab the child context using the pid
-      that recieved a signal. We need the
-      child context so we can let the child
-      know it's jumping back from a signal
-      handler. */
+    (void)info;
+
+    /* A fault in an argument generator, the producer recovers on it's own. */
+    if(sig != SIGALRM && on_producer_thread() == TRUE)
+        producer_jump();
+
+    /* Grab the child context of the process that
+      recieved the signal. We need the child context
+      so we can let the child know it's jumping back
+      from a signal handler. */
     struct child_ctx *child = NULL;
-    child = get_child_ctx_from_pid(info->si_pid);
+    child = get_current_child();
+    if(child == NULL)
+        return;
 
     /* Check what kind of signal got us here. */
     switch(sig)
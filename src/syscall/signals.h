@@ -25,4 +25,13 @@ extern int32_t setup_signal_handler(struct output_writter *output);
 
 extern int32_t setup_child_signal_handler(struct output_writter *output);
 
+/**
+ * Sleep until a child process exits or the timeout passes. setup_signal_handler()
+ * must be called first.
+ * @param timeout The most time to wait in milliseconds.
+ * @param output An output writter object.
+ * @return Zero on success and negative one on error.
+ */
+extern int32_t wait_for_child_exit(int32_t timeout, struct output_writter *output);
+
 #endif
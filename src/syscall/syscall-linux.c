@@ -12,11 +12,83 @@
  * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
  * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  **/
- 
+
+#define _GNU_SOURCE
+
+#include "affinity.h"
+#include "timeout.h"
 #include "syscall_table.h"
 #include "linux_syscall_table.h"
 
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
 struct syscall_table *get_table(void)
 {
 	return (&linux_syscall_table);
-}
\ No newline at end of file
+}
+
+int32_t set_child_affinity(uint32_t cpu, struct output_writter *output)
+{
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    if(sched_setaffinity(0, sizeof(cpu_set_t), &set) < 0)
+    {
+        output->write(ERROR, "sched_setaffinity: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    return (0);
+}
+
+/* Per process timer for blocking syscalls, SIGALRM goes to the syscall loop
+   since the producer thread blocks every signal. */
+static timer_t syscall_timer;
+
+int32_t create_syscall_timer(struct output_writter *output)
+{
+    struct sigevent event;
+
+    memset(&event, 0, sizeof(struct sigevent));
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGALRM;
+
+    if(timer_create(CLOCK_MONOTONIC, &event, &syscall_timer) < 0)
+    {
+        output->write(ERROR, "timer_create: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    return (0);
+}
+
+void arm_syscall_timer(uint64_t usec)
+{
+    struct itimerspec spec;
+
+    memset(&spec, 0, sizeof(struct itimerspec));
+    spec.it_value.tv_sec = (time_t)(usec / 1000000);
+    spec.it_value.tv_nsec = (long)((usec % 1000000) * 1000);
+
+    (void)timer_settime(syscall_timer, 0, &spec, NULL);
+
+    return;
+}
+
+void disarm_syscall_timer(void)
+{
+    struct itimerspec spec;
+
+    memset(&spec, 0, sizeof(struct itimerspec));
+
+    (void)timer_settime(syscall_timer, 0, &spec, NULL);
+
+    return;
+}
@@ -15,7 +15,51 @@
  * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  **/
 
+#include "affinity.h"
+#include "timeout.h"
 #include "syscall_table.h"
 #include "mac_osx_syscall_table.h"
 
+#include <string.h>
+#include <sys/time.h>
+
 struct syscall_table *get_table(void) { return (&mac_osx_syscall_table); }
+
+int32_t set_child_affinity(uint32_t cpu, struct output_writter *output)
+{
+    /* Mac OSX has no way to pin a process, only thread affinity hints. */
+    (void)cpu;
+    (void)output;
+    return (0);
+}
+
+/* Mac OSX has no POSIX timers, setitimer() has the same microsecond resolution. */
+int32_t create_syscall_timer(struct output_writter *output)
+{
+    (void)output;
+    return (0);
+}
+
+void arm_syscall_timer(uint64_t usec)
+{
+    struct itimerval spec;
+
+    memset(&spec, 0, sizeof(struct itimerval));
+    spec.it_value.tv_sec = (time_t)(usec / 1000000);
+    spec.it_value.tv_usec = (suseconds_t)(usec % 1000000);
+
+    (void)setitimer(ITIMER_REAL, &spec, NULL);
+
+    return;
+}
+
+void disarm_syscall_timer(void)
+{
+    struct itimerval spec;
+
+    memset(&spec, 0, sizeof(struct itimerval));
+
+    (void)setitimer(ITIMER_REAL, &spec, NULL);
+
+    return;
+}
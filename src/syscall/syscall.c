@@ -17,6 +17,8 @@
 #include "arg_types.h"
 #include "crypto/crypto.h"
 #include "entry.h"
+#include "generate.h"
+#include "select.h"
 #include "io/io.h"
 #include "genetic/job.h"
 #include "log/log.h"
@@ -25,27 +27,113 @@
 #include "runtime/nextgen.h"
 #include "runtime/platform.h"
 #include "probe/probe.h"
+#include "coverage/coverage.h"
 #include "resource/resource.h"
+#include "affinity.h"
+#include "timeout.h"
 #include "signals.h"
-#include "set_test.h"
+#include "dispatch.h"
 #include "syscall_table.h"
 #include "utils/utils.h"
 #include "concurrent/concurrent.h"
 
+#include "ck_ht.h"
+#include "ck_ring.h"
+
+#include <pthread.h>
+#include <sched.h>
+
 #include <errno.h>
 #include <string.h>
 #include <sys/types.h>
 #include <setjmp.h>
 #include <signal.h>
+#include <sys/wait.h>
+#include <time.h>
+
+/* The most syscalls in one program. */
+#define PROGRAM_LENGTH 8
+
+/* The most returned resources a program keeps around for later syscalls. */
+#define PROGRAM_RESOURCES 8
+
+/* Bounds on the timeout for blocking syscalls in microseconds. The upper bound
+   is used for entries that don't set their own. */
+static const uint64_t MIN_TIMEOUT_US = 1000;
+static const uint64_t DEFAULT_TIMEOUT_US = 1000000;
+
+/* Calls that have to return before we trust a syscall's latency estimate. */
+static const uint32_t TIMEOUT_SAMPLES = 8;
+
+/* Smoothed latency of a blocking syscall, the same estimator TCP uses for it's
+   retransmit timeout. Kept per child process, so it's never shared. */
+struct syscall_latency
+{
+    uint64_t mean;
+
+    uint64_t deviation;
+
+    uint32_t samples;
+
+    const char padding[4];
+};
+
+static struct syscall_latency *latency;
+
+/* What syscall arguments past an entry's total_args point at. */
+static uint64_t unused_arg;
+
+/* Slots in each child's test case rings, ck_ring needs a power of two. */
+#define TEST_CASE_RING_SIZE 64
+
+/* Bytes of argument payload a test case can generate before it's arena spills to the heap. */
+#define ARG_PAYLOAD_LEN 2048
+
+/* A syscall and it's arguments, generated ahead of time by the child's producer
+   thread. Every slot of a child is carved out of one slab, the fixed argument
+   slots come first and the payloads the arguments live in follow them. */
+struct test_case
+{
+    uint32_t syscall_number;
+
+    int32_t syscall_symbol;
+
+    const char *syscall_name;
+
+    uint32_t total_args;
+
+    int32_t need_alarm;
+
+    uint64_t *arg_value_array[7];
+
+    uint64_t arg_size_array[7];
+
+    /* The resource module handles of the resource arguments, so they are
+       given back without searching the pools. */
+    struct resource_handle arg_handle_array[7];
+
+    /* Everything the generators allocate for this test case, reset when it's done.
+      It's first chunk is value_payload. */
+    struct mem_arena arena;
+
+    char value_payload[ARG_PAYLOAD_LEN] NX_CACHE_ALIGNED;
+};
 
 struct child_ctx
 {
+    /* Number of syscall tests this slot has run. Only the child in this slot writes it,
+      the parent sums every slot's count on demand. It sits alone on the first cache
+      line so the parent's reads don't bounce the lines the child works out of. */
+    uint64_t test_count;
+
+    const char padding0[56];
+
     /* The child's process PID. */
     int32_t pid;
 
     /* A varible to store the address of where to jump back to in the child
     process on signals. */
-    jmp_buf return_jump;
+    sigjmp_buf return_jump;
 
     /* This is the number used to identify and choose the syscall that's going to be tested. */
     uint32_t syscall_number;
@@ -65,12 +153,12 @@ struct child_ctx
     /* This array is where we store the arguments we generate. */
     uint64_t **arg_value_array;
 
-    /* This array is a copy of the value array. */
-    uint64_t **arg_copy_array;
-
     /* This index tracks the size of the arguments.*/
     uint64_t *arg_size_array;
 
+    /* Handles of the arguments that came from the resource module. */
+    struct resource_handle *arg_handle_array;
+
     /* Time that we made the syscall fuzz test. */
     struct timeval time_of_syscall;
 
@@ -90,20 +178,43 @@ struct child_ctx
 
     struct probe_ctx *probe_handle;
 
+    /* Hit counts of the syscall we are running, only used in smart mode. */
+    uint8_t *trace;
+
     int32_t need_alarm;
 
     const char padding2[7];
 
-    int32_t (*test_syscall)(int32_t, uint64_t **);
+    /* Number of syscalls in the program we are running. */
+    uint32_t program_length;
+
+    /* The syscall in the program we are on. */
+    uint32_t program_call;
+
+    /* Resources returned by syscalls earlier in the program, later
+      syscalls can take them as arguments in place of generated ones. */
+    uint32_t total_resources;
+
+    int32_t resource_type[PROGRAM_RESOURCES];
+
+    int32_t resource_value[PROGRAM_RESOURCES];
+
+    /* Test cases the producer thread has generated for us to run. */
+    ck_ring_t *ready_ring;
+    ck_ring_buffer_t *ready_buffer;
+
+    /* Test cases we are done with, for the producer thread to fill again. */
+    ck_ring_t *free_ring;
+    ck_ring_buffer_t *free_buffer;
+
+    /* The test case we are running. */
+    struct test_case *current_case;
 };
 
 struct global_state
 {
     /* The number of children processes currently running. */
     uint32_t running_children;
-
-    /* Counter for number of syscall test that have been completed. */
-    uint32_t *test_counter;
 };
 
 static struct global_state *state;
@@ -111,6 +222,15 @@ static struct global_state *state;
 /* The total number of children process to run. */
 static uint32_t total_children;
 
+/* The number of children the user asked for, zero for one per core. */
+static uint32_t requested_jobs;
+
+/* Which syscalls the user asked us to run and how often, every field starts NULL. */
+static struct syscall_selection requested_selection;
+
+/* Number of CPUs online, children are pinned round robin across them. */
+static uint32_t total_cpus;
+
 /* An array of child context structures. These structures track variables
    local to the child process. */
 static struct child_ctx **children;
@@ -125,10 +245,24 @@ static int32_t *stop;
 /* This variable tells us wether were in smart mode or dumb mode. */
 static int32_t mode;
 
+/* The kernel coverage no child has reached yet, only used in smart mode. */
+static uint8_t *virgin_map;
+
 static int8_t table_set;
 
 static epoch_ctx *epoch;
 
+/* Our slot in the children array, set right after fork so only
+   children have it set. In the parent it stays negative one. */
+static int32_t child_index = -1;
+
+/* The parent's map of child PIDs to their slot in the children array. */
+static ck_ht_t pid_map;
+
+/* How often in milliseconds the main loop wakes up to check
+   the stop flag when no children are exiting. */
+static const int32_t STOP_CHECK_INTERVAL = 100;
+
 void set_had_error(struct child_ctx *child, int32_t val)
 {
     atomic_store_int32(&child->had_error, val);
@@ -153,7 +287,7 @@ NX_NO_RETURN void jump(struct child_ctx *child)
 {
     /* Jump to the return point saved earlier.
       No need for a return because it will not be executed. */
-    longjmp(child->return_jump, 0);
+    siglongjmp(child->return_jump, 1);
 }
 
 void set_child_pid(struct child_ctx *child, int32_t pid)
@@ -184,15 +318,19 @@ uint32_t get_current_arg(struct child_ctx *child)
 
 void set_arg_size(struct child_ctx *child, uint64_t size)
 {
-    (void)child;
-    (void)size;
+    child->arg_size_array[child->current_arg] = size;
 
     return;
 }
 
+struct resource_handle *get_arg_handle(struct child_ctx *child)
+{
+    return (&child->arg_handle_array[child->current_arg]);
+}
+
 void cleanup_syscall_table(struct syscall_table **table, struct memory_allocator *allocator)
 {
-    allocator->free_shared((void **)&(*table)->sys_entry, sizeof(struct syscall_entry));
+    /* The entries live in the platform's const table, only the copy is ours. */
     allocator->free_shared((void **)table, sizeof(struct syscall_table));
 
     return;
@@ -208,7 +346,7 @@ struct syscall_entry *get_entry(uint32_t syscall_number)
 {
     /* If the syscall number passed is greater than the total number
     of syscalls return NULL. */
-    if(syscall_number > sys_table->total_syscalls)
+    if(syscall_number >= sys_table->total_syscalls)
         return (NULL);
 
    return(atomic_load_ptr(&sys_table->sys_entry[syscall_number]));
@@ -226,23 +364,62 @@ struct child_ctx *get_child_from_index(uint32_t i)
     return (atomic_load_ptr(&children[i]));
 }
 
+static void *pid_map_malloc(size_t size) { return (malloc(size)); }
+
+static void *pid_map_realloc(void *ptr, size_t old_size, size_t new_size, bool defer)
+{
+    (void)old_size;
+    (void)defer;
+    return (realloc(ptr, new_size));
+}
+
+static void pid_map_free(void *ptr, size_t size, bool defer)
+{
+    (void)size;
+    (void)defer;
+    free(ptr);
+}
+
+static struct ck_malloc pid_map_allocator = {
+    .malloc = pid_map_malloc, .realloc = pid_map_realloc, .free = pid_map_free};
+
+/* Only the parent writes to the map so these don't need a lock. */
+static int32_t add_child_pid(pid_t pid, uint32_t index)
+{
+    ck_ht_hash_t h;
+    ck_ht_entry_t entry;
+
+    ck_ht_hash_direct(&h, &pid_map, (uintptr_t)pid);
+    ck_ht_entry_set_direct(&entry, h, (uintptr_t)pid, (uintptr_t)index);
+
+    if(ck_ht_set_spmc(&pid_map, h, &entry) == false)
+        return (-1);
+
+    return (0);
+}
+
+static void remove_child_pid(pid_t pid)
+{
+    ck_ht_hash_t h;
+    ck_ht_entry_t entry;
+
+    ck_ht_hash_direct(&h, &pid_map, (uintptr_t)pid);
+    ck_ht_entry_key_set_direct(&entry, (uintptr_t)pid);
+
+    (void)ck_ht_remove_spmc(&pid_map, h, &entry);
+
+    return;
+}
+
 static int32_t get_child_index_number(uint32_t *index_num)
 {
-    uint32_t i = 0;
-    pid_t pid = getpid();
+    /* Only children know their index. */
+    if(child_index < 0)
+        return (-1);
 
-    /* Walk child array until our PID matches the one in the context struct. */
-    for(i = 0; i < total_children; i++)
-    {
-        if(atomic_load_int32(&children[i]->pid) == pid)
-        {
-            /* The PIDS match so set the index number and exit the function. */
-            (*index_num) = i;
-            return (0);
-        }
-    }
-    /* Should not get here, but if we do return an error. */
-    return (-1);
+    (*index_num) = (uint32_t)child_index;
+
+    return (0);
 }
 
 NX_NO_RETURN static void exit_child(struct thread_ctx *thread, struct memory_allocator *allocator, struct output_writter *output)
@@ -264,7 +441,7 @@ NX_NO_RETURN static void exit_child(struct thread_ctx *thread, struct memory_all
     }
 
     /* Clean up kernel probes. */
-    rtrn = cleanup_kernel_probes(child->probe_handle);
+    rtrn = cleanup_kernel_probes(&child->probe_handle, allocator);
     if(rtrn < 0)
     {
         output->write(ERROR, "Can't clean up kernel probes");
@@ -273,6 +450,9 @@ NX_NO_RETURN static void exit_child(struct thread_ctx *thread, struct memory_all
     }
 
 exit:
+    /* Give back the resources in the resource cache if this thread owns it. */
+    flush_resource_cache();
+
     /* We may be in a nested epoch section, so clean all current
     epoch sections before exiting. */
     stop_all_sections(thread, allocator);
@@ -316,31 +496,31 @@ static int32_t free_old_arguments(struct child_ctx *ctx,
         switch((int32_t)entry->arg_context_array[i]->type)
         {
             /* Below is the resource types ie they are from the resource module.
-            They must be freed using special functions and the free must be done on
-            the arg_copy_index so the free_* functions don't use the mutated value in arg_value_index. */
+            They are freed with the handle the generator got, so the free_* functions
+            don't see the mutated value in arg_value_index and don't have to search for it. */
             case FILE_DESC:
-                rtrn = rsrc_gen->free_desc((int32_t *)ctx->arg_copy_array[i]);
+                rtrn = rsrc_gen->free_desc(&ctx->arg_handle_array[i]);
                 if(rtrn < 0)
                     output->write(ERROR, "Can't free descriptor\n");
                 /* Don't return on errors, just keep looping. */
                 break;
 
             case FILE_PATH:
-                rtrn = rsrc_gen->free_filepath((char **)&(ctx->arg_copy_array[i]));
+                rtrn = rsrc_gen->free_filepath(&ctx->arg_handle_array[i]);
                 if(rtrn < 0)
                     output->write(ERROR, "Can't free filepath\n");
                 /* Don't return on errors, just keep looping. */
                 break;
 
             case DIR_PATH:
-                rtrn = rsrc_gen->free_dirpath((char **)&(ctx->arg_copy_array[i]));
+                rtrn = rsrc_gen->free_dirpath(&ctx->arg_handle_array[i]);
                 if(rtrn < 0)
                     output->write(ERROR, "Can't free dirpath\n");
                 /* Don't return on errors, just keep looping. */
                 break;
 
             case SOCKET:
-                rtrn = rsrc_gen->free_socket((int32_t *)ctx->arg_copy_array[i]);
+                rtrn = rsrc_gen->free_socket(&ctx->arg_handle_array[i]);
                 if(rtrn < 0)
                     output->write(ERROR, "Can't free socket\n");
                 /* Don't return on errors, just keep looping. */
@@ -352,14 +532,10 @@ static int32_t free_old_arguments(struct child_ctx *ctx,
                 allocator->free_shared((void **)&ctx->arg_value_array[i], ctx->arg_size_array[i]);
                 break;
 
-            /* Kill the temp process using the copy value
-               so that we don't use the mutated value
-               in arg_value_index[i]. */
+            /* The value in arg_value_array[i] may be mutated, so killing
+               the temp process needs the generator to keep it's PID
+               the way resource arguments keep their handle. */
             case PID:
-                /*rtrn = kill((pid_t)(*ctx->arg_copy_array[i]), SIGKILL);
-                if(rtrn < 0)
-                    output(ERROR, "Can't kill child: %s\n", strerror(errno));
-                 Don't return on errors, just keep looping. */
                 break;
 
             default:
@@ -372,91 +548,186 @@ static int32_t free_old_arguments(struct child_ctx *ctx,
     return (0);
 }
 
-NX_NO_RETURN static void start_smart_syscall_child(struct thread_ctx *thread,
-                                                   struct memory_allocator *allocator,
-                                                   struct output_writter *output)
+struct child_ctx *get_child_ctx_from_pid(pid_t pid)
 {
-    int32_t rtrn = 0;
-    struct child_ctx *child = NULL;
+    ck_ht_hash_t h;
+    ck_ht_entry_t entry;
 
-    epoch_start(thread, allocator, output);
+    /* A child looking itself up, the map is from before it was forked. */
+    if(child_index >= 0 && atomic_load_int32(&children[child_index]->pid) == pid)
+        return (children[child_index]);
 
-    /* Grab our child context object. */
-    child = get_child(output);
-    if(child == NULL)
+    ck_ht_hash_direct(&h, &pid_map, (uintptr_t)pid);
+    ck_ht_entry_key_set_direct(&entry, (uintptr_t)pid);
+
+    if(ck_ht_get_spmc(&pid_map, h, &entry) == false)
+        return (NULL);
+
+    return (children[ck_ht_entry_value_direct(&entry)]);
+}
+
+struct child_ctx *get_current_child(void)
+{
+    if(child_index < 0)
+        return (NULL);
+
+    return (children[child_index]);
+}
+
+struct child_ctx *get_child(struct output_writter *output)
+{
+    int32_t rtrn = 0;
+    uint32_t offset = 0;
+
+    /* Lookup our child's context object's offset in the child array. */
+    rtrn = get_child_index_number(&offset);
+    if(rtrn < 0)
     {
-        output->write(ERROR, "Can't get child context\n");
-        exit_child(thread, allocator, output);
+        output->write(ERROR, "Can't grab child number\n");
+        return (NULL);
     }
 
-    /* Set the return jump so that we can try fuzzing again on a signal. This
-    is required on some operating systems because they can't clean up old
-    processes fast enough for us. It also alows us to do PRNG seeding and
-    probe injection and teardown less often. */
-    rtrn = setjmp(child->return_jump);
+    /* Load and return the actual child context pointer. */
+    return (atomic_load_ptr(&children[offset]));
+}
+
+/* Close the resources the last program created. We close them ourselves
+   because they came from the kernel, not the resource module's pools. */
+static void end_program(struct child_ctx *child)
+{
+    uint32_t i;
+
+    for(i = 0; i < child->total_resources; i++)
+        (void)close(child->resource_value[i]);
+
+    child->total_resources = 0;
+
+    return;
+}
+
+/* Start a new program of one to PROGRAM_LENGTH syscalls. */
+static int32_t start_program(struct child_ctx *child,
+                             struct random_generator *random,
+                             struct output_writter *output)
+{
+    int32_t rtrn = 0;
+    uint32_t length = 0;
+
+    end_program(child);
+
+    rtrn = random->range(PROGRAM_LENGTH - 1, &length);
     if(rtrn < 0)
     {
-        output->write(ERROR, "Can't set return jump\n");
-        exit_child(thread, allocator, output);
+        output->write(ERROR, "Can't pick program length\n");
+        return (-1);
     }
 
-    epoch_stop(thread, allocator);
+    child->program_length = length + 1;
+    child->program_call = 0;
 
-    /* Loop until ctrl-c is pressed by the user. */
-    while(atomic_load_int32(stop) != TRUE)
+    return (0);
+}
+
+/* Replace resource arguments with resources returned earlier in the program. Only the value
+   array is changed, so free_old_arguments() still returns the pooled resource in the handle array. */
+static int32_t link_arguments(struct child_ctx *child,
+                              struct syscall_entry *entry,
+                              struct random_generator *random,
+                              struct output_writter *output)
+{
+    uint32_t i, x;
+    int32_t rtrn = 0;
+
+    for(i = 0; i < child->total_args; i++)
     {
+        uint32_t count = 0;
+        uint32_t pick = 0;
+        int32_t matches[PROGRAM_RESOURCES];
+        int32_t type = entry->arg_type_array[i];
+
+        if(type != FILE_DESC && type != SOCKET)
+            continue;
+
+        /* Collect the resources of the type this argument takes. */
+        for(x = 0; x < child->total_resources; x++)
+        {
+            if(child->resource_type[x] == type)
+                matches[count++] = child->resource_value[x];
+        }
+
+        if(count == 0)
+            continue;
+
+        /* Pick one of the resources or the pooled one, so pooled resources still get used. */
+        rtrn = random->range(count, &pick);
+        if(rtrn < 0)
+        {
+            output->write(ERROR, "Can't pick resource\n");
+            return (-1);
+        }
+
+        if(pick == count)
+            continue;
 
+        memcpy(child->arg_value_array[i], &matches[pick], sizeof(int32_t));
     }
 
-    exit_child(thread, allocator, output);
+    return (0);
 }
 
-struct child_ctx *get_child_ctx_from_pid(pid_t pid)
+/* Keep the resource the last syscall returned so the rest of the program can use it. */
+static void record_result(struct child_ctx *child)
 {
     uint32_t i;
 
-    for(i = 0; i < total_children; i++)
+    struct syscall_entry *entry = get_entry(child->syscall_number);
+    if(entry == NULL || entry->returns_resource == false)
+        return;
+
+    if(child->had_error == NX_YES || child->ret_value < 0)
+        return;
+
+    /* dup2() and dup3() return the descriptor they were passed, it
+      belongs to the resource module so it's not ours to close. */
+    for(i = 0; i < child->total_args; i++)
     {
-        if(children[i]->pid == pid)
-            return (children[i]);
-    }
+        if((entry->ptr_args & ARG_PTR(i)) != 0)
+            continue;
 
-    /* Should not get here, but if we do return NULL. */
-    return (NULL);
-}
+        if(entry->arg_type_array[i] != FILE_DESC && entry->arg_type_array[i] != SOCKET)
+            continue;
 
-struct child_ctx *get_child(struct output_writter *output)
-{
-    int32_t rtrn = 0;
-    uint32_t offset = 0;
+        if((int32_t)(*child->arg_value_array[i]) == child->ret_value)
+            return;
+    }
 
-    /* Lookup our child's context object's offset in the child array. */
-    rtrn = get_child_index_number(&offset);
-    if(rtrn < 0)
+    /* No room left, don't leak it. */
+    if(child->total_resources == PROGRAM_RESOURCES)
     {
-        output->write(ERROR, "Can't grab child number\n");
-        return (NULL);
+        (void)close(child->ret_value);
+        return;
     }
 
-    /* Load and return the actual child context pointer. */
-    return (atomic_load_ptr(&children[offset]));
+    child->resource_type[child->total_resources] = entry->ret_type;
+    child->resource_value[child->total_resources] = child->ret_value;
+    child->total_resources++;
+
+    return;
 }
 
+/* Runs in the producer thread, fills the arrays child points at with a new test case. */
 static int32_t generate_test_case(struct child_ctx *child,
-                                  struct thread_ctx *thread,
                                   struct output_writter *output,
-                                  struct memory_allocator *allocator,
                                   struct random_generator *random)
 {
     int32_t rtrn = 0;
-    struct syscall_entry *entry = NULL;
 
     /* Randomly pick the syscall to test. */
     rtrn = pick_syscall(child, random, output);
     if(rtrn < 0)
     {
         output->write(ERROR, "Can't pick syscall to test\n");
-        exit_child(thread, allocator, output);
+        return (-1);
     }
 
     /* Generate arguments for the syscall selected. */
@@ -464,7 +735,7 @@ static int32_t generate_test_case(struct child_ctx *child,
     if(rtrn < 0)
     {
         output->write(ERROR, "Can't generate arguments\n");
-        exit_child(thread, allocator, output);
+        return (-1);
     }
 
     /* Mutate the arguments randomly. */
@@ -472,9 +743,42 @@ static int32_t generate_test_case(struct child_ctx *child,
     if(rtrn < 0)
     {
         output->write(ERROR, "Can't mutate arguments\n");
-        exit_child(thread, allocator, output);
+        return (-1);
     }
 
+    return (0);
+}
+
+/* Takes the next test case from the producer thread and gets it ready to run. */
+static int32_t next_test_case(struct child_ctx *child,
+                              struct thread_ctx *thread,
+                              struct output_writter *output,
+                              struct memory_allocator *allocator,
+                              struct random_generator *random)
+{
+    int32_t rtrn = 0;
+    struct test_case *test = NULL;
+    struct syscall_entry *entry = NULL;
+
+    /* The producer shares our CPU, so give it the processor while we wait. */
+    while(ck_ring_dequeue_spsc(child->ready_ring, child->ready_buffer, &test) == false)
+        (void)sched_yield();
+
+    child->current_case = test;
+
+    /* Point the child context at the test case. */
+    child->syscall_name = test->syscall_name;
+    atomic_store_uint32(&child->syscall_number, test->syscall_number);
+    atomic_store_uint32(&child->total_args, test->total_args);
+    atomic_store_int32(&child->syscall_symbol, test->syscall_symbol);
+    atomic_store_int32(&child->need_alarm, test->need_alarm);
+    atomic_store_int32(&child->had_error, NX_NO);
+
+    /* Run the test case straight out of it's slot, nothing is copied. */
+    child->arg_value_array = test->arg_value_array;
+    child->arg_size_array = test->arg_size_array;
+    child->arg_handle_array = test->arg_handle_array;
+
     /* Grab the syscall entry for the syscall we picked. */
     entry = get_entry(child->syscall_number);
     if(entry == NULL)
@@ -483,6 +787,14 @@ static int32_t generate_test_case(struct child_ctx *child,
         exit_child(thread, allocator, output);
     }
 
+    /* Feed resources from earlier in the program into this syscall. */
+    rtrn = link_arguments(child, entry, random, output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't link arguments\n");
+        exit_child(thread, allocator, output);
+    }
+
     /* Log the arguments before we use them, in case we cause a
        kernel panic, so we know what caused the panic. */
     rtrn = log_arguments(child->total_args, child->syscall_name,
@@ -496,6 +808,252 @@ static int32_t generate_test_case(struct child_ctx *child,
     return (0);
 }
 
+/* Hand the test case we just ran back to the producer thread. */
+static void finish_test_case(struct child_ctx *child)
+{
+    if(child->current_case == NULL)
+        return;
+
+    /* Drop the test case's arguments, this also covers a test case that crashed
+       part way through since we never free them one at a time. */
+    mem_arena_reset(&child->current_case->arena);
+
+    /* There are never more test cases than slots so this can't fail. */
+    (void)ck_ring_enqueue_spsc(child->free_ring, child->free_buffer, child->current_case);
+
+    child->current_case = NULL;
+
+    return;
+}
+
+/* The dispatcher always loads six arguments, so point the ones
+   this test case doesn't use at a zero. */
+static void clear_unused_arguments(struct test_case *test)
+{
+    uint32_t i;
+
+    for(i = test->total_args; i < ARG_LIMIT; i++)
+        test->arg_value_array[i] = &unused_arg;
+
+    return;
+}
+
+struct producer_args
+{
+    struct child_ctx *child;
+    struct memory_allocator *allocator;
+    struct output_writter *output;
+    struct random_generator *random;
+    struct resource_generator *rsrc_gen;
+
+    pthread_t thread;
+
+    /* Where a fault in an argument generator jumps back to, the syscall
+       loop's return_jump belongs to another thread's stack. */
+    sigjmp_buf return_jump;
+
+    /* The slot being generated, kept here so it survives the jump. */
+    struct test_case *test;
+};
+
+/* Arguments for this child's producer thread. */
+static struct producer_args producer;
+
+int32_t on_producer_thread(void)
+{
+    if(child_index < 0 || pthread_equal(pthread_self(), producer.thread) == 0)
+        return (FALSE);
+
+    return (TRUE);
+}
+
+NX_NO_RETURN void producer_jump(void)
+{
+    siglongjmp(producer.return_jump, 1);
+}
+
+static void *test_case_producer(void *arg)
+{
+    int32_t rtrn = 0;
+    sigset_t set;
+    struct child_ctx scratch;
+    struct thread_ctx *thread = NULL;
+    struct producer_args *args = arg;
+    struct child_ctx *child = args->child;
+    struct output_writter *output = args->output;
+    struct memory_allocator *allocator = args->allocator;
+
+    /* Set it here too, a fault can beat pthread_create() setting it. */
+    args->thread = pthread_self();
+
+    /* Signals belong to the syscall loop, the handler longjmps back into it.
+       Faults can't be blocked, they come back to our own jump below. */
+    sigfillset(&set);
+    sigdelset(&set, SIGSEGV);
+    sigdelset(&set, SIGBUS);
+    (void)pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    /* Register the producer thread with the global epoch. */
+    thread = init_thread(epoch, allocator, output);
+    if(thread == NULL)
+    {
+        output->write(ERROR, "Thread initialization failed\n");
+        exit_child(thread, allocator, output);
+    }
+
+    memset(&scratch, 0, sizeof(struct child_ctx));
+
+    /* Resources are taken and given back on this thread only, so it
+       can batch them through the resource module's cache. */
+    (void)claim_resource_cache();
+
+    args->test = NULL;
+
+    if(sigsetjmp(args->return_jump, 1) != 0)
+    {
+        /* A generator crashed part way through the slot. Drop what it made,
+           resources it took stay ours until we exit and are reclaimed then. */
+        epoch_stop(thread, allocator);
+
+        mem_arena_reset(&args->test->arena);
+        args->test->total_args = 0;
+    }
+
+    while(atomic_load_int32(stop) != TRUE)
+    {
+        /* Wait for the syscall loop to hand back a slot, unless the
+           last one crashed and still needs generating. */
+        if(args->test == NULL &&
+           ck_ring_dequeue_spsc(child->free_ring, child->free_buffer, &args->test) == false)
+        {
+            (void)sched_yield();
+            continue;
+        }
+
+        struct test_case *test = args->test;
+
+        /* Generate straight into the slot's arrays. */
+        scratch.arg_value_array = test->arg_value_array;
+        scratch.arg_size_array = test->arg_size_array;
+        scratch.arg_handle_array = test->arg_handle_array;
+
+        epoch_start(thread, allocator, output);
+
+        /* Clean up the test case that last ran out of this slot, a slot
+           that hasn't been used yet has no arguments. */
+        if(test->total_args > 0)
+        {
+            scratch.syscall_number = test->syscall_number;
+            scratch.total_args = test->total_args;
+
+            rtrn = free_old_arguments(&scratch, output, allocator, args->rsrc_gen);
+            if(rtrn < 0)
+            {
+                output->write(ERROR, "Can't cleanup old arguments\n");
+                exit_child(thread, allocator, output);
+            }
+
+            /* Don't free them twice if generating crashes. */
+            test->total_args = 0;
+        }
+
+        memset(test->arg_size_array, 0, sizeof(test->arg_size_array));
+
+        set_generate_arena(&test->arena);
+
+        rtrn = generate_test_case(&scratch, output, args->random);
+        if(rtrn < 0)
+        {
+            output->write(ERROR, "Can't generate test case\n");
+            exit_child(thread, allocator, output);
+        }
+
+        epoch_stop(thread, allocator);
+
+        test->syscall_number = scratch.syscall_number;
+        test->syscall_symbol = scratch.syscall_symbol;
+        test->syscall_name = scratch.syscall_name;
+        test->total_args = scratch.total_args;
+        test->need_alarm = scratch.need_alarm;
+
+        clear_unused_arguments(test);
+
+        args->test = NULL;
+
+        (void)ck_ring_enqueue_spsc(child->ready_ring, child->ready_buffer, test);
+    }
+
+    flush_resource_cache();
+
+    return (NULL);
+}
+
+/* Create the test case slots and start the thread that fills them, so argument
+   generation overlaps with the syscall loop running syscalls. */
+static int32_t start_producer(struct child_ctx *child,
+                              struct memory_allocator *allocator,
+                              struct output_writter *output,
+                              struct resource_generator *rsrc_gen,
+                              struct random_generator *random)
+{
+    uint32_t i;
+    int32_t rtrn = 0;
+    pthread_t thread;
+    struct test_case *slab = NULL;
+
+    /* Only this child and it's producer use the rings, so create them after the
+       fork. The child is pinned by now and first touch puts the pages on it's node. */
+    child->ready_ring = allocator->shared(sizeof(ck_ring_t));
+    child->free_ring = allocator->shared(sizeof(ck_ring_t));
+    child->ready_buffer = allocator->shared(TEST_CASE_RING_SIZE * sizeof(ck_ring_buffer_t));
+    child->free_buffer = allocator->shared(TEST_CASE_RING_SIZE * sizeof(ck_ring_buffer_t));
+    if(child->ready_ring == NULL || child->free_ring == NULL ||
+       child->ready_buffer == NULL || child->free_buffer == NULL)
+    {
+        output->write(ERROR, "Can't create test case rings\n");
+        return (-1);
+    }
+
+    ck_ring_init(child->ready_ring, TEST_CASE_RING_SIZE);
+    ck_ring_init(child->free_ring, TEST_CASE_RING_SIZE);
+
+    child->current_case = NULL;
+
+    /* One mapping holds every slot, it's page aligned and zeroed. It's created
+       after the fork so only this child and it's producer see it. A ring holds
+       one less than it's size, so that's how many slots we make. */
+    slab = allocator->shared((TEST_CASE_RING_SIZE - 1) * sizeof(struct test_case));
+    if(slab == NULL)
+    {
+        output->write(ERROR, "Can't allocate test case slab\n");
+        return (-1);
+    }
+
+    for(i = 0; i < TEST_CASE_RING_SIZE - 1; i++)
+    {
+        struct test_case *test = &slab[i];
+
+        (void)mem_arena_init(&test->arena, test->value_payload, ARG_PAYLOAD_LEN);
+
+        (void)ck_ring_enqueue_spsc(child->free_ring, child->free_buffer, test);
+    }
+
+    producer.child = child;
+    producer.allocator = allocator;
+    producer.output = output;
+    producer.random = random;
+    producer.rsrc_gen = rsrc_gen;
+
+    rtrn = pthread_create(&thread, NULL, test_case_producer, &producer);
+    if(rtrn != 0)
+    {
+        output->write(ERROR, "Can't create producer thread: %s\n", strerror(rtrn));
+        return (-1);
+    }
+
+    return (0);
+}
+
 static struct syscall_table *build_syscall_table(struct output_writter *output, struct memory_allocator *allocator)
 {
     struct syscall_table *table = NULL;
@@ -526,8 +1084,6 @@ static struct syscall_table *build_syscall_table(struct output_writter *output,
     {
         struct syscall_entry *entry = table->sys_entry[i];
         uint32_t total_args = entry->total_args;
-        set_test_syscall(entry, entry->id);
-        entry->status = ON;
 
         for(counter = 0; counter < total_args; counter++)
         {
@@ -562,16 +1118,13 @@ struct syscall_table *get_syscall_table(struct output_writter *output, struct me
 /* This function is used to randomly pick the syscall to test. */
 int32_t pick_syscall(struct child_ctx *child, struct random_generator *random, struct output_writter *output)
 {
-    /* Use rand_range to pick a number between 0 and the number_of_syscalls. The minus one
-    is a hack, get_syscall_table() returns an array - 1 the size of number of syscalls
-    and should be fixed. */
-
     uint32_t num = 0;
 
-    int32_t rtrn = random->range(sys_table->total_syscalls - 1, &num);
+    /* Weighted pick from the syscalls that are on, useless ones have no weight. */
+    int32_t rtrn = select_syscall(random, &num, output);
     if(rtrn < 0)
     {
-        output->write(ERROR, "Can't generate random number\n");
+        output->write(ERROR, "Can't select syscall\n");
         return (-1);
     }
 
@@ -605,18 +1158,13 @@ int32_t generate_arguments(struct child_ctx *ctx, struct output_writter *output)
             return (-1);
         }
 
-        /* Generate the argument. */
+        /* Generate the argument, the copy is made for the whole test case at once. */
         rtrn = entry->get_arg_array[i](&ctx->arg_value_array[i], ctx);
         if(rtrn < 0)
         {
             output->write(ERROR, "Can't generate arguments for: %s\n", entry->syscall_name);
             return (-1);
         }
-
-        /* Copy the argument into the argument copy array. */
-        memcpy(ctx->arg_copy_array[i],
-               ctx->arg_value_array[i],
-               ctx->arg_size_array[i]);
     }
 
     return (0);
@@ -630,14 +1178,63 @@ static int32_t check_for_failure(int32_t ret_value)
     return (0);
 }
 
+/* Pick how long to let a blocking syscall run, a few deviations above it's
+   usual latency but never longer than the entry allows. */
+static uint64_t syscall_timeout(struct syscall_entry *entry, uint32_t syscall_number)
+{
+    uint64_t timeout = 0;
+    uint64_t limit = DEFAULT_TIMEOUT_US;
+    struct syscall_latency *stats = &latency[syscall_number];
+
+    if(entry->timeout_us != 0)
+        limit = entry->timeout_us;
+
+    if(stats->samples < TIMEOUT_SAMPLES)
+        return (limit);
+
+    timeout = stats->mean + (4 * stats->deviation);
+
+    if(timeout < MIN_TIMEOUT_US)
+        timeout = MIN_TIMEOUT_US;
+
+    if(timeout > limit)
+        timeout = limit;
+
+    return (timeout);
+}
+
+/* Add the latency of a blocking syscall that returned on it's own, calls the
+   timer interrupted never get here so they don't drag the estimate up. */
+static void record_latency(uint32_t syscall_number, uint64_t usec)
+{
+    struct syscall_latency *stats = &latency[syscall_number];
+
+    if(stats->samples == 0)
+    {
+        stats->mean = usec;
+        stats->deviation = usec / 2;
+    }
+    else
+    {
+        uint64_t diff = (usec > stats->mean) ? usec - stats->mean : stats->mean - usec;
+
+        stats->deviation = stats->deviation - (stats->deviation / 4) + (diff / 4);
+        stats->mean = stats->mean - (stats->mean / 8) + (usec / 8);
+    }
+
+    if(stats->samples < TIMEOUT_SAMPLES)
+        stats->samples++;
+
+    return;
+}
+
 int32_t test_syscall(struct child_ctx *ctx, struct output_writter *output)
 {
-    /* Check if we need to set the alarm for blocking syscalls.  */
-    if(ctx->need_alarm == NX_YES)
-        alarm(1);
+    struct timespec start;
+    struct timespec end;
 
     /* Get a copy of the syscall entry for the syscall we are testing.
-       We need this to lookup the test_syscall() function. */
+       We need this to know which arguments are pointers. */
     struct syscall_entry *entry = get_entry(ctx->syscall_number);
     if(entry == NULL)
     {
@@ -646,25 +1243,67 @@ int32_t test_syscall(struct child_ctx *ctx, struct output_writter *output)
     }
 
     /* Do the add before the syscall test because we usually crash on the syscall test
-    and we don't wan't to do this in a signal handler. */
-    atomic_add_uint32(state->test_counter, 1);
+    and we don't wan't to do this in a signal handler. We are the only writer so a
+    plain store is enough, no need for a locked add. */
+    atomic_store_uint64(&ctx->test_count, ctx->test_count + 1);
 
     /* Set the time of the syscall test. */
     (void)gettimeofday(&ctx->time_of_syscall, NULL);
 
-    /* Keep a reference of test syscall so we can cleanup entry before
-     running test_syscall(). test_syscall() may crash so this allows us
-     to free the syscall entry before and avoid a memory leak. */
-    ctx->test_syscall = entry->test_syscall;
+    /* Start the timer for blocking syscalls, if it goes off we jump
+       back to the syscall loop like we do on a crash. */
+    if(ctx->need_alarm == NX_YES)
+    {
+        (void)clock_gettime(CLOCK_MONOTONIC, &start);
+        arm_syscall_timer(syscall_timeout(entry, ctx->syscall_number));
+    }
+
+    /* In smart mode only count the coverage of the syscall itself. */
+    if(mode == TRUE)
+    {
+        coverage_reset(ctx->trace);
+        start_kernel_coverage(ctx->probe_handle);
+    }
 
     /* Call the syscall with the args generated. */
-    ctx->ret_value = ctx->test_syscall(ctx->syscall_symbol, ctx->arg_value_array);
+    ctx->ret_value = dispatch_syscall(ctx->syscall_symbol, entry->ptr_args, ctx->arg_value_array);
+
+    /* Grab errno before the timer calls can change it. */
+    int32_t error = errno;
+
+    /* Collect the kernel's coverage before anything else we do adds to it. */
+    if(mode == TRUE)
+        (void)collect_kernel_coverage(ctx->probe_handle, ctx->trace);
+
+    if(ctx->need_alarm == NX_YES)
+    {
+        disarm_syscall_timer();
+
+        (void)clock_gettime(CLOCK_MONOTONIC, &end);
+        record_latency(ctx->syscall_number,
+                       (uint64_t)((end.tv_sec - start.tv_sec) * 1000000 +
+                                  (end.tv_nsec - start.tv_nsec) / 1000));
+    }
+
     if(check_for_failure(ctx->ret_value) < 0)
     {
         /* Set the error flag so the logging system knows we had an error. */
         ctx->had_error = NX_YES;
     }
 
+    /* Let the selector know how it went. */
+    record_syscall_result(ctx->syscall_number, ctx->ret_value, error);
+
+    /* Reward syscalls that reach parts of the kernel no child has reached before. */
+    if(mode == TRUE)
+    {
+        uint32_t new_edges = 0;
+
+        coverage_classify(ctx->trace);
+        if(coverage_has_new_bits(ctx->trace, virgin_map, &new_edges) == COVERAGE_NEW_EDGES)
+            record_syscall_coverage(ctx->syscall_number, new_edges);
+    }
+
     return (0);
 }
 
@@ -689,7 +1328,8 @@ void kill_all_children(struct output_writter *output)
 }
 
 /**
- * This is the fuzzing loop for syscall fuzzing in dumb mode.
+ * This is the fuzzing loop for syscall fuzzing. In smart mode test_syscall()
+ * also feeds the kernel's coverage back to the syscall selector.
  */
 NX_NO_RETURN static void start_syscall_child(struct thread_ctx *thread,
                                              struct memory_allocator *allocator,
@@ -710,8 +1350,42 @@ NX_NO_RETURN static void start_syscall_child(struct thread_ctx *thread,
         exit_child(thread, allocator, output);
     }
 
-    /* Set the return jump so that we can try fuzzing again on a signal. */
-    rtrn = setjmp(child->return_jump);
+    /* Latency estimates for the blocking syscalls, indexed by syscall number. */
+    latency = allocator->alloc((sys_table->total_syscalls + 1) * sizeof(struct syscall_latency));
+    if(latency == NULL)
+    {
+        output->write(ERROR, "Can't allocate latency table\n");
+        exit_child(thread, allocator, output);
+    }
+
+    memset(latency, 0, (sys_table->total_syscalls + 1) * sizeof(struct syscall_latency));
+
+    /* Per child results and the alias table we pick syscalls from. */
+    rtrn = setup_syscall_selector(allocator, output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't setup syscall selector\n");
+        exit_child(thread, allocator, output);
+    }
+
+    rtrn = create_syscall_timer(output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't create syscall timer\n");
+        exit_child(thread, allocator, output);
+    }
+
+    /* Start generating test cases in the background. */
+    rtrn = start_producer(child, allocator, output, rsrc_gen, random);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't start test case producer\n");
+        exit_child(thread, allocator, output);
+    }
+
+    /* Set the return jump so that we can try fuzzing again on a signal. Save the
+       signal mask too, or the signal we jump out of stays blocked after the jump. */
+    rtrn = sigsetjmp(child->return_jump, 1);
     if(rtrn < 0)
     {
         output->write(ERROR, "Can't set return jump\n");
@@ -721,6 +1395,15 @@ NX_NO_RETURN static void start_syscall_child(struct thread_ctx *thread,
     /* Check to see if we jumped back from the signal handler. */
     if(atomic_load_int32(&child->did_jump) == NX_YES)
     {
+        /* A crash can beat the timer, don't let it go off in the next syscall. */
+        disarm_syscall_timer();
+
+        /* Timeouts are just slow, only real crashes make a syscall more interesting. */
+        if(child->sig_num == SIGALRM)
+            record_syscall_result(child->syscall_number, 0, 0);
+        else
+            record_syscall_crash(child->syscall_number);
+
         /* Start an epoch protected section. */
         epoch_start(thread, allocator, output);
 
@@ -732,13 +1415,12 @@ NX_NO_RETURN static void start_syscall_child(struct thread_ctx *thread,
             exit_child(thread, allocator, output);
         }
 
-        /* Clean up our old mess. */
-        rtrn = free_old_arguments(child, output, allocator, rsrc_gen);
-        if(rtrn < 0)
-        {
-            output->write(ERROR, "Can't cleanup old arguments\n");
-            exit_child(thread, allocator, output);
-        }
+        /* The producer cleans up our old mess when it reuses the slot. */
+        finish_test_case(child);
+
+        /* The syscall that crashed still counts as part of the program. */
+        child->program_call++;
+        set_did_jump(child, NX_NO);
 
         epoch_stop(thread, allocator);
     }
@@ -748,10 +1430,21 @@ NX_NO_RETURN static void start_syscall_child(struct thread_ctx *thread,
     /* Check if we should stop or continue running. */
     while(atomic_load_int32(stop) != TRUE)
     {
+        /* Start a new program once the last one has run all it's syscalls. */
+        if(child->program_call >= child->program_length)
+        {
+            rtrn = start_program(child, random, output);
+            if(rtrn < 0)
+            {
+                output->write(ERROR, "Can't start program\n");
+                exit_child(thread, allocator, output);
+            }
+        }
+
         epoch_start(thread, allocator, output);
 
-        /* Generate mutated syscall arguments for a randomly chosen syscall. */
-        rtrn = generate_test_case(child, thread, output, allocator, random);
+        /* Grab the next mutated syscall and arguments from the producer thread. */
+        rtrn = next_test_case(child, thread, output, allocator, random);
         if(rtrn < 0)
         {
             output->write(ERROR, "Syscall call failed\n");
@@ -769,6 +1462,9 @@ NX_NO_RETURN static void start_syscall_child(struct thread_ctx *thread,
             exit_child(thread, allocator, output);
         }
 
+        /* Hold on to any resource the syscall created for the rest of the program. */
+        record_result(child);
+
         rtrn = log_results(child->had_error, child->ret_value, strsignal(child->sig_num));
         if(rtrn < 0)
         {
@@ -776,9 +1472,11 @@ NX_NO_RETURN static void start_syscall_child(struct thread_ctx *thread,
             exit_child(thread, allocator, output);
         }
 
-        /* If we didn't crash, cleanup are mess. If we don't do this the generate
-        functions will crash in a hard to understand way. */
-        free_old_arguments(child, output, allocator, rsrc_gen);
+        /* Hand the slot back, the producer frees it's arguments before
+        generating into it again so every resource is freed on one thread. */
+        finish_test_case(child);
+
+        child->program_call++;
     }
 
     /* We should not get here, but if we do, exit so we can be restarted. */
@@ -791,13 +1489,8 @@ NX_NO_RETURN static void start_child_loop(struct thread_ctx *thread,
                                           struct resource_generator *rsrc_gen,
                                           struct random_generator *random)
 {
-    /* If were in dumb mode start the dumb syscall loop. */
-    if(mode != TRUE)
-    {
-        start_syscall_child(thread, allocator, output, rsrc_gen, random);
-    }
-
-    start_smart_syscall_child(thread, allocator, output);
+    /* Both modes share the loop, smart mode differs in test_syscall(). */
+    start_syscall_child(thread, allocator, output, rsrc_gen, random);
 }
 
 static void init_syscall_child(uint32_t i,
@@ -820,8 +1513,8 @@ static void init_syscall_child(uint32_t i,
     /* Check if we are in smart mode. */
     if(mode == TRUE)
     {
-        /* Inject probes into the kernel. */
-        rtrn = inject_kernel_probes(children[i]->probe_handle);
+        /* Inject probes into the kernel, tracing follows this thread. */
+        rtrn = inject_kernel_probes(&children[i]->probe_handle, allocator, output);
         if(rtrn < 0)
         {
             output->write(ERROR, "Can't init child probes\n");
@@ -858,6 +1551,19 @@ NX_NO_RETURN static void start_child(uint32_t i,
     start_child_loop(thread, allocator, output, rsrc_gen, random);
 }
 
+/* Pin the child in slot i to a CPU so children don't migrate between sockets. The memory
+   the child allocates from here on is first touched on that CPU's node. */
+static void place_child(uint32_t i, struct output_writter *output)
+{
+    if(set_child_affinity(i % total_cpus, output) < 0)
+    {
+        output->write(ERROR, "Can't pin child to CPU, running unpinned\n");
+        return;
+    }
+
+    return;
+}
+
 static int32_t create_child(struct thread_ctx *thread,
                             struct memory_allocator *allocator,
                             struct output_writter *output,
@@ -907,6 +1613,12 @@ static int32_t create_child(struct thread_ctx *thread,
         pid = fork();
         if(pid == 0)
         {
+            /* Remember our slot so we never have to search for it. */
+            child_index = (int32_t)i;
+
+            /* The slot may still point at probes from the child we replaced. */
+            children[i]->probe_handle = NULL;
+
             /* Set the child pid and increment the running child counter. Do this
             right away so we can let the parent continue as soon as possible. */
             cas_loop_int32(&children[i]->pid, getpid());
@@ -920,6 +1632,8 @@ static int32_t create_child(struct thread_ctx *thread,
                 exit_child(thread, allocator, output);
             }
 
+            place_child(i, output);
+
             /* Start child process's loop. */
             start_child(i, allocator, output, rsrc_gen, random);
         }
@@ -939,6 +1653,14 @@ static int32_t create_child(struct thread_ctx *thread,
             (void)close(fd[0]);
             (void)close(fd[1]);
 
+            /* So the reaper can find the child's slot without a search. */
+            rtrn = add_child_pid(pid, i);
+            if(rtrn < 0)
+            {
+                output->write(ERROR, "Can't add child to the pid map\n");
+                return (-1);
+            }
+
             return (0);
         }
         else
@@ -951,6 +1673,31 @@ static int32_t create_child(struct thread_ctx *thread,
     return (0);
 }
 
+/* Wait on every child that has exited and free up it's slot. */
+static void reap_children(void)
+{
+    pid_t pid = 0;
+    int32_t status = 0;
+
+    while((pid = waitpid(-1, &status, WNOHANG)) > 0)
+    {
+        struct child_ctx *child = NULL;
+
+        child = get_child_ctx_from_pid(pid);
+        if(child == NULL)
+            continue;
+
+        remove_child_pid(pid);
+
+        /* Children that exit normally go through exit_child() and
+          empty their slot themselves, the ones killed by a signal don't. */
+        if(atomic_cas_int32(&child->pid, pid, EMPTY) == true)
+            atomic_dec_uint32(&state->running_children);
+    }
+
+    return;
+}
+
 void start_main_syscall_loop(struct thread_ctx *thread,
                              struct memory_allocator *allocator,
                              struct output_writter *output,
@@ -973,7 +1720,7 @@ void start_main_syscall_loop(struct thread_ctx *thread,
     while(atomic_load_int32(stop) == FALSE)
     {
         /* Check if we have the right number of children processes running, if not create a new ones until we do. */
-        if(atomic_load_uint32(&state->running_children) < total_children)
+        while(atomic_load_uint32(&state->running_children) < total_children)
         {
             /* Create children process. */
             rtrn = create_child(thread, allocator, output, rsrc_gen, random);
@@ -983,8 +1730,20 @@ void start_main_syscall_loop(struct thread_ctx *thread,
                 return;
             }
         }
+
+        /* Sleep until a child exits, the timeout is only there so we notice stop being set. */
+        rtrn = wait_for_child_exit(STOP_CHECK_INTERVAL, output);
+        if(rtrn < 0)
+        {
+            output->write(ERROR, "Can't wait for children\n");
+            return;
+        }
+
+        reap_children();
     }
 
+    output->write(STD, "Ran %llu syscall tests\n", (unsigned long long)get_test_count());
+
     output->write(STD, "Exiting main loop\n");
 }
 
@@ -1003,74 +1762,51 @@ static struct child_ctx *init_child_context(struct output_writter *output, struc
     /* Set current arg to zero. */
     child->current_arg = 0;
 
-    /* Create the index where we store the syscall arguments. */
-    child->arg_value_array = allocator->shared(ARG_LIMIT * sizeof(uint64_t *));
-    if(child->arg_value_array == NULL)
-    {
-        output->write(ERROR, "Can't create arg value index: %s\n", strerror(errno));
-        allocator->free_shared((void **)&child, sizeof(struct child_ctx));
-        return (NULL);
-    }
+    /* NX_YES is zero, so make sure the child doesn't think it jumped on start up. */
+    child->did_jump = NX_NO;
 
-    /* This index tracks the size of the argument generated.  */
-    child->arg_size_array = allocator->shared(ARG_LIMIT * sizeof(uint64_t));
-    if(child->arg_size_array == NULL)
-    {
-        output->write(ERROR, "Can't create arg size index: %s\n", strerror(errno));
-        allocator->free_shared((void **)&child->arg_value_array, ARG_LIMIT * sizeof(uint64_t *));
-        allocator->free_shared((void **)&child, sizeof(struct child_ctx));
-        return (NULL);
-    }
+    /* The test case rings are created by the child, see start_producer(). */
+    child->ready_ring = NULL;
+    child->free_ring = NULL;
+    child->ready_buffer = NULL;
+    child->free_buffer = NULL;
 
-    child->arg_copy_array = allocator->shared(ARG_LIMIT * sizeof(uint64_t *));
-    if(child->arg_copy_array == NULL)
-    {
-        output->write(ERROR, "Can't create arg copy index: %s\n", strerror(errno));
-        allocator->free_shared((void **)&child->arg_size_array, ARG_LIMIT * sizeof(uint64_t));
-        allocator->free_shared((void **)&child->arg_value_array, ARG_LIMIT * sizeof(uint64_t *));
-        allocator->free_shared((void **)&child, sizeof(struct child_ctx));
-        return (NULL);
-    }
+    /* The argument arrays belong to the test case slots, the child is pointed
+       at the slot it's running by next_test_case(). */
+    child->arg_value_array = NULL;
+    child->arg_size_array = NULL;
+    child->arg_handle_array = NULL;
 
-    uint32_t i = 0;
+    return (child);
+}
 
-    /* Loop and create the various arrays in the child struct. */
-    for(i = 0; i < ARG_LIMIT; i++)
-    {
-        child->arg_value_array[i] = allocator->shared(ARG_BUF_LEN);
-        if(child->arg_value_array[i] == NULL)
-        {
-            output->write(ERROR, "Can't create arg value\n");
-            /* Still potentially leaking memory from the indicies
-             in the arg_value_array, ie if malloc fails on the second
-             or higher iteration. */
-            allocator->free_shared((void **)&child->arg_copy_array, ARG_LIMIT * sizeof(uint64_t *));
-            allocator->free_shared((void **)&child->arg_size_array, ARG_LIMIT * sizeof(uint64_t));
-            allocator->free_shared((void **)&child->arg_value_array, ARG_LIMIT * sizeof(uint64_t *));
-            allocator->free_shared((void **)&child, sizeof(struct child_ctx));
-            return (NULL);
-        }
+uint64_t get_test_count(void)
+{
+    uint32_t i;
+    uint64_t total = 0;
 
-        child->arg_copy_array[i] = allocator->shared(ARG_BUF_LEN);
-        if(child->arg_copy_array[i] == NULL)
-        {
-            output->write(ERROR, "Can't create arg copy value\n");
-            /* Still potentially leaking memory from the indicies
-             in the arg_copy_array, ie if malloc fails on the second
-             or higher iteration. */
-            allocator->free_shared((void **)&child->arg_copy_array, ARG_LIMIT * sizeof(uint64_t *));
-            allocator->free_shared((void **)&child->arg_size_array, ARG_LIMIT * sizeof(uint64_t));
-            allocator->free_shared((void **)&child->arg_value_array, ARG_LIMIT * sizeof(uint64_t *));
-            allocator->free_shared((void **)&child, sizeof(struct child_ctx));
-            return (NULL);
-        }
-    }
+    /* Slots keep their count when a child is replaced so nothing is lost. */
+    for(i = 0; i < total_children; i++)
+        total += atomic_load_uint64(&children[i]->test_count);
 
-    return (child);
+    return (total);
+}
+
+void set_syscall_jobs(uint32_t jobs)
+{
+    requested_jobs = jobs;
+
+    return;
+}
+
+void set_syscall_selection(struct syscall_selection *selection)
+{
+    requested_selection = (*selection);
+
+    return;
 }
 
 int32_t setup_syscall_module(int32_t *stop_ptr,
-                             uint32_t *counter,
                              int32_t run_mode,
                              epoch_ctx *e,
                              struct memory_allocator *allocator,
@@ -1079,15 +1815,17 @@ int32_t setup_syscall_module(int32_t *stop_ptr,
     uint32_t i = 0;
     int32_t rtrn = 0;
 
-    /* Grab the core count of the machine we are on and set the number
-    of syscall children to the core count. */
-    rtrn = get_core_count(&total_children);
+    /* Grab the core count of the machine we are on, we pin children across these. */
+    rtrn = get_core_count(&total_cpus);
     if(rtrn < 0)
     {
         output->write(ERROR, "Can't get core count\n");
         return (-1);
     }
 
+    /* Run the number of children the user asked for, or one per core. */
+    total_children = (requested_jobs > 0) ? requested_jobs : total_cpus;
+
     /* Grab the syscall table for the system we are on. */
     sys_table = get_syscall_table(output, allocator);
     if(sys_table == NULL)
@@ -1096,6 +1834,14 @@ int32_t setup_syscall_module(int32_t *stop_ptr,
         return (-1);
     }
 
+    /* Turn syscalls on and off and weight them like the user asked. */
+    rtrn = setup_syscall_selection(sys_table, &requested_selection, allocator, output);
+    if(rtrn < 0)
+    {
+        output->write(ERROR, "Can't setup syscall selection\n");
+        return (-1);
+    }
+
     state = allocator->shared(sizeof(struct global_state));
     if(state == NULL)
     {
@@ -1106,6 +1852,14 @@ int32_t setup_syscall_module(int32_t *stop_ptr,
      /* Set running children to zero. */
     atomic_store_uint32(&state->running_children, 0);
 
+    /* Map of child PIDs to slots, sized so it never has to grow. */
+    if(ck_ht_init(&pid_map, CK_HT_MODE_DIRECT, NULL, &pid_map_allocator,
+                  total_children * 2, (uint64_t)getpid()) == false)
+    {
+        output->write(ERROR, "Can't create pid map\n");
+        return (-1);
+    }
+
     /* Create the child process structures. */
     children = allocator->shared(total_children * sizeof(struct child_ctx *));
     if(children == NULL)
@@ -1131,11 +1885,42 @@ int32_t setup_syscall_module(int32_t *stop_ptr,
         children[i] = child;
     }
 
+    /* In smart mode the children share one virgin map of the kernel edges. */
+    if(run_mode == TRUE)
+    {
+        rtrn = check_kernel_probes(output);
+        if(rtrn < 0)
+        {
+            output->write(ERROR, "Can't use kernel probes\n");
+            return (-1);
+        }
+
+        /* Pick the fastest map comparison this processor can run. */
+        setup_coverage_module();
+
+        virgin_map = coverage_create_map(0xFF, allocator, output);
+        if(virgin_map == NULL)
+        {
+            output->write(ERROR, "Can't create virgin map\n");
+            return (-1);
+        }
+
+        /* Each child gets it's own trace map. */
+        for(i = 0; i < total_children; i++)
+        {
+            children[i]->trace = coverage_create_map(0, allocator, output);
+            if(children[i]->trace == NULL)
+            {
+                output->write(ERROR, "Can't create trace map\n");
+                return (-1);
+            }
+        }
+    }
+
     /* Set file scope variables. */
     stop = stop_ptr;
     mode = run_mode;
     epoch = e;
-    state->test_counter = counter;
 
     /* Now set the table set flag. */
     table_set = TRUE;
@@ -36,6 +36,8 @@
 
 struct child_ctx;
 
+struct syscall_selection;
+
 enum child_state {EMPTY};
 
 /**
@@ -52,6 +54,12 @@ extern struct child_ctx *get_child(struct output_writter *output);
 
 extern struct child_ctx *get_child_ctx_from_pid(pid_t pid);
 
+/**
+*    Returns the calling child process's context object without a lookup,
+*    so it's safe to use from a signal handler. Returns NULL in the parent.
+*/
+extern struct child_ctx *get_current_child(void);
+
 extern struct syscall_table *get_syscall_table(struct output_writter *output, struct memory_allocator *allocator);
 
 extern void cleanup_syscall_table(struct syscall_table **table, struct memory_allocator *allocator);
@@ -64,6 +72,18 @@ extern int32_t test_syscall(struct child_ctx *ctx, struct output_writter *output
 
 extern void jump(struct child_ctx *child);
 
+/**
+*    Returns TRUE when called from this child's test case producer thread.
+*    Safe to use from a signal handler.
+*/
+extern int32_t on_producer_thread(void);
+
+/**
+*    Jump back to the producer thread's loop, it throws away the test case it
+*    was generating. Only call this on the producer thread.
+*/
+extern void producer_jump(void);
+
 extern void set_child_pid(struct child_ctx *child, int32_t pid);
 
 extern void set_had_error(struct child_ctx *child, int32_t val);
@@ -80,15 +100,39 @@ extern int32_t get_arg_size(struct child_ctx *child, uint32_t arg_num, uint64_t
 
 extern uint32_t get_current_arg(struct child_ctx *child);
 
+/* Where the generator of the current argument keeps it's resource handle. */
+extern struct resource_handle *get_arg_handle(struct child_ctx *child);
+
 extern void kill_all_children(struct output_writter *output);
 
 extern struct syscall_entry *get_entry(uint32_t syscall_number);
 
+/**
+*    Returns the number of syscall tests run so far by every child,
+*    summed from the per child counters.
+*/
+extern uint64_t get_test_count(void);
+
+/**
+*    Set the number of child processes to fuzz with, call before setup_syscall_module().
+*    @param jobs The number of children, zero for one per core.
+*/
+extern void set_syscall_jobs(uint32_t jobs);
+
+/**
+*    Set which syscalls to run and how often, call before setup_syscall_module().
+*    The strings are not copied and must outlive the syscall module.
+*    @param selection The user's selection, see syscall/select.h.
+*/
+extern void set_syscall_selection(struct syscall_selection *selection);
+
+/**
+*    Setup the syscall module, call this before any other function in the module.
+*/
 extern int32_t setup_syscall_module(int32_t *stop_ptr,
-	                                  uint32_t *counter,
-	                                  int32_t run_mode,
-	                                  epoch_ctx *e,
-																		struct memory_allocator *allocator,
+                                    int32_t run_mode,
+                                    epoch_ctx *e,
+                                    struct memory_allocator *allocator,
                                     struct output_writter *output);
 
 extern void start_main_syscall_loop(struct thread_ctx *thread,
@@ -0,0 +1,43 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+#ifndef TIMEOUT_H
+#define TIMEOUT_H
+
+#include "io/io.h"
+#include <stdint.h>
+
+/* These are implemented in the platform specific syscall files. */
+
+/**
+ * Create the timer that interrupts blocking syscalls with SIGALRM. Timers are
+ * not inherited across fork() so each child creates it's own.
+ * @param output An output writter object.
+ * @return Zero on success and negative one on failure.
+ */
+extern int32_t create_syscall_timer(struct output_writter *output);
+
+/**
+ * Start the syscall timer, SIGALRM is sent if it's not disarmed in time.
+ * @param usec Microseconds until the timer goes off.
+ */
+extern void arm_syscall_timer(uint64_t usec);
+
+/**
+ * Stop the syscall timer if it's running.
+ */
+extern void disarm_syscall_timer(void);
+
+#endif
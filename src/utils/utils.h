@@ -33,6 +33,8 @@ enum name_type { DIR_NAME, FILE_NAME };
 
 #define NX_NO_RETURN __attribute__((noreturn))
 
+#define NX_CACHE_ALIGNED __attribute__((aligned(64)))
+
 int32_t run_syscall(int32_t number, ...);
 
 /**
@@ -0,0 +1,203 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+#include "unity.h"
+#include "io/io.h"
+#include "memory/memory.h"
+#include "coverage/coverage.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const enum coverage_kernel kernels[] = {COVERAGE_SCALAR, COVERAGE_SSE2, COVERAGE_AVX2};
+
+static uint8_t expected_bucket(uint32_t count)
+{
+    if(count < 4)
+        return ((uint8_t)count);
+    if(count < 8)
+        return (8);
+    if(count < 16)
+        return (16);
+    if(count < 32)
+        return (32);
+    if(count < 128)
+        return (64);
+
+    return (128);
+}
+
+static void test_classify(uint8_t *trace)
+{
+    uint32_t i;
+    uint32_t k;
+
+    for(k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+    {
+        /* Not every processor has every kernel. */
+        if(coverage_use_kernel(kernels[k]) < 0)
+            continue;
+
+        /* Every count, spread out so some blocks stay empty. */
+        coverage_reset(trace);
+        for(i = 0; i < 256; i++)
+            trace[i * 97] = (uint8_t)i;
+
+        coverage_classify(trace);
+
+        for(i = 0; i < 256; i++)
+            TEST_ASSERT_EQUAL_UINT8(expected_bucket(i), trace[i * 97]);
+
+        /* Nothing outside the counts we placed should change. */
+        TEST_ASSERT_EQUAL_UINT8(0, trace[1]);
+        TEST_ASSERT_EQUAL_UINT8(0, trace[COVERAGE_MAP_SIZE - 1]);
+    }
+}
+
+static void test_has_new_bits(uint8_t *trace, uint8_t *virgin)
+{
+    uint32_t k;
+    int32_t rtrn = 0;
+    uint32_t new_edges = 0;
+
+    for(k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+    {
+        if(coverage_use_kernel(kernels[k]) < 0)
+            continue;
+
+        memset(virgin, 0xFF, COVERAGE_MAP_SIZE);
+
+        /* An empty trace is never new. */
+        coverage_reset(trace);
+        rtrn = coverage_has_new_bits(trace, virgin, &new_edges);
+        TEST_ASSERT(rtrn == COVERAGE_NONE);
+        TEST_ASSERT_EQUAL_UINT32(0, new_edges);
+
+        trace[0] = 1;
+        trace[4097] = 2;
+        trace[COVERAGE_MAP_SIZE - 1] = 1;
+
+        rtrn = coverage_has_new_bits(trace, virgin, &new_edges);
+        TEST_ASSERT(rtrn == COVERAGE_NEW_EDGES);
+        TEST_ASSERT_EQUAL_UINT32(3, new_edges);
+
+        /* The same trace a second time. */
+        rtrn = coverage_has_new_bits(trace, virgin, &new_edges);
+        TEST_ASSERT(rtrn == COVERAGE_NONE);
+        TEST_ASSERT_EQUAL_UINT32(0, new_edges);
+
+        /* A known edge in a new bucket. */
+        trace[4097] = 8;
+        rtrn = coverage_has_new_bits(trace, virgin, &new_edges);
+        TEST_ASSERT(rtrn == COVERAGE_NEW_HITS);
+        TEST_ASSERT_EQUAL_UINT32(0, new_edges);
+
+        /* A new edge beats a new bucket. */
+        trace[4097] = 16;
+        trace[300] = 1;
+        rtrn = coverage_has_new_bits(trace, virgin, &new_edges);
+        TEST_ASSERT(rtrn == COVERAGE_NEW_EDGES);
+        TEST_ASSERT_EQUAL_UINT32(1, new_edges);
+
+        TEST_ASSERT_EQUAL_UINT8(0xFF & ~(2 | 8 | 16), virgin[4097]);
+    }
+}
+
+/* Every kernel should leave the virgin map the same way. */
+static void test_kernels_agree(uint8_t *trace, uint8_t *virgin)
+{
+    uint32_t i;
+    uint32_t k;
+    uint32_t round;
+
+    uint8_t *expected = malloc(COVERAGE_MAP_SIZE);
+    uint8_t *expected_trace = malloc(COVERAGE_MAP_SIZE);
+    uint8_t *sparse = malloc(COVERAGE_MAP_SIZE);
+    TEST_ASSERT_NOT_NULL(expected);
+    TEST_ASSERT_NOT_NULL(expected_trace);
+    TEST_ASSERT_NOT_NULL(sparse);
+
+    srand(1);
+
+    for(round = 0; round < 8; round++)
+    {
+        uint32_t expected_edges = 0;
+        int32_t expected_rtrn = 0;
+
+        memset(sparse, 0, COVERAGE_MAP_SIZE);
+        for(i = 0; i < 2048; i++)
+            sparse[(uint32_t)rand() % COVERAGE_MAP_SIZE] = (uint8_t)rand();
+
+        /* The scalar kernel is the reference. */
+        TEST_ASSERT(coverage_use_kernel(COVERAGE_SCALAR) == 0);
+        memset(expected, 0xFF, COVERAGE_MAP_SIZE);
+        memcpy(expected, sparse, COVERAGE_MAP_SIZE / 2);
+        memcpy(expected_trace, sparse, COVERAGE_MAP_SIZE);
+        coverage_classify(expected_trace);
+        expected_rtrn = coverage_has_new_bits(expected_trace, expected, &expected_edges);
+
+        for(k = 1; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+        {
+            uint32_t new_edges = 0;
+
+            if(coverage_use_kernel(kernels[k]) < 0)
+                continue;
+
+            memset(virgin, 0xFF, COVERAGE_MAP_SIZE);
+            memcpy(virgin, sparse, COVERAGE_MAP_SIZE / 2);
+            memcpy(trace, sparse, COVERAGE_MAP_SIZE);
+
+            coverage_classify(trace);
+            TEST_ASSERT(memcmp(trace, expected_trace, COVERAGE_MAP_SIZE) == 0);
+
+            TEST_ASSERT(coverage_has_new_bits(trace, virgin, &new_edges) == expected_rtrn);
+            TEST_ASSERT_EQUAL_UINT32(expected_edges, new_edges);
+            TEST_ASSERT(memcmp(virgin, expected, COVERAGE_MAP_SIZE) == 0);
+        }
+    }
+
+    free(expected);
+    free(expected_trace);
+    free(sparse);
+}
+
+int main(void)
+{
+    struct output_writter *output = get_console_writter();
+    struct memory_allocator *allocator = get_default_allocator();
+
+    TEST_ASSERT_NOT_NULL(output);
+    TEST_ASSERT_NOT_NULL(allocator);
+
+    uint8_t *trace = coverage_create_map(0, allocator, output);
+    TEST_ASSERT_NOT_NULL(trace);
+
+    uint8_t *virgin = coverage_create_map(0xFF, allocator, output);
+    TEST_ASSERT_NOT_NULL(virgin);
+    TEST_ASSERT_EQUAL_UINT8(0xFF, virgin[COVERAGE_MAP_SIZE - 1]);
+
+    test_classify(trace);
+
+    test_has_new_bits(trace, virgin);
+
+    test_kernels_agree(trace, virgin);
+
+    coverage_free_map(&trace, allocator);
+    coverage_free_map(&virgin, allocator);
+
+    setup_coverage_module();
+
+    return (0);
+}
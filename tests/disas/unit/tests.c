@@ -0,0 +1,194 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+#include "unity.h"
+#include "io/io.h"
+#include "disas/cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static const uint64_t blocks[] = {0x400000, 0x400010, 0x400024, 0x400100};
+
+static const uint64_t branches[] = {0x40000c, 0x400020};
+
+static const char strings[] = "\0main\0helper";
+
+static const struct analysis_function functions[] = {
+    {0x400000, 0x24, 1},
+    {0x400100, 0x10, 6}
+};
+
+static void make_key(struct analysis_key *key, uint64_t hash)
+{
+    memset(key, 0, sizeof(struct analysis_key));
+
+    key->hash = hash;
+    key->size = 4096;
+    key->build_id_size = 20;
+    memset(key->build_id, 0xAB, 20);
+}
+
+static struct analysis_header *make_analysis(const struct analysis_key *key, struct output_writter *output)
+{
+    struct analysis_header *analysis = create_analysis(key, blocks, 4, branches, 2,
+                                                       functions, 2, strings, sizeof(strings), output);
+    TEST_ASSERT_NOT_NULL(analysis);
+
+    analysis->main_address = 0x400000;
+    analysis->end_address = 0x400110;
+
+    return (analysis);
+}
+
+static void test_round_trip(struct output_writter *output)
+{
+    struct analysis_key key;
+
+    make_key(&key, 0x1122334455667788ULL);
+
+    /* Nothing is cached yet. */
+    TEST_ASSERT_NULL(load_analysis(&key, output));
+
+    struct analysis_header *analysis = make_analysis(&key, output);
+    TEST_ASSERT(save_analysis(analysis, output) == 0);
+
+    struct analysis_header *loaded = load_analysis(&key, output);
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT(loaded->image_size == analysis->image_size);
+    TEST_ASSERT(memcmp(loaded, analysis, (size_t)analysis->image_size) == 0);
+
+    TEST_ASSERT(loaded->main_address == 0x400000);
+    TEST_ASSERT(loaded->end_address == 0x400110);
+    TEST_ASSERT(loaded->total_blocks == 4);
+    TEST_ASSERT(memcmp(analysis_blocks(loaded), blocks, sizeof(blocks)) == 0);
+    TEST_ASSERT(loaded->total_branches == 2);
+    TEST_ASSERT(memcmp(analysis_branches(loaded), branches, sizeof(branches)) == 0);
+    TEST_ASSERT(loaded->total_functions == 2);
+    TEST_ASSERT_EQUAL_STRING("main", analysis_name(loaded, &analysis_functions(loaded)[0]));
+    TEST_ASSERT_EQUAL_STRING("helper", analysis_name(loaded, &analysis_functions(loaded)[1]));
+
+    munmap(loaded, (size_t)analysis->image_size);
+    free(analysis);
+}
+
+static void test_stale_key(struct output_writter *output)
+{
+    struct analysis_key key;
+    struct analysis_key other;
+
+    make_key(&key, 0x0102030405060708ULL);
+
+    struct analysis_header *analysis = make_analysis(&key, output);
+    TEST_ASSERT(save_analysis(analysis, output) == 0);
+
+    /* Same hash, so the same file, but a rebuilt target has a new build-id. */
+    memcpy(&other, &key, sizeof(struct analysis_key));
+    other.build_id[0] = 0xCD;
+    TEST_ASSERT_NULL(load_analysis(&other, output));
+
+    memcpy(&other, &key, sizeof(struct analysis_key));
+    other.size = 8192;
+    TEST_ASSERT_NULL(load_analysis(&other, output));
+
+    free(analysis);
+}
+
+static void test_damaged_cache(const char *dir, struct output_writter *output)
+{
+    struct analysis_key key;
+    char path[4096];
+
+    make_key(&key, 0xFEDCBA9876543210ULL);
+
+    struct analysis_header *analysis = make_analysis(&key, output);
+    TEST_ASSERT(save_analysis(analysis, output) == 0);
+
+    (void)snprintf(path, sizeof(path), "%s/%016llx.nxa", dir, (unsigned long long)key.hash);
+
+    /* A cache cut short must not be mapped and read past it's end. */
+    TEST_ASSERT(truncate(path, (off_t)(analysis->image_size - 8)) == 0);
+    TEST_ASSERT_NULL(load_analysis(&key, output));
+
+    /* Saving again replaces the damaged cache. */
+    TEST_ASSERT(save_analysis(analysis, output) == 0);
+
+    struct analysis_header *loaded = load_analysis(&key, output);
+    TEST_ASSERT_NOT_NULL(loaded);
+
+    munmap(loaded, (size_t)analysis->image_size);
+    (void)unlink(path);
+    free(analysis);
+}
+
+static void test_unsorted_cache(struct output_writter *output)
+{
+    struct analysis_key key;
+    char path[4096];
+    const uint64_t unsorted[] = {0x400000, 0x400100, 0x400024, 0x400010};
+
+    make_key(&key, 0x0F1E2D3C4B5A6978ULL);
+
+    struct analysis_header *analysis = create_analysis(&key, unsorted, 4, branches, 2,
+                                                       functions, 2, strings, sizeof(strings), output);
+    TEST_ASSERT_NOT_NULL(analysis);
+    TEST_ASSERT(save_analysis(analysis, output) == 0);
+
+    /* Block probes are found with a binary search, an unsorted cache is a miss. */
+    TEST_ASSERT_NULL(load_analysis(&key, output));
+
+    (void)snprintf(path, sizeof(path), "%s/%016llx.nxa", getenv(ANALYSIS_CACHE_ENV),
+                   (unsigned long long)key.hash);
+    (void)unlink(path);
+    free(analysis);
+}
+
+int main(void)
+{
+    char dir[] = "/tmp/nextgen_cache_XXXXXX";
+    char path[4096];
+    struct analysis_key key;
+
+    struct output_writter *output = get_console_writter();
+    TEST_ASSERT_NOT_NULL(output);
+
+    /* Keep the test's caches out of the real cache directory. */
+    TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+    TEST_ASSERT(setenv(ANALYSIS_CACHE_ENV, dir, 1) == 0);
+
+    test_round_trip(output);
+
+    test_stale_key(output);
+
+    test_damaged_cache(dir, output);
+
+    test_unsorted_cache(output);
+
+    /* Clean up the caches the tests left behind. */
+    make_key(&key, 0x1122334455667788ULL);
+    (void)snprintf(path, sizeof(path), "%s/%016llx.nxa", dir, (unsigned long long)key.hash);
+    (void)unlink(path);
+
+    make_key(&key, 0x0102030405060708ULL);
+    (void)snprintf(path, sizeof(path), "%s/%016llx.nxa", dir, (unsigned long long)key.hash);
+    (void)unlink(path);
+
+    TEST_ASSERT(rmdir(dir) == 0);
+
+    return (0);
+}
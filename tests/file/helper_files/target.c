@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* A persistent mode target for file-integration-test. It appends every test case
+   to the file in TARGET_LOG_ENV, one per line, and aborts on "crash". */
+
+#include "file/harness.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TARGET_LOG_ENV "NEXTGEN_TARGET_LOG"
+
+static int32_t log_fd;
+
+static int32_t test(const uint8_t *buf, uint64_t size)
+{
+    if(size == 5 && memcmp(buf, "crash", 5) == 0)
+        abort();
+
+    if(write(log_fd, buf, (size_t)size) != (ssize_t)size || write(log_fd, "\n", 1) != 1)
+        return (-1);
+
+    return (0);
+}
+
+int main(void)
+{
+    char *path = getenv(TARGET_LOG_ENV);
+    if(path == NULL)
+        return (1);
+
+    log_fd = open(path, O_WRONLY | O_APPEND);
+    if(log_fd < 0)
+        return (1);
+
+    if(nextgen_persistent_loop(&test) < 0)
+        return (1);
+
+    return (0);
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "unity.h"
+#include "io/io.h"
+#include "file/persistent.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Built from tests/file/helper_files/target.c next to this test. */
+#define TARGET_PATH "./persistent-test-target"
+
+#define TARGET_LOG_ENV "NEXTGEN_TARGET_LOG"
+
+/* More than PERSISTENT_SLOTS so the ring wraps around. */
+#define TOTAL_CASES 40
+
+static char log_path[] = "/tmp/nextgen_target_log_XXXXXX";
+
+/* Number of finished test cases whose trace we were handed. */
+static uint32_t traces_checked;
+
+static void count_trace(uint8_t *trace)
+{
+    (void)trace;
+    traces_checked++;
+}
+
+/* Remove the crash files the harness target leaves, return how many there were. */
+static uint32_t remove_crash_files(void)
+{
+    uint32_t total = 0;
+    char path[4096];
+    struct dirent *entry = NULL;
+
+    DIR *dir = opendir("/tmp");
+    TEST_ASSERT_NOT_NULL(dir);
+
+    while((entry = readdir(dir)) != NULL)
+    {
+        if(strncmp(entry->d_name, "crash_persistent_", 17) != 0)
+            continue;
+
+        (void)snprintf(path, sizeof(path), "/tmp/%s", entry->d_name);
+        (void)unlink(path);
+        total++;
+    }
+
+    (void)closedir(dir);
+
+    return (total);
+}
+
+static void test_persistent_round_trip(struct output_writter *output)
+{
+    uint32_t i;
+    char expected[4096];
+    char received[4096];
+    uint32_t offset = 0;
+    char buf[32];
+
+    memset(received, 0, sizeof(received));
+
+    uint8_t *traces = calloc(1, PERSISTENT_TRACE_SIZE);
+    TEST_ASSERT_NOT_NULL(traces);
+
+    set_persistent_coverage(traces, &count_trace);
+
+    TEST_ASSERT(start_persistent_target(TARGET_PATH, output) == 0);
+
+    for(i = 0; i < TOTAL_CASES; i++)
+    {
+        int32_t len = snprintf(buf, sizeof(buf), "case %u", i);
+
+        TEST_ASSERT(persistent_push(buf, (uint64_t)len, output) == 0);
+
+        offset += (uint32_t)snprintf(&expected[offset], sizeof(expected) - offset, "%s\n", buf);
+    }
+
+    /* The target dies on this one and is started again for the next. */
+    TEST_ASSERT(persistent_push("crash", 5, output) == 0);
+    TEST_ASSERT(persistent_push("after", 5, output) == 0);
+    offset += (uint32_t)snprintf(&expected[offset], sizeof(expected) - offset, "after\n");
+
+    TEST_ASSERT(persistent_drain(output) == 0);
+
+    stop_persistent_target();
+
+    /* Coverage is checked for every test case, the crash included. */
+    TEST_ASSERT(traces_checked == TOTAL_CASES + 2);
+    free(traces);
+
+    /* Every test case reached the target once and in order. */
+    FILE *log = fopen(log_path, "r");
+    TEST_ASSERT_NOT_NULL(log);
+    TEST_ASSERT(fread(received, 1, sizeof(received) - 1, log) == offset);
+    (void)fclose(log);
+
+    TEST_ASSERT_EQUAL_STRING(expected, received);
+
+    /* The crash was saved. */
+    TEST_ASSERT(remove_crash_files() == 1);
+
+    return;
+}
+
+int main(void)
+{
+    struct output_writter *output = get_console_writter();
+    TEST_ASSERT_NOT_NULL(output);
+
+    int32_t fd = mkstemp(log_path);
+    TEST_ASSERT(fd >= 0);
+    (void)close(fd);
+
+    TEST_ASSERT(setenv(TARGET_LOG_ENV, log_path, 1) == 0);
+
+    /* Don't count crash files from an earlier run. */
+    (void)remove_crash_files();
+
+    test_persistent_round_trip(output);
+
+    (void)unlink(log_path);
+
+    return (0);
+}
@@ -15,7 +15,9 @@
 
 #include "unity.h"
 #include "memory/memory.h"
+#include "runtime/platform.h"
 #include <pthread.h>
+#include <unistd.h>
 
 static uint32_t count = 1024;
 static uint32_t iterations = 100000;
@@ -72,7 +74,7 @@ static void test_shared_pool(void)
     uint32_t number_of_blocks = 0;
 
     /* Initialize and insert the objects we want to store into the pool. */
-    init_shared_pool(&pool, m_blk)
+    init_shared_pool(pool, m_blk)
     {
         TEST_ASSERT_NOT_NULL(pool);
         TEST_ASSERT_NOT_NULL(m_blk);
@@ -139,9 +141,209 @@ static void test_shared_pool(void)
 	  return;
 }
 
+/* The pool free_later() gives it's block back to. */
+static struct mem_pool_shared *small_pool;
+
+static void *free_later(void *arg)
+{
+    struct memory_block *m_blk = (struct memory_block *)arg;
+
+    /* Give the main thread time to go to sleep on the empty pool. */
+    usleep(10000);
+
+    mem_free_shared_block(m_blk, small_pool);
+
+    return (NULL);
+}
+
+static void test_shared_pool_exhaustion(void)
+{
+    uint32_t i;
+    uint32_t small_count = 8;
+    struct memory_block *blocks[8];
+    struct mem_pool_shared *pool = NULL;
+
+    pool = mem_create_shared_pool(sizeof(struct test_obj), small_count);
+    TEST_ASSERT_NOT_NULL(pool);
+
+    /* Take every block, each one only once. */
+    for(i = 0; i < small_count; i++)
+    {
+        blocks[i] = mem_try_get_shared_block(pool);
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+        TEST_ASSERT(blocks[i]->allocated == TRUE);
+    }
+
+    for(i = 1; i < small_count; i++)
+        TEST_ASSERT(blocks[i] != blocks[i - 1]);
+
+    /* An empty pool is an error instead of a spin. */
+    TEST_ASSERT_NULL(mem_try_get_shared_block(pool));
+
+    /* Give one back and we get the same one again. */
+    mem_free_shared_block(blocks[3], pool);
+    TEST_ASSERT(blocks[3]->allocated == FALSE);
+    TEST_ASSERT(mem_try_get_shared_block(pool) == blocks[3]);
+
+    /* The blocking get sleeps until another thread frees a block. */
+    pthread_t thread;
+    small_pool = pool;
+    TEST_ASSERT(pthread_create(&thread, NULL, free_later, blocks[5]) == 0);
+
+    struct memory_block *m_blk = mem_get_shared_block(pool);
+    TEST_ASSERT(m_blk == blocks[5]);
+
+    TEST_ASSERT(pthread_join(thread, NULL) == 0);
+
+    for(i = 0; i < small_count; i++)
+        mem_free_shared_block(blocks[i], pool);
+
+    mem_clean_shared_pool(pool);
+
+    return;
+}
+
+static void test_shared_pool_slab(void)
+{
+    uint32_t i;
+    uint32_t slab_count = 64;
+    struct memory_block *m_blk = NULL;
+    struct mem_pool_shared *pool = NULL;
+
+    pool = mem_create_shared_pool(sizeof(uint32_t), slab_count);
+    TEST_ASSERT_NOT_NULL(pool);
+
+    char *start = (char *)pool;
+    char *end = start + pool->map_size;
+
+    /* Every payload is inside the pool's one mapping, aligned and not overlapping the next. */
+    for(i = 0; i < slab_count; i++)
+    {
+        char *payload = (char *)pool->blocks[i].ptr;
+
+        TEST_ASSERT(payload >= (char *)&pool->blocks[slab_count]);
+        TEST_ASSERT(payload + sizeof(uint32_t) <= end);
+        TEST_ASSERT(((uintptr_t)payload % 16) == 0);
+
+        if(i > 0)
+        {
+            TEST_ASSERT(payload >= (char *)pool->blocks[i - 1].ptr + sizeof(uint32_t));
+        }
+    }
+
+    /* Payloads start zeroed and keep what's written to them. */
+    init_shared_pool(pool, m_blk)
+    {
+        TEST_ASSERT(*(uint32_t *)m_blk->ptr == 0);
+        *(uint32_t *)m_blk->ptr = m_blk->index;
+    }
+
+    for(i = 0; i < slab_count; i++)
+        TEST_ASSERT(*(uint32_t *)pool->blocks[i].ptr == i);
+
+    mem_clean_shared_pool(pool);
+
+    return;
+}
+
+static void test_shared_pool_retire(void)
+{
+    uint32_t i;
+    uint32_t retire_count = 4;
+    struct memory_block *blocks[4];
+    struct mem_pool_shared *pool = NULL;
+
+    pool = mem_create_shared_pool(sizeof(struct test_obj), retire_count);
+    TEST_ASSERT_NOT_NULL(pool);
+    TEST_ASSERT(pool->free_count == retire_count);
+
+    for(i = 0; i < retire_count; i++)
+        blocks[i] = mem_try_get_shared_block(pool);
+
+    TEST_ASSERT(pool->free_count == 0);
+    TEST_ASSERT_NULL(mem_get_retired_block(pool));
+
+    /* A retired block is given back but isn't handed out again. */
+    mem_retire_shared_block(blocks[1], pool);
+    TEST_ASSERT(pool->retired_count == 1);
+    TEST_ASSERT(blocks[1]->allocated == FALSE);
+    TEST_ASSERT_NULL(mem_try_get_shared_block(pool));
+
+    /* Until it's owner takes it off the retired stack and frees it. */
+    TEST_ASSERT(mem_get_retired_block(pool) == blocks[1]);
+    TEST_ASSERT(pool->retired_count == 0);
+    TEST_ASSERT_NULL(mem_get_retired_block(pool));
+
+    mem_free_shared_block(blocks[1], pool);
+    TEST_ASSERT(pool->free_count == 1);
+    TEST_ASSERT(mem_try_get_shared_block(pool) == blocks[1]);
+
+    mem_clean_shared_pool(pool);
+
+    return;
+}
+
+static void test_shared_pool_batch(void)
+{
+    uint32_t i;
+    uint32_t j;
+    uint32_t total = 0;
+    uint32_t batch_count = 8;
+    struct memory_block *blocks[8];
+    struct memory_block *more[8];
+    struct mem_pool_shared *pool = NULL;
+
+    pool = mem_create_shared_pool(sizeof(struct test_obj), batch_count);
+    TEST_ASSERT_NOT_NULL(pool);
+
+    /* Take most of the pool at once. */
+    total = mem_get_shared_blocks(pool, blocks, 5);
+    TEST_ASSERT(total == 5);
+    TEST_ASSERT(pool->free_count == batch_count - 5);
+
+    for(i = 0; i < total; i++)
+    {
+        TEST_ASSERT(blocks[i]->allocated == TRUE);
+
+        for(j = 0; j < i; j++)
+            TEST_ASSERT(blocks[i] != blocks[j]);
+    }
+
+    /* Asking for more than is left only gets what's left. */
+    total = mem_get_shared_blocks(pool, more, 5);
+    TEST_ASSERT(total == 3);
+    TEST_ASSERT(pool->free_count == 0);
+    TEST_ASSERT(mem_get_shared_blocks(pool, more, 5) == 0);
+
+    /* Retire the first batch at once and get it back off the retired stack. */
+    mem_retire_shared_blocks(blocks, 5, pool);
+    TEST_ASSERT(pool->retired_count == 5);
+
+    for(i = 0; i < 5; i++)
+    {
+        TEST_ASSERT(blocks[i]->allocated == FALSE);
+        TEST_ASSERT(mem_get_retired_block(pool) == blocks[i]);
+    }
+
+    TEST_ASSERT_NULL(mem_get_retired_block(pool));
+    TEST_ASSERT(pool->retired_count == 0);
+
+    mem_clean_shared_pool(pool);
+
+    return;
+}
+
 int main()
 {
     test_shared_pool();
 
+    test_shared_pool_exhaustion();
+
+    test_shared_pool_slab();
+
+    test_shared_pool_retire();
+
+    test_shared_pool_batch();
+
 	  return (0);
 }
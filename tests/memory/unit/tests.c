@@ -16,6 +16,8 @@
 #include "unity.h"
 #include "memory/memory.h"
 
+#include <string.h>
+
 static void test_default_memory_allocator(void)
 {
     struct memory_allocator *allocator = NULL;
@@ -37,9 +39,79 @@ static void test_default_memory_allocator(void)
     TEST_ASSERT_NOT_NULL(buf4);
 }
 
+static void test_mem_arena(void)
+{
+    struct mem_arena *arena = NULL;
+
+    arena = mem_arena_create(0);
+    TEST_ASSERT_NULL(arena);
+
+    arena = mem_arena_create(64);
+    TEST_ASSERT_NOT_NULL(arena);
+
+    void *buf = mem_arena_alloc(arena, 0);
+    TEST_ASSERT_NULL(buf);
+
+    char *buf2 = mem_arena_alloc(arena, 3);
+    TEST_ASSERT_NOT_NULL(buf2);
+    TEST_ASSERT_EQUAL_UINT64(0, (uintptr_t)buf2 % 16);
+
+    char *buf3 = mem_arena_alloc(arena, 8);
+    TEST_ASSERT_NOT_NULL(buf3);
+    TEST_ASSERT_EQUAL_UINT64(0, (uintptr_t)buf3 % 16);
+    TEST_ASSERT(buf3 >= buf2 + 16);
+
+    /* Bigger than the first chunk, so the arena has to grow. */
+    char *buf4 = mem_arena_alloc(arena, 1000);
+    TEST_ASSERT_NOT_NULL(buf4);
+    TEST_ASSERT_NOT_NULL(arena->first->next);
+    memset(buf4, 0, 1000);
+
+    /* After a reset we get the same memory back. */
+    mem_arena_reset(arena);
+    TEST_ASSERT_NULL(arena->first->next);
+
+    char *buf5 = mem_arena_alloc(arena, 3);
+    TEST_ASSERT_TRUE(buf5 == buf2);
+
+    mem_arena_destroy(&arena);
+    TEST_ASSERT_NULL(arena);
+}
+
+static void test_mem_arena_init(void)
+{
+    int32_t rtrn = 0;
+    struct mem_arena arena;
+    uint64_t buf[16];
+
+    rtrn = mem_arena_init(&arena, buf, 8);
+    TEST_ASSERT_EQUAL_INT32(-1, rtrn);
+
+    rtrn = mem_arena_init(&arena, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_INT32(0, rtrn);
+
+    /* Allocations come out of the caller's buffer. */
+    char *ptr = mem_arena_alloc(&arena, 16);
+    TEST_ASSERT_TRUE(ptr == mem_arena_base(&arena));
+    TEST_ASSERT_TRUE(ptr > (char *)buf && ptr < (char *)buf + sizeof(buf));
+
+    /* Overflow goes to the heap and is given back on reset. */
+    char *ptr2 = mem_arena_alloc(&arena, 512);
+    TEST_ASSERT_NOT_NULL(ptr2);
+    TEST_ASSERT_NOT_NULL(arena.first->next);
+
+    mem_arena_reset(&arena);
+    TEST_ASSERT_NULL(arena.first->next);
+    TEST_ASSERT_TRUE(mem_arena_alloc(&arena, 16) == ptr);
+}
+
 int main(void)
 {
     test_default_memory_allocator();
 
+    test_mem_arena();
+
+    test_mem_arena_init();
+
 	  return (0);
 }
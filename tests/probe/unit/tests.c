@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+#include "unity.h"
+#include "io/io.h"
+#include "memory/memory.h"
+#include "probe/probe.h"
+#include "runtime/platform.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <linux/kcov.h>
+#include <sys/ioctl.h>
+
+/* A kcov device that only exists in this file. */
+#define FAKE_KCOV_PATH "/fake/kcov"
+#define FAKE_KCOV_FD   42
+
+static uint64_t *fake_cover;
+static int32_t fake_enabled;
+static uint64_t fake_size;
+
+static int32_t fake_open(const char *path)
+{
+    if(strcmp(path, FAKE_KCOV_PATH) != 0)
+    {
+        errno = ENOENT;
+        return (-1);
+    }
+
+    return (FAKE_KCOV_FD);
+}
+
+static int32_t fake_ioctl(int32_t fd, unsigned long request, unsigned long arg)
+{
+    TEST_ASSERT(fd == FAKE_KCOV_FD);
+
+    if(request == KCOV_INIT_TRACE)
+        fake_size = arg;
+    else if(request == KCOV_ENABLE)
+        fake_enabled = (arg == KCOV_TRACE_PC) ? TRUE : FALSE;
+    else if(request == KCOV_DISABLE)
+        fake_enabled = FALSE;
+
+    return (0);
+}
+
+static void *fake_map(int32_t fd, uint64_t size)
+{
+    TEST_ASSERT(fd == FAKE_KCOV_FD);
+    TEST_ASSERT(size == fake_size * sizeof(uint64_t));
+
+    fake_cover = calloc(1, size);
+
+    return (fake_cover);
+}
+
+static void fake_unmap(void *cover, uint64_t size)
+{
+    (void)size;
+
+    TEST_ASSERT(cover == fake_cover);
+
+    free(cover);
+    fake_cover = NULL;
+}
+
+static void fake_close(int32_t fd)
+{
+    TEST_ASSERT(fd == FAKE_KCOV_FD);
+}
+
+static struct kcov_device fake_kcov = {
+
+    .open = &fake_open,
+    .ioctl = &fake_ioctl,
+    .map = &fake_map,
+    .unmap = &fake_unmap,
+    .close = &fake_close
+
+};
+
+/* Pretend the kernel ran through the PCs in pcs. */
+static void fake_trace(const uint64_t *pcs, uint64_t total)
+{
+    memcpy(&fake_cover[1], pcs, total * sizeof(uint64_t));
+    fake_cover[0] = total;
+}
+
+/* Count the edges in trace hit exactly hits times. */
+static uint32_t count_hits(const uint8_t *trace, uint8_t hits)
+{
+    uint32_t i;
+    uint32_t total = 0;
+
+    for(i = 0; i < COVERAGE_MAP_SIZE; i++)
+    {
+        if(trace[i] == hits)
+            total++;
+    }
+
+    return (total);
+}
+
+static void test_kernel_probes(void)
+{
+    int32_t rtrn = 0;
+    uint8_t *trace = NULL;
+    struct probe_ctx *probe = NULL;
+    struct output_writter *output = get_console_writter();
+    struct memory_allocator *allocator = get_default_allocator();
+
+    TEST_ASSERT_NOT_NULL(output);
+    TEST_ASSERT_NOT_NULL(allocator);
+
+    set_kcov_device(&fake_kcov);
+
+    /* A kernel without kcov should be caught up front. */
+    TEST_ASSERT(setenv(KCOV_PATH_ENV, "/fake/missing", 1) == 0);
+    rtrn = check_kernel_probes(output);
+    TEST_ASSERT(rtrn == -1);
+
+    rtrn = inject_kernel_probes(&probe, allocator, output);
+    TEST_ASSERT(rtrn == -1);
+    TEST_ASSERT_NULL(probe);
+
+    TEST_ASSERT(setenv(KCOV_PATH_ENV, FAKE_KCOV_PATH, 1) == 0);
+    rtrn = check_kernel_probes(output);
+    TEST_ASSERT(rtrn == 0);
+
+    rtrn = inject_kernel_probes(&probe, allocator, output);
+    TEST_ASSERT(rtrn == 0);
+    TEST_ASSERT_NOT_NULL(probe);
+    TEST_ASSERT(fake_size == KCOV_COVER_SIZE);
+    TEST_ASSERT(fake_enabled == TRUE);
+
+    trace = calloc(1, COVERAGE_MAP_SIZE);
+    TEST_ASSERT_NOT_NULL(trace);
+
+    const uint64_t pcs[] = {0xffffffff81000010, 0xffffffff81000020, 0xffffffff81000030};
+
+    /* Three PCs, three edges hit once each. */
+    start_kernel_coverage(probe);
+    TEST_ASSERT(fake_cover[0] == 0);
+    fake_trace(pcs, 3);
+    TEST_ASSERT_EQUAL_UINT32(3, collect_kernel_coverage(probe, trace));
+    TEST_ASSERT_EQUAL_UINT32(3, count_hits(trace, 1));
+
+    /* The same path again hits the same edges. */
+    start_kernel_coverage(probe);
+    fake_trace(pcs, 3);
+    TEST_ASSERT_EQUAL_UINT32(3, collect_kernel_coverage(probe, trace));
+    TEST_ASSERT_EQUAL_UINT32(3, count_hits(trace, 2));
+
+    /* No PCs means no hits. */
+    start_kernel_coverage(probe);
+    TEST_ASSERT_EQUAL_UINT32(0, collect_kernel_coverage(probe, trace));
+    TEST_ASSERT_EQUAL_UINT32(3, count_hits(trace, 2));
+
+    rtrn = cleanup_kernel_probes(&probe, allocator);
+    TEST_ASSERT(rtrn == 0);
+    TEST_ASSERT_NULL(probe);
+    TEST_ASSERT(fake_enabled == FALSE);
+    TEST_ASSERT_NULL(fake_cover);
+
+    /* Cleaning up twice is harmless. */
+    rtrn = cleanup_kernel_probes(&probe, allocator);
+    TEST_ASSERT(rtrn == 0);
+
+    set_kcov_device(NULL);
+    free(trace);
+}
+
+int main(void)
+{
+    test_kernel_probes();
+
+    return (0);
+}
@@ -13,11 +13,336 @@
  * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include "unity.h"
+#include "resource/resource.h"
+#include "concurrent/concurrent.h"
+#include "memory/memory.h"
+#include "runtime/platform.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
 #include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+/* Enough for every slot of a pool. */
+#define TOTAL_SLOTS 1024
+
+/* Descriptors each thread holds at once. */
+#define HOLD_COUNT 8
+
+static uint32_t iterations = 10000;
+
+/* Which descriptor pool slots are handed out right now. */
+static int32_t held[TOTAL_SLOTS];
+
+/* Take HOLD_COUNT descriptors and give them back, over and over. No slot may
+   be handed out while another thread holds it. */
+static void take_and_give_back(void)
+{
+    uint32_t i, x;
+    struct resource_handle handles[HOLD_COUNT];
+
+    for(i = 0; i < iterations; i++)
+    {
+        for(x = 0; x < HOLD_COUNT; x++)
+        {
+            TEST_ASSERT(get_desc(&handles[x]) == 0);
+            TEST_ASSERT(handles[x].slot < TOTAL_SLOTS);
+            TEST_ASSERT(atomic_cas_int32(&held[handles[x].slot], FALSE, TRUE) == true);
+        }
+
+        for(x = 0; x < HOLD_COUNT; x++)
+        {
+            atomic_store_int32(&held[handles[x].slot], FALSE);
+            TEST_ASSERT(free_desc(&handles[x]) == 0);
+        }
+    }
+
+    return;
+}
+
+static void *cache_owner(void *arg)
+{
+    (void)arg;
+
+    /* This thread goes through the magazines, nobody else can. */
+    TEST_ASSERT(claim_resource_cache() == 0);
+    TEST_ASSERT(claim_resource_cache() == -1);
+
+    take_and_give_back();
+
+    flush_resource_cache();
+
+    return (NULL);
+}
+
+static void test_resource_cache_threads(void)
+{
+    pthread_t thread;
+
+    TEST_ASSERT(pthread_create(&thread, NULL, &cache_owner, NULL) == 0);
+
+    /* Meanwhile this thread goes straight to the pool. */
+    take_and_give_back();
+
+    /* Flushing a cache we don't own does nothing. */
+    flush_resource_cache();
+
+    TEST_ASSERT(pthread_join(thread, NULL) == 0);
+
+    return;
+}
+
+/* Take resources until the one in slot comes back from the replenisher, then
+   give the others back. */
+static void take_slot(int32_t (*get)(struct resource_handle *),
+                      int32_t (*give)(struct resource_handle *),
+                      uint32_t slot,
+                      struct resource_handle *handle)
+{
+    uint32_t total = 0;
+    static struct resource_handle taken[TOTAL_SLOTS];
+
+    while(1)
+    {
+        TEST_ASSERT(get(handle) == 0);
+        if(handle->slot == slot)
+            break;
+
+        TEST_ASSERT(total < TOTAL_SLOTS);
+        taken[total] = (*handle);
+        total++;
+    }
+
+    while(total > 0)
+    {
+        total--;
+        TEST_ASSERT(give(&taken[total]) == 0);
+    }
+
+    return;
+}
+
+/* Run in a child, the replenisher's descriptor table never sees the close. */
+static int32_t reuse_closed_desc(void)
+{
+    uint32_t slot = 0;
+    struct resource_handle handle;
+
+    if(get_desc(&handle) < 0)
+        return (-1);
+
+    slot = handle.slot;
+    close(handle.fd);
+
+    if(free_desc(&handle) < 0)
+        return (-1);
+
+    take_slot(&get_desc, &free_desc, slot, &handle);
+
+    if(fcntl(handle.fd, F_GETFD) < 0)
+        return (-1);
+
+    return (free_desc(&handle));
+}
+
+static void test_closed_desc_reopened(void)
+{
+    int32_t status = 0;
+
+    pid_t pid = fork();
+    TEST_ASSERT(pid > -1);
+    if(pid == 0)
+        _exit((reuse_closed_desc() == 0) ? 0 : 1);
+
+    TEST_ASSERT(waitpid(pid, &status, 0) == pid);
+    TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    return;
+}
+
+static void test_check_desc(void)
+{
+    struct stat sb;
+    uint32_t slot = 0;
+    struct resource_handle handle;
+
+    TEST_ASSERT(get_desc(&handle) == 0);
+    TEST_ASSERT(ftruncate(handle.fd, 0) == 0);
+
+    slot = handle.slot;
+    TEST_ASSERT(free_desc(&handle) == 0);
+
+    /* The emptied file is replaced before the slot is handed out again. */
+    take_slot(&get_desc, &free_desc, slot, &handle);
+    TEST_ASSERT(fstat(handle.fd, &sb) == 0);
+    TEST_ASSERT(S_ISREG(sb.st_mode));
+    TEST_ASSERT(sb.st_size > 0);
+
+    TEST_ASSERT(free_desc(&handle) == 0);
+
+    return;
+}
+
+static void test_check_filepath(void)
+{
+    struct stat sb;
+    uint32_t slot = 0;
+    struct resource_handle handle;
+
+    TEST_ASSERT(get_filepath(&handle) == 0);
+    TEST_ASSERT(unlink(handle.path) == 0);
+
+    slot = handle.slot;
+    TEST_ASSERT(free_filepath(&handle) == 0);
+
+    take_slot(&get_filepath, &free_filepath, slot, &handle);
+    TEST_ASSERT(stat(handle.path, &sb) == 0);
+    TEST_ASSERT(S_ISREG(sb.st_mode));
+    TEST_ASSERT(sb.st_size > 0);
+
+    TEST_ASSERT(free_filepath(&handle) == 0);
+
+    return;
+}
+
+static void test_reclaim_pool(void)
+{
+    int32_t fds[2];
+    uint32_t slot = 0;
+    int32_t status = 0;
+    struct resource_handle handle;
+
+    TEST_ASSERT(pipe(fds) == 0);
+
+    pid_t pid = fork();
+    TEST_ASSERT(pid > -1);
+    if(pid == 0)
+    {
+        /* Die holding the descriptor. */
+        if(get_desc(&handle) < 0)
+            _exit(1);
+
+        _exit((write(fds[1], &handle.slot, sizeof(handle.slot)) == sizeof(handle.slot)) ? 0 : 1);
+    }
+
+    TEST_ASSERT(read(fds[0], &slot, sizeof(slot)) == sizeof(slot));
+    TEST_ASSERT(waitpid(pid, &status, 0) == pid);
+    TEST_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    close(fds[0]);
+    close(fds[1]);
+
+    /* Only comes back if the replenisher finds the dead owner. */
+    take_slot(&get_desc, &free_desc, slot, &handle);
+    TEST_ASSERT(free_desc(&handle) == 0);
+
+    return;
+}
+
+/* A path handle points into it's pool block, right after the resource context. */
+static void check_path_handle(struct resource_handle *handle, enum resource_type type)
+{
+    struct resource_ctx *resource = (struct resource_ctx *)(handle->path - sizeof(struct resource_ctx));
+
+    TEST_ASSERT(handle->type == type);
+    TEST_ASSERT(handle->slot < TOTAL_SLOTS);
+    TEST_ASSERT(resource->m_blk->index == handle->slot);
+    TEST_ASSERT(resource->owner == getpid());
+
+    return;
+}
+
+static void test_handle_slot(void)
+{
+    uint32_t i;
+    struct resource_handle handle;
+    static int32_t slot_fd[TOTAL_SLOTS];
+
+    TEST_ASSERT(get_filepath(&handle) == 0);
+    check_path_handle(&handle, RESOURCE_FILEPATH);
+    TEST_ASSERT(free_filepath(&handle) == 0);
+
+    TEST_ASSERT(get_dirpath(&handle) == 0);
+    check_path_handle(&handle, RESOURCE_DIRPATH);
+    TEST_ASSERT(free_dirpath(&handle) == 0);
+
+    /* A descriptor keeps it's number for as long as it's in the pool, so
+       every handle for a slot has to carry the same one. */
+    for(i = 0; i < TOTAL_SLOTS; i++)
+        slot_fd[i] = -1;
+
+    for(i = 0; i < TOTAL_SLOTS * 2; i++)
+    {
+        TEST_ASSERT(get_desc(&handle) == 0);
+        TEST_ASSERT(handle.type == RESOURCE_DESC);
+        TEST_ASSERT(handle.slot < TOTAL_SLOTS);
+
+        if(slot_fd[handle.slot] == -1)
+            slot_fd[handle.slot] = handle.fd;
+
+        TEST_ASSERT(slot_fd[handle.slot] == handle.fd);
+        TEST_ASSERT(free_desc(&handle) == 0);
+    }
+
+    return;
+}
+
+static void test_double_free(void)
+{
+    struct resource_handle handle;
+
+    TEST_ASSERT(get_desc(&handle) == 0);
+    TEST_ASSERT(free_desc(&handle) == 0);
+    TEST_ASSERT(handle.slot == RESOURCE_NO_SLOT);
+    TEST_ASSERT(free_desc(&handle) == -1);
+
+    TEST_ASSERT(get_filepath(&handle) == 0);
+    TEST_ASSERT(free_filepath(&handle) == 0);
+    TEST_ASSERT(free_filepath(&handle) == -1);
+
+    return;
+}
+
+static void test_wrong_type_free(void)
+{
+    uint32_t slot = 0;
+    struct resource_handle handle;
+
+    TEST_ASSERT(get_desc(&handle) == 0);
+    slot = handle.slot;
+
+    /* Rejected without touching the handle, so the right free still works. */
+    TEST_ASSERT(free_socket(&handle) == -1);
+    TEST_ASSERT(free_filepath(&handle) == -1);
+    TEST_ASSERT(handle.slot == slot);
+    TEST_ASSERT(free_desc(&handle) == 0);
+
+    TEST_ASSERT(get_dirpath(&handle) == 0);
+    TEST_ASSERT(free_filepath(&handle) == -1);
+    TEST_ASSERT(free_dirpath(&handle) == 0);
+
+    return;
+}
 
 int main(void)
 {
+    char path[] = "/tmp/nextgen_resource_XXXXXX";
+
+    TEST_ASSERT_NOT_NULL(mkdtemp(path));
+    TEST_ASSERT(setup_resource_module(CACHE, path) == 0);
+
+    test_resource_cache_threads();
+    test_handle_slot();
+    test_double_free();
+    test_wrong_type_free();
+    test_closed_desc_reopened();
+    test_check_desc();
+    test_check_filepath();
+    test_reclaim_pool();
 
+    TEST_ASSERT(cleanup_resource_module() == 0);
 
 	  _exit(0);
 }
@@ -0,0 +1,202 @@
+/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+
+#include "unity.h"
+#include "io/io.h"
+#include "memory/memory.h"
+#include "syscall/select.h"
+#include "syscall/entry.h"
+#include <unistd.h>
+
+/* Pick with every possible random number and count how often each entry comes up. */
+static void draw_all(struct alias_table *table, uint64_t *counts)
+{
+    uint64_t number;
+
+    for(number = 0; number < (uint64_t)table->total * ALIAS_SCALE; number++)
+        counts[alias_table_draw(table, (uint32_t)number)]++;
+}
+
+static void test_alias_table(void)
+{
+    int32_t rtrn = 0;
+    struct alias_table table;
+    struct output_writter *output = get_console_writter();
+    struct memory_allocator *allocator = get_default_allocator();
+
+    TEST_ASSERT_NOT_NULL(output);
+    TEST_ASSERT_NOT_NULL(allocator);
+
+    memset(&table, 0, sizeof(struct alias_table));
+
+    rtrn = alias_table_init(&table, 0, allocator, output);
+    TEST_ASSERT(rtrn == -1);
+
+    rtrn = alias_table_init(&table, ALIAS_SCALE, allocator, output);
+    TEST_ASSERT(rtrn == -1);
+
+    rtrn = alias_table_init(&table, 4, allocator, output);
+    TEST_ASSERT(rtrn == 0);
+
+    /* Before the first build every entry is as likely as the others. */
+    uint64_t even[4] = {0};
+    draw_all(&table, even);
+    TEST_ASSERT_EQUAL_UINT64(ALIAS_SCALE, even[0]);
+    TEST_ASSERT_EQUAL_UINT64(ALIAS_SCALE, even[3]);
+
+    double none[4] = {0.0, 0.0, 0.0, 0.0};
+    rtrn = alias_table_build(&table, none);
+    TEST_ASSERT(rtrn == -1);
+
+    /* Every random number maps to an entry in proportion to it's weight,
+       entries without weight never come up. */
+    double weights[4] = {1.0, 0.0, 3.0, 0.0};
+    rtrn = alias_table_build(&table, weights);
+    TEST_ASSERT(rtrn == 0);
+
+    uint64_t counts[4] = {0};
+    draw_all(&table, counts);
+    TEST_ASSERT_EQUAL_UINT64(ALIAS_SCALE, counts[0]);
+    TEST_ASSERT_EQUAL_UINT64(0, counts[1]);
+    TEST_ASSERT_EQUAL_UINT64(3 * ALIAS_SCALE, counts[2]);
+    TEST_ASSERT_EQUAL_UINT64(0, counts[3]);
+
+    /* Weights that don't split evenly still cover every number exactly once. */
+    double uneven[4] = {0.1, 7.0, 0.0, 2.5};
+    rtrn = alias_table_build(&table, uneven);
+    TEST_ASSERT(rtrn == 0);
+
+    uint64_t counts2[4] = {0};
+    draw_all(&table, counts2);
+    TEST_ASSERT_EQUAL_UINT64(0, counts2[2]);
+    TEST_ASSERT_EQUAL_UINT64(4 * ALIAS_SCALE, counts2[0] + counts2[1] + counts2[3]);
+    TEST_ASSERT(counts2[1] > counts2[3]);
+    TEST_ASSERT(counts2[3] > counts2[0]);
+    TEST_ASSERT(counts2[0] > 0);
+
+    alias_table_cleanup(&table, allocator);
+}
+
+static struct syscall_entry entry_a = { .syscall_name = "a", .status = ON, .requires_root = NX_NO,
+                                        .groups = SYSCALL_GROUP(GROUP_FS) };
+
+static struct syscall_entry entry_b = { .syscall_name = "b", .status = ON, .requires_root = NX_NO,
+                                        .groups = SYSCALL_GROUP(GROUP_NET) };
+
+static struct syscall_entry entry_c = { .syscall_name = "c", .status = OFF, .requires_root = NX_NO,
+                                        .groups = SYSCALL_GROUP(GROUP_FS) };
+
+static struct syscall_entry entry_d = { .syscall_name = "d", .status = ON, .requires_root = NX_NO,
+                                        .groups = SYSCALL_GROUP(GROUP_IPC) };
+
+static struct syscall_entry *const test_entries[] = { &entry_a, &entry_b, &entry_c, &entry_d };
+
+static struct syscall_table test_table = { .total_syscalls = 4, .sys_entry = test_entries };
+
+/* Run a selection against the test table, starting from it's default statuses. */
+static int32_t select_from_test_table(const char *enable, const char *disable, const char *groups, const char *weights)
+{
+    struct syscall_selection selection = { enable, disable, groups, weights };
+
+    entry_a.status = ON;
+    entry_b.status = ON;
+    entry_c.status = OFF;
+    entry_d.status = ON;
+
+    return (setup_syscall_selection(&test_table, &selection, get_default_allocator(), get_console_writter()));
+}
+
+static void test_syscall_selection(void)
+{
+    int32_t rtrn = 0;
+
+    /* By default everything that's on runs. */
+    rtrn = setup_syscall_selection(&test_table, NULL, get_default_allocator(), get_console_writter());
+    TEST_ASSERT(rtrn == 0);
+    TEST_ASSERT_EQUAL_UINT32(3, get_total_active());
+
+    /* A group keeps entries that start off turned off. */
+    rtrn = select_from_test_table(NULL, NULL, "fs", NULL);
+    TEST_ASSERT(rtrn == 0);
+    TEST_ASSERT_EQUAL_UINT32(1, get_total_active());
+    TEST_ASSERT(entry_a.status == ON);
+    TEST_ASSERT(entry_b.status == OFF);
+    TEST_ASSERT(entry_c.status == OFF);
+
+    /* Enabled syscalls are added to the groups, even ones that start off. */
+    rtrn = select_from_test_table("c", NULL, "net,ipc", NULL);
+    TEST_ASSERT(rtrn == 0);
+    TEST_ASSERT_EQUAL_UINT32(3, get_total_active());
+    TEST_ASSERT(entry_a.status == OFF);
+    TEST_ASSERT(entry_c.status == ON);
+
+    /* Disabling and a weight of zero both take a syscall out. */
+    rtrn = select_from_test_table(NULL, "a", NULL, "b=0,d=2.5");
+    TEST_ASSERT(rtrn == 0);
+    TEST_ASSERT_EQUAL_UINT32(1, get_total_active());
+    TEST_ASSERT(entry_a.status == OFF);
+
+    rtrn = select_from_test_table(NULL, "a,b,d", NULL, NULL);
+    TEST_ASSERT(rtrn == -1);
+
+    rtrn = select_from_test_table(NULL, NULL, "fs,nope", NULL);
+    TEST_ASSERT(rtrn == -1);
+
+    rtrn = select_from_test_table("nope", NULL, NULL, NULL);
+    TEST_ASSERT(rtrn == -1);
+
+    rtrn = select_from_test_table(NULL, NULL, NULL, "a=-1");
+    TEST_ASSERT(rtrn == -1);
+
+    rtrn = select_from_test_table(NULL, NULL, NULL, "a");
+    TEST_ASSERT(rtrn == -1);
+}
+
+static struct syscall_entry entry_user = { .syscall_name = "user", .status = ON, .requires_root = NX_NO };
+
+static struct syscall_entry entry_root = { .syscall_name = "root", .status = ON, .requires_root = NX_YES };
+
+static struct syscall_entry *const root_entries[] = { &entry_user, &entry_root };
+
+static struct syscall_table root_table = { .total_syscalls = 2, .sys_entry = root_entries };
+
+static void test_root_selection(void)
+{
+    int32_t rtrn = 0;
+
+    rtrn = setup_syscall_selection(&root_table, NULL, get_default_allocator(), get_console_writter());
+    TEST_ASSERT(rtrn == 0);
+
+    /* Syscalls that need root only run as root. */
+    if(geteuid() == 0)
+    {
+        TEST_ASSERT_EQUAL_UINT32(2, get_total_active());
+    }
+    else
+    {
+        TEST_ASSERT_EQUAL_UINT32(1, get_total_active());
+    }
+}
+
+int main(void)
+{
+    test_alias_table();
+
+    test_syscall_selection();
+
+    test_root_selection();
+
+    return (0);
+}
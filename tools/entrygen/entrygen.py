@@ -0,0 +1,400 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+#
+# Permission to use, copy, modify, and/or distribute this software for any purpose
+# with or without fee is hereby granted, provided that the above copyright notice
+# and this permission notice appear in all copies.
+#
+# THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+# REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+# AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+# CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+# WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+# OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+#
+
+"""Generate nextgen's Linux syscall entries.
+
+Reads the syscall numbers from asm/unistd_64.h, the parameters of each syscall
+from a file of kernel style prototypes (tools/entrygen/linux_x86_64.h or the
+kernel's include/linux/syscalls.h) and how to fuzz them from an annotation file.
+Writes src/syscall/linux/entry_<name>.c for every syscall, the externs in
+src/syscall/linux/syscall_list.h and the table in src/syscall/linux_syscall_table.h.
+
+Run it from anywhere, the defaults point at the files in the repo:
+
+    tools/entrygen/entrygen.py [--unistd PATH] [--prototypes PATH]
+                               [--annotations PATH] [--out DIR]
+"""
+
+import argparse
+import os
+import re
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.normpath(os.path.join(HERE, "..", ".."))
+
+# Marks files we wrote so stale ones can be removed on the next run.
+GENERATED = "/* Generated by tools/entrygen/entrygen.py, edit tools/entrygen/linux.annotations instead. */"
+
+ARG_NAMES = ["FIRST_ARG", "SECOND_ARG", "THIRD_ARG", "FOURTH_ARG", "FIFTH_ARG", "SIXTH_ARG"]
+
+# Group names in the annotations and the enum syscall_group value for each.
+GROUPS = {"fs": "GROUP_FS", "net": "GROUP_NET", "ipc": "GROUP_IPC", "mm": "GROUP_MM", "proc": "GROUP_PROC"}
+
+LICENSE = """/**
+ * Copyright (c) 2016, Harrison Bowden, Minneapolis, MN
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose
+ * with or without fee is hereby granted, provided that the above copyright notice
+ * and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT
+ * OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ **/
+"""
+
+
+class GenError(Exception):
+    pass
+
+
+class Param:
+    def __init__(self, decl):
+        self.decl = " ".join(decl.split())
+        m = re.match(r"^(.*?)(\w+)\s*$", self.decl)
+        if m is None or m.group(1).strip() == "":
+            raise GenError("can't parse parameter '%s'" % decl)
+        self.name = m.group(2)
+        self.ctype = normalize_ctype(m.group(1))
+        self.pointer = "*" in self.ctype
+
+
+class Syscall:
+    def __init__(self, name, number):
+        self.name = name
+        self.number = number
+        self.proto = None
+        self.params = []
+        self.status = "ON"
+        self.root = False
+        self.alarm = False
+        self.timeout = 0
+        self.returns = None
+        self.overrides = {}
+        self.types = []
+        self.groups = []
+
+
+class Annotations:
+    def __init__(self):
+        self.types = {}
+        self.value_params = {}
+        self.pointer_params = {}
+        self.ctypes = {}
+        self.aliases = {}
+        self.skip = set()
+        self.options = {}
+        self.groups = {}
+
+
+def normalize_ctype(ctype):
+    """Drop qualifiers and space the stars so types compare as strings."""
+    words = ctype.replace("*", " * ").split()
+    words = [w for w in words if w not in ("__user", "const", "volatile")]
+    return " ".join(words)
+
+
+def parse_unistd(path):
+    numbers = {}
+    with open(path) as f:
+        for line in f:
+            m = re.match(r"^#define\s+__NR_(\w+)\s+(\d+)", line)
+            if m:
+                numbers[m.group(1)] = int(m.group(2))
+    if not numbers:
+        raise GenError("%s: no __NR_ defines found" % path)
+    return numbers
+
+
+def parse_prototypes(path):
+    with open(path) as f:
+        text = f.read()
+
+    # Comments and preprocessor lines would otherwise end up in parameters.
+    text = re.sub(r"/\*.*?\*/", " ", text, flags=re.S)
+    text = re.sub(r"//[^\n]*", " ", text)
+    text = re.sub(r"^\s*#[^\n]*", " ", text, flags=re.M)
+
+    protos = {}
+    for m in re.finditer(r"asmlinkage\s+long\s+sys_(\w+)\s*\(([^;]*?)\)\s*;", text):
+        name, args = m.group(1), " ".join(m.group(2).split())
+        # syscalls.h declares some syscalls once per config, the first wins.
+        if name in protos:
+            continue
+        params = []
+        if args not in ("", "void"):
+            params = [Param(a) for a in args.split(",")]
+        protos[name] = ("long sys_%s(%s);" % (name, args), params)
+    if not protos:
+        raise GenError("%s: no prototypes found" % path)
+    return protos
+
+
+def parse_annotations(path):
+    notes = Annotations()
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].strip()
+            if line == "":
+                continue
+            where = "%s:%d" % (path, lineno)
+            words = line.split()
+            kind = words[0]
+
+            if kind == "type" and len(words) in (3, 4):
+                if len(words) == 4 and words[3] != "ptr":
+                    raise GenError("%s: expected 'ptr', got '%s'" % (where, words[3]))
+                notes.types[words[1]] = (words[2], len(words) == 4)
+
+            elif kind in ("param", "ctype") and "=" in line:
+                match, arg_type = [s.strip() for s in line[len(kind):].split("=", 1)]
+                if kind == "ctype":
+                    notes.ctypes[normalize_ctype(match)] = arg_type
+                elif match.startswith("*"):
+                    notes.pointer_params[match[1:].strip()] = arg_type
+                else:
+                    notes.value_params[match] = arg_type
+
+            elif kind == "alias" and len(words) == 3:
+                notes.aliases[words[1]] = words[2]
+
+            elif kind == "skip" and len(words) > 1:
+                notes.skip.update(words[1:])
+
+            elif kind == "group" and len(words) > 2:
+                if words[1] not in GROUPS:
+                    raise GenError("%s: unknown group '%s'" % (where, words[1]))
+                for name in words[2:]:
+                    notes.groups.setdefault(name, []).append(GROUPS[words[1]])
+
+            elif kind == "syscall" and len(words) > 1:
+                notes.options.setdefault(words[1], []).extend((where, o) for o in words[2:])
+
+            else:
+                raise GenError("%s: can't parse '%s'" % (where, line))
+
+    for name in ("VOID_BUF", "INT"):
+        if name not in notes.types:
+            raise GenError("%s: the fallback type %s needs a type line" % (path, name))
+
+    return notes
+
+
+def apply_options(call, notes):
+    for where, option in notes.options.get(call.name, []):
+        if option == "off":
+            call.status = "OFF"
+        elif option == "root":
+            call.root = True
+        elif option == "alarm":
+            call.alarm = True
+        elif option.startswith("timeout="):
+            call.timeout = int(option.split("=", 1)[1])
+        elif option.startswith("returns="):
+            call.returns = option.split("=", 1)[1]
+        elif "=" in option:
+            param, arg_type = option.split("=", 1)
+            if param not in [p.name for p in call.params]:
+                raise GenError("%s: %s has no parameter '%s'" % (where, call.name, param))
+            call.overrides[param] = arg_type
+        else:
+            raise GenError("%s: unknown option '%s'" % (where, option))
+
+    if call.timeout != 0 and not call.alarm:
+        raise GenError("%s: timeout without alarm" % call.name)
+
+
+def pick_type(call, param, notes):
+    if param.name in call.overrides:
+        return call.overrides[param.name]
+
+    params = notes.pointer_params if param.pointer else notes.value_params
+    if param.name in params:
+        return params[param.name]
+
+    if param.ctype in notes.ctypes:
+        return notes.ctypes[param.ctype]
+
+    return "VOID_BUF" if param.pointer else "INT"
+
+
+def build_syscalls(numbers, protos, notes):
+    for name in list(notes.options) + list(notes.groups):
+        if name not in numbers:
+            raise GenError("annotations name unknown syscall '%s'" % name)
+
+    calls = []
+    missing = []
+    for name, number in sorted(numbers.items(), key=lambda item: item[1]):
+        if name in notes.skip:
+            continue
+
+        proto = protos.get(notes.aliases.get(name, name))
+        if proto is None:
+            missing.append(name)
+            continue
+
+        call = Syscall(name, number)
+        call.proto, call.params = proto
+        if len(call.params) > len(ARG_NAMES):
+            raise GenError("%s takes more than %d arguments" % (name, len(ARG_NAMES)))
+
+        apply_options(call, notes)
+        call.groups = notes.groups.get(name, [])
+
+        for param in call.params:
+            arg_type = pick_type(call, param, notes)
+            if arg_type not in notes.types:
+                raise GenError("%s: no generator for %s" % (name, arg_type))
+            call.types.append(arg_type)
+
+        if call.returns is not None and call.returns not in notes.types:
+            raise GenError("%s: unknown return type %s" % (name, call.returns))
+
+        calls.append(call)
+
+    # Every syscall has to be generated or skipped on purpose.
+    if missing:
+        raise GenError("no prototype for: %s" % " ".join(missing))
+
+    return calls
+
+
+def render_entry(call, notes):
+    ptr_args = [ARG_NAMES[i] for i, t in enumerate(call.types) if notes.types[t][1]]
+
+    lines = [LICENSE, GENERATED, "", '#include "syscall_list.h"', "",
+             "#ifdef SYS_%s" % call.name, "", "/* %s */" % call.proto,
+             "struct syscall_entry entry_%s = {" % call.name, "",
+             '    .syscall_name = "%s",' % call.name,
+             "    .syscall_symbol = SYS_%s," % call.name,
+             "    .total_args = %d," % len(call.params),
+             "    .status = %s," % call.status,
+             "    .requires_root = %s," % ("NX_YES" if call.root else "NX_NO"),
+             "    .need_alarm = %s," % ("NX_YES" if call.alarm else "NX_NO")]
+
+    if call.timeout != 0:
+        lines.append("    .timeout_us = %d," % call.timeout)
+
+    if call.returns is not None:
+        lines.append("    .ret_type = %s," % call.returns)
+        lines.append("    .returns_resource = true,")
+
+    if call.groups:
+        lines.append("    .groups = %s," % " | ".join("SYSCALL_GROUP(%s)" % g for g in call.groups))
+
+    lines.append("    .ptr_args = %s," % (" | ".join("ARG_PTR(%s)" % a for a in ptr_args) or "0"))
+
+    for i, (param, arg_type) in enumerate(zip(call.params, call.types)):
+        lines.append("")
+        lines.append("    /* %s */" % param.decl)
+        lines.append("    .arg_type_array[%s] = %s," % (ARG_NAMES[i], arg_type))
+        lines.append("    .get_arg_array[%s] = &%s," % (ARG_NAMES[i], notes.types[arg_type][0]))
+
+    # No trailing comma on the last initializer, like the hand written entries.
+    lines[-1] = lines[-1].rstrip(",")
+    lines += ["};", "", "#endif", ""]
+
+    return "\n".join(lines)
+
+
+def render_list(calls):
+    lines = [LICENSE, GENERATED, "", "#ifndef SYSCALL_LIST_H", "#define SYSCALL_LIST_H", "",
+             '#include "../arg_types.h"', '#include "../entry.h"', '#include "../generate.h"', "",
+             "#include <sys/syscall.h>", "",
+             "/* Linux's system call list. This file declares all the syscalls entries",
+             "on the Linux platform. These syscall entries tell us how to fuzz each syscall on the system.  */",
+             ""]
+    for call in calls:
+        lines.append("extern struct syscall_entry entry_%s;" % call.name)
+    lines += ["", "#endif", ""]
+
+    return "\n".join(lines)
+
+
+def render_table(calls):
+    lines = [LICENSE, GENERATED, "", "#ifndef LINUX_SYSCALL_TABLE_H", "#define LINUX_SYSCALL_TABLE_H", "",
+             '#include "syscall_list.h"', '#include "syscall_table.h"', "",
+             "/* Entries in syscall number order, syscalls the libc headers",
+             "  don't know about are left out so the table stays dense. */",
+             "static struct syscall_entry *const linux_entries[] = {", ""]
+    for call in calls:
+        lines += ["#ifdef SYS_%s" % call.name, "    &entry_%s," % call.name, "#endif"]
+    lines += ["};", "",
+              "struct syscall_table linux_syscall_table = {", "",
+              "    .total_syscalls = sizeof(linux_entries) / sizeof(linux_entries[0]),",
+              "    .sys_entry = linux_entries",
+              "};", "", "#endif", ""]
+
+    return "\n".join(lines)
+
+
+def write_file(path, text):
+    # Leave files alone when nothing changed so the build doesn't redo them.
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == text:
+                return
+    with open(path, "w") as f:
+        f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate nextgen's Linux syscall entries.")
+    parser.add_argument("--unistd", default="/usr/include/x86_64-linux-gnu/asm/unistd_64.h")
+    parser.add_argument("--prototypes", default=os.path.join(HERE, "linux_x86_64.h"))
+    parser.add_argument("--annotations", default=os.path.join(HERE, "linux.annotations"))
+    parser.add_argument("--out", default=os.path.join(ROOT, "src", "syscall"))
+    args = parser.parse_args()
+
+    try:
+        numbers = parse_unistd(args.unistd)
+        protos = parse_prototypes(args.prototypes)
+        notes = parse_annotations(args.annotations)
+        calls = build_syscalls(numbers, protos, notes)
+    except (GenError, OSError, ValueError) as err:
+        print("entrygen: %s" % err, file=sys.stderr)
+        return 1
+
+    entry_dir = os.path.join(args.out, "linux")
+    wanted = set()
+    for call in calls:
+        name = "entry_%s.c" % call.name
+        wanted.add(name)
+        write_file(os.path.join(entry_dir, name), render_entry(call, notes))
+
+    # Remove entries we generated before for syscalls that are now skipped.
+    for name in os.listdir(entry_dir):
+        path = os.path.join(entry_dir, name)
+        if name.startswith("entry_") and name.endswith(".c") and name not in wanted:
+            with open(path) as f:
+                if GENERATED in f.read():
+                    os.remove(path)
+
+    write_file(os.path.join(entry_dir, "syscall_list.h"), render_list(calls))
+    write_file(os.path.join(args.out, "linux_syscall_table.h"), render_table(calls))
+
+    print("entrygen: %d syscalls, %d skipped" % (len(calls), len(numbers) - len(calls)))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())